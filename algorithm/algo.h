@@ -0,0 +1,346 @@
+#ifndef ALGORITHM_ALGO_H_
+#define ALGORITHM_ALGO_H_
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include "algobase.h"
+#include "iterator.h"
+
+namespace sgi {
+
+template <typename InputIter, typename Function>
+inline Function for_each(InputIter first, InputIter last, Function f) {
+  for (; first != last; ++first) {
+    f(*first);
+  }
+  return f;
+}
+
+template <typename InputIter, typename OutputIter, typename UnaryOperation>
+inline OutputIter transform(InputIter first, InputIter last,
+                            OutputIter result, UnaryOperation op) {
+  for (; first != last; ++first, ++result) {
+    *result = op(*first);
+  }
+  return result;
+}
+
+template <typename InputIter, typename Predicate>
+inline InputIter find_if(InputIter first, InputIter last, Predicate pred) {
+  while (first != last && !pred(*first)) {
+    ++first;
+  }
+  return first;
+}
+
+// Contiguous ranges of int32_t, uint8_t or float are searched with the simd
+// kernels, as are they counted by count.
+template <typename InputIter, typename T>
+inline InputIter find(InputIter first, InputIter last, const T& value) {
+  using type = std::remove_const_t<contiguous_element_t<InputIter>>;
+  if constexpr (is_simd_search_key_v<type, T>) {
+    size_t n = static_cast<size_t>(last - first);
+    type key;
+    if (n == 0 || !sgi::to_search_key(value, &key)) {
+      return last;
+    }
+    return first + simd::ActiveSearchKernels<type>().find(
+                       sgi::to_address(first), n, key);
+  } else {
+    while (first != last && !(*first == value)) {
+      ++first;
+    }
+    return first;
+  }
+}
+
+template <typename InputIter, typename Predicate>
+inline typename iterator_traits<InputIter>::difference_type count_if(
+    InputIter first, InputIter last, Predicate pred) {
+  typename iterator_traits<InputIter>::difference_type n = 0;
+  for (; first != last; ++first) {
+    if (pred(*first)) {
+      n++;
+    }
+  }
+  return n;
+}
+
+template <typename InputIter, typename T>
+inline typename iterator_traits<InputIter>::difference_type count(
+    InputIter first, InputIter last, const T& value) {
+  using Distance = typename iterator_traits<InputIter>::difference_type;
+  using type = std::remove_const_t<contiguous_element_t<InputIter>>;
+  if constexpr (is_simd_search_key_v<type, T>) {
+    size_t n = static_cast<size_t>(last - first);
+    type key;
+    if (n == 0 || !sgi::to_search_key(value, &key)) {
+      return 0;
+    }
+    return static_cast<Distance>(simd::ActiveSearchKernels<type>().count(
+        sgi::to_address(first), n, key));
+  } else {
+    Distance n = 0;
+    for (; first != last; ++first) {
+      if (*first == value) {
+        n++;
+      }
+    }
+    return n;
+  }
+}
+
+// Folds [first, last) into init with op, which, unlike for accumulate, may be
+// applied in any order and grouping, so must be associative and commutative.
+template <typename InputIter, typename T, typename BinaryOperation>
+inline T reduce(InputIter first, InputIter last, T init, BinaryOperation op) {
+  for (; first != last; ++first) {
+    init = op(std::move(init), *first);
+  }
+  return init;
+}
+
+template <typename InputIter, typename T>
+inline T reduce(InputIter first, InputIter last, T init) {
+  return sgi::reduce(first, last, std::move(init), std::plus<>());
+}
+
+template <typename InputIter>
+inline typename iterator_traits<InputIter>::value_type reduce(
+    InputIter first, InputIter last) {
+  return sgi::reduce(first, last,
+                     typename iterator_traits<InputIter>::value_type());
+}
+
+// The first least element of [first, last), or last if it is empty.
+template <typename ForwardIter, typename Compare>
+inline ForwardIter min_element(ForwardIter first, ForwardIter last,
+                               Compare comp) {
+  if (first == last) {
+    return last;
+  }
+  ForwardIter result = first;
+  while (++first != last) {
+    if (comp(*first, *result)) {
+      result = first;
+    }
+  }
+  return result;
+}
+
+template <typename ForwardIter, typename Compare>
+inline ForwardIter max_element(ForwardIter first, ForwardIter last,
+                               Compare comp) {
+  if (first == last) {
+    return last;
+  }
+  ForwardIter result = first;
+  while (++first != last) {
+    if (comp(*result, *first)) {
+      result = first;
+    }
+  }
+  return result;
+}
+
+// Finds the least, or greatest, value of a contiguous range of int32_t,
+// uint8_t or float with the simd kernels, then its first occurrence. NaNs,
+// which the kernels leave to the comparison loop, order as it orders them.
+template <bool Max, typename ForwardIter>
+inline ForwardIter extremum_element(ForwardIter first, ForwardIter last) {
+  using type = std::remove_const_t<contiguous_element_t<ForwardIter>>;
+  if constexpr (is_simd_searchable_v<type>) {
+    size_t n = static_cast<size_t>(last - first);
+    const simd::SearchKernels<type>& kernels =
+        simd::ActiveSearchKernels<type>();
+    type value;
+    if (n != 0 && (Max ? kernels.max : kernels.min)(sgi::to_address(first), n,
+                                                    &value)) {
+      return sgi::find(first, last, value);
+    }
+  }
+  if constexpr (Max) {
+    return sgi::max_element(first, last, std::less<>());
+  } else {
+    return sgi::min_element(first, last, std::less<>());
+  }
+}
+
+template <typename ForwardIter>
+inline ForwardIter min_element(ForwardIter first, ForwardIter last) {
+  return sgi::extremum_element<false>(first, last);
+}
+
+template <typename ForwardIter>
+inline ForwardIter max_element(ForwardIter first, ForwardIter last) {
+  return sgi::extremum_element<true>(first, last);
+}
+
+// Partitions shorter than this are left to insertion_sort.
+inline constexpr ptrdiff_t SORT_THRESHOLD = 16;
+
+template <typename RandomIter, typename Compare>
+inline void insertion_sort(RandomIter first, RandomIter last, Compare comp) {
+  if (first == last) {
+    return;
+  }
+  for (RandomIter i = first + 1; i != last; ++i) {
+    auto value = std::move(*i);
+    if (comp(value, *first)) {
+      sgi::move_backward(first, i, i + 1);
+      *first = std::move(value);
+    } else {
+      // *first stops the loop
+      RandomIter hole = i;
+      for (RandomIter prev = i - 1; comp(value, *prev); --prev) {
+        *hole = std::move(*prev);
+        hole = prev;
+      }
+      *hole = std::move(value);
+    }
+  }
+}
+
+// Sifts the hole at index hole down to a leaf of the heap of len elements at
+// first, then value up from there.
+template <typename RandomIter, typename Distance, typename T,
+          typename Compare>
+inline void adjust_heap(RandomIter first, Distance hole, Distance len,
+                        T value, Compare comp) {
+  Distance top = hole;
+  Distance child = 2 * hole + 2;
+  while (child < len) {
+    if (comp(first[child], first[child - 1])) {
+      child--;
+    }
+    first[hole] = std::move(first[child]);
+    hole = child;
+    child = 2 * child + 2;
+  }
+  if (child == len) {
+    first[hole] = std::move(first[child - 1]);
+    hole = child - 1;
+  }
+  Distance parent = (hole - 1) / 2;
+  while (hole > top && comp(first[parent], value)) {
+    first[hole] = std::move(first[parent]);
+    hole = parent;
+    parent = (hole - 1) / 2;
+  }
+  first[hole] = std::move(value);
+}
+
+template <typename RandomIter, typename Compare>
+inline void heap_sort(RandomIter first, RandomIter last, Compare comp) {
+  using Distance = typename iterator_traits<RandomIter>::difference_type;
+  Distance len = last - first;
+  if (len < 2) {
+    return;
+  }
+  for (Distance parent = (len - 2) / 2;; parent--) {
+    adjust_heap(first, parent, len, std::move(first[parent]), comp);
+    if (parent == 0) {
+      break;
+    }
+  }
+  for (; len > 1; len--) {
+    auto value = std::move(first[len - 1]);
+    first[len - 1] = std::move(*first);
+    adjust_heap(first, Distance(0), len - 1, std::move(value), comp);
+  }
+}
+
+// Moves the median of *a, *b and *c to *result.
+template <typename RandomIter, typename Compare>
+inline void move_median_to_first(RandomIter result, RandomIter a,
+                                 RandomIter b, RandomIter c, Compare comp) {
+  using std::swap;
+  if (comp(*a, *b)) {
+    if (comp(*b, *c)) {
+      swap(*result, *b);
+    } else if (comp(*a, *c)) {
+      swap(*result, *c);
+    } else {
+      swap(*result, *a);
+    }
+  } else if (comp(*a, *c)) {
+    swap(*result, *a);
+  } else if (comp(*b, *c)) {
+    swap(*result, *c);
+  } else {
+    swap(*result, *b);
+  }
+}
+
+// Splits [first, last) around *first, the median of three of its elements,
+// and returns where the upper part starts. Those elements bound the scans.
+template <typename RandomIter, typename Compare>
+inline RandomIter partition_pivot(RandomIter first, RandomIter last,
+                                  Compare comp) {
+  using std::swap;
+  move_median_to_first(first, first + 1, first + (last - first) / 2,
+                       last - 1, comp);
+  RandomIter pivot = first;
+  ++first;
+  while (true) {
+    while (comp(*first, *pivot)) {
+      ++first;
+    }
+    --last;
+    while (comp(*pivot, *last)) {
+      --last;
+    }
+    if (!(first < last)) {
+      return first;
+    }
+    swap(*first, *last);
+    ++first;
+  }
+}
+
+// 2 * log2(n), past which introsort gives up on quicksort.
+inline int sort_depth_limit(ptrdiff_t n) {
+  int depth = 0;
+  for (; n > 1; n >>= 1) {
+    depth += 2;
+  }
+  return depth;
+}
+
+template <typename RandomIter, typename Compare>
+inline void introsort_loop(RandomIter first, RandomIter last, int depth_limit,
+                           Compare comp) {
+  while (last - first > SORT_THRESHOLD) {
+    if (depth_limit == 0) {
+      heap_sort(first, last, comp);
+      return;
+    }
+    depth_limit--;
+    RandomIter cut = partition_pivot(first, last, comp);
+    introsort_loop(cut, last, depth_limit, comp);
+    last = cut;
+  }
+}
+
+// Introsort: quicksort on the median of three, heapsort once it recurses too
+// deep, and a final insertion sort over the small partitions left behind.
+// Not stable.
+template <typename RandomIter, typename Compare>
+inline void sort(RandomIter first, RandomIter last, Compare comp) {
+  if (first == last) {
+    return;
+  }
+  introsort_loop(first, last, sort_depth_limit(last - first), comp);
+  insertion_sort(first, last, comp);
+}
+
+template <typename RandomIter>
+inline void sort(RandomIter first, RandomIter last) {
+  sgi::sort(first, last, std::less<>());
+}
+
+}  // namespace sgi
+
+#endif  // ALGORITHM_ALGO_H_
@@ -0,0 +1,177 @@
+#include "algo.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "vector.h"
+
+TEST(Algo, for_each) {
+  std::vector<int> vec = {1, 2, 3, 4};
+  int sum = 0;
+  sgi::for_each(vec.data(), vec.data() + vec.size(), [&](int& x) {
+    sum += x;
+    x *= 2;
+  });
+  EXPECT_EQ(sum, 10);
+  EXPECT_EQ(vec, (std::vector<int>{2, 4, 6, 8}));
+}
+
+TEST(Algo, transform) {
+  std::vector<int> vec = {1, 2, 3};
+  std::vector<std::string> strings(3);
+  std::string* end =
+      sgi::transform(vec.data(), vec.data() + 3, strings.data(),
+                     [](int x) { return std::to_string(x * 10); });
+  EXPECT_EQ(end, strings.data() + 3);
+  EXPECT_EQ(strings, (std::vector<std::string>{"10", "20", "30"}));
+}
+
+TEST(Algo, find_count) {
+  int array[] = {3, 1, 4, 1, 5, 9, 2, 6};
+  EXPECT_EQ(sgi::find(array, array + 8, 1), array + 1);
+  EXPECT_EQ(sgi::find(array, array + 8, 7), array + 8);
+  EXPECT_EQ(sgi::find_if(array, array + 8, [](int x) { return x > 4; }),
+            array + 4);
+  EXPECT_EQ(sgi::count(array, array + 8, 1), 2);
+  EXPECT_EQ(sgi::count(array, array, 1), 0);
+  EXPECT_EQ(sgi::count_if(array, array + 8, [](int x) { return x % 2; }), 5);
+}
+
+TEST(Algo, find_count_simd) {
+  sgi::vector<int32_t> ints;
+  sgi::vector<uint8_t> bytes;
+  sgi::vector<float> floats;
+  for (int i = 0; i < 1000; i++) {
+    ints.push_back(i % 300 - 100);
+    bytes.push_back(static_cast<uint8_t>(i % 7));
+    floats.push_back(i % 10 * 0.5f);
+  }
+  EXPECT_EQ(sgi::find(ints.begin(), ints.end(), -100), ints.begin());
+  EXPECT_EQ(sgi::find(ints.begin(), ints.end(), 199), ints.begin() + 299);
+  EXPECT_EQ(sgi::count(ints.begin(), ints.end(), 0), 3);
+  EXPECT_EQ(sgi::count(bytes.begin(), bytes.end(), 6), 142);
+  EXPECT_EQ(sgi::find(floats.begin(), floats.end(), 2.5), floats.begin() + 5);
+  EXPECT_EQ(sgi::count(floats.begin(), floats.end(), 4.5f), 100);
+
+  // values only equal to an element after conversion
+  EXPECT_EQ(sgi::find(bytes.begin(), bytes.end(), 256 + 3), bytes.end());
+  EXPECT_EQ(sgi::count(bytes.begin(), bytes.end(), -1), 0);
+  EXPECT_EQ(sgi::find(bytes.begin(), bytes.end(), '\3'), bytes.begin() + 3);
+  EXPECT_EQ(sgi::count(ints.begin(), ints.end(), int64_t{1} << 32), 0);
+  EXPECT_EQ(sgi::count(ints.begin(), ints.end(), -1L), 4);
+  EXPECT_EQ(sgi::find(floats.begin(), floats.end(), 0.1), floats.end());
+  EXPECT_EQ(sgi::count(floats.begin(), floats.end(), 1e300), 0);
+  EXPECT_EQ(sgi::count(floats.begin(), floats.end(), 2), 100);
+  // compared as integers
+  EXPECT_EQ(sgi::count(ints.begin(), ints.end(), 0.5), 0);
+}
+
+TEST(Algo, min_max_element) {
+  int array[] = {3, 1, 4, 1, 5, 9, 2, 9};
+  EXPECT_EQ(sgi::min_element(array, array + 8), array + 1);
+  EXPECT_EQ(sgi::max_element(array, array + 8), array + 5);
+  EXPECT_EQ(sgi::min_element(array, array), array);
+  EXPECT_EQ(sgi::max_element(array, array + 8, std::greater<>()), array + 1);
+
+  std::mt19937 rng(1);
+  std::vector<int32_t> ints(1000);
+  std::vector<uint8_t> bytes(1000);
+  std::vector<float> floats(1000);
+  for (int i = 0; i < 1000; i++) {
+    ints[i] = static_cast<int32_t>(rng());
+    bytes[i] = static_cast<uint8_t>(rng() % 200);
+    floats[i] = static_cast<float>(rng() % 1000) - 500;
+  }
+  for (size_t n : {1, 7, 64, 999, 1000}) {
+    EXPECT_EQ(sgi::min_element(ints.begin(), ints.begin() + n),
+              std::min_element(ints.begin(), ints.begin() + n));
+    EXPECT_EQ(sgi::max_element(ints.begin(), ints.begin() + n),
+              std::max_element(ints.begin(), ints.begin() + n));
+    EXPECT_EQ(sgi::min_element(bytes.begin(), bytes.begin() + n),
+              std::min_element(bytes.begin(), bytes.begin() + n));
+    EXPECT_EQ(sgi::max_element(bytes.begin(), bytes.begin() + n),
+              std::max_element(bytes.begin(), bytes.begin() + n));
+    EXPECT_EQ(sgi::min_element(floats.begin(), floats.begin() + n),
+              std::min_element(floats.begin(), floats.begin() + n));
+    EXPECT_EQ(sgi::max_element(floats.begin(), floats.begin() + n),
+              std::max_element(floats.begin(), floats.begin() + n));
+  }
+
+  // NaNs order as operator< orders them
+  floats[0] = 1.0f;
+  floats[1] = std::numeric_limits<float>::quiet_NaN();
+  floats[2] = 0.0f;
+  floats[3] = -0.0f;
+  EXPECT_EQ(sgi::min_element(floats.begin(), floats.end()),
+            std::min_element(floats.begin(), floats.end()));
+  EXPECT_EQ(sgi::min_element(floats.begin() + 2, floats.begin() + 4),
+            floats.begin() + 2);
+}
+
+TEST(Algo, reduce) {
+  int array[] = {1, 2, 3, 4, 5};
+  EXPECT_EQ(sgi::reduce(array, array + 5), 15);
+  EXPECT_EQ(sgi::reduce(array, array + 5, 100), 115);
+  EXPECT_EQ(sgi::reduce(array, array + 5, 1, std::multiplies<>()), 120);
+  EXPECT_EQ(sgi::reduce(array, array, 7), 7);
+}
+
+TEST(Algo, sort) {
+  std::mt19937 rng(1);
+  for (size_t n : {0, 1, 2, 3, 15, 16, 17, 100, 1000, 100000}) {
+    std::vector<int> random(n);
+    for (int& x : random) {
+      x = rng() % (n / 4 + 1);  // with duplicates
+    }
+    std::vector<int> expected = random;
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<int> vec = random;
+    sgi::sort(vec.data(), vec.data() + n);
+    EXPECT_EQ(vec, expected) << n;
+
+    std::vector<int> sorted = expected;
+    sgi::sort(sorted.data(), sorted.data() + n);
+    EXPECT_EQ(sorted, expected) << n;
+
+    std::vector<int> reversed(expected.rbegin(), expected.rend());
+    sgi::sort(reversed.data(), reversed.data() + n, std::greater<>());
+    EXPECT_EQ(reversed, std::vector<int>(expected.rbegin(), expected.rend()));
+  }
+
+  // elements that are not trivially copyable
+  std::vector<std::string> strings = {"pear", "apple", "fig", "banana"};
+  sgi::sort(strings.data(), strings.data() + strings.size());
+  EXPECT_EQ(strings,
+            (std::vector<std::string>{"apple", "banana", "fig", "pear"}));
+}
+
+// what sort falls back on past its depth limit
+TEST(Algo, heap_sort) {
+  size_t n = 1 << 16;
+  std::vector<int64_t> vec(n);
+  for (size_t i = 0; i < n; i++) {
+    vec[i] = static_cast<int64_t>(i % 2 == 0 ? i : n - i);
+  }
+  std::vector<int64_t> expected = vec;
+  std::sort(expected.begin(), expected.end());
+  sgi::heap_sort(vec.data(), vec.data() + n, std::less<>());
+  EXPECT_EQ(vec, expected);
+}
+
+TEST(Algo, sort_equal) {
+  std::vector<int> all_equal(1000, 7);
+  sgi::sort(all_equal.data(), all_equal.data() + 1000);
+  EXPECT_EQ(all_equal, std::vector<int>(1000, 7));
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,312 @@
+#ifndef ALGORITHM_ALGOBASE_H_
+#define ALGORITHM_ALGOBASE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "iterator.h"
+#include "simd.h"
+
+namespace sgi {
+
+// Element type of a contiguous iterator, const if it is read-only, and void
+// for other iterators.
+template <typename Iterator, bool = is_contiguous_iterator_v<Iterator>>
+struct contiguous_element {
+  using type = void;
+};
+
+template <typename Iterator>
+struct contiguous_element<Iterator, true> {
+  using type = std::remove_pointer_t<decltype(sgi::to_address(
+      std::declval<const Iterator&>()))>;
+};
+
+template <typename Iterator>
+using contiguous_element_t = typename contiguous_element<Iterator>::type;
+
+// Whether a range of T can be filled by repeating the bytes of one T: its
+// size divides the 16-byte pattern of the simd kernels.
+template <typename T, typename = void>
+struct is_pattern_fillable : std::false_type {};
+
+template <typename T>
+struct is_pattern_fillable<T, std::enable_if_t<!std::is_void_v<T>>>
+    : std::bool_constant<std::is_trivially_copyable_v<T> &&
+                         !std::is_volatile_v<T> && !std::is_const_v<T> &&
+                         (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 ||
+                          sizeof(T) == 8 || sizeof(T) == 16)> {};
+
+template <typename T>
+inline constexpr bool is_pattern_fillable_v = is_pattern_fillable<T>::value;
+
+// Whether a range of From can be copied to a range of To as raw bytes.
+template <typename From, typename To>
+inline constexpr bool is_bitwise_copyable_v =
+    std::is_same_v<std::remove_const_t<From>, To> &&
+    std::is_trivially_copyable_v<To> && !std::is_volatile_v<To>;
+
+// Whether ranges of T compare equal exactly when their bytes do: not floating
+// point, where 0.0 == -0.0, nor classes, whose padding is unspecified.
+template <typename T>
+inline constexpr bool is_bitwise_comparable_v =
+    (std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>) &&
+    !std::is_volatile_v<T>;
+
+// Whether ranges of T are ordered as memcmp orders their bytes.
+template <typename T>
+inline constexpr bool is_bytewise_ordered_v =
+    std::is_same_v<T, unsigned char> || std::is_same_v<T, std::byte> ||
+    (std::is_same_v<T, char> && std::is_unsigned_v<char>);
+
+// Whether ranges of T are searched with the simd search kernels.
+template <typename T>
+inline constexpr bool is_simd_searchable_v =
+    std::is_same_v<T, int32_t> || std::is_same_v<T, uint8_t> ||
+    std::is_same_v<T, float>;
+
+// Whether the elements of such a T that equal a U can be found as those that
+// equal a T: U is an integer, or T floating point.
+template <typename T, typename U>
+inline constexpr bool is_simd_search_key_v =
+    is_simd_searchable_v<T> && std::is_arithmetic_v<U> &&
+    !std::is_same_v<U, bool> &&
+    (std::is_floating_point_v<T> || std::is_integral_v<U>);
+
+// Sets key to the T equal to the same elements as value, or returns false
+// if no T is.
+template <typename T, typename U>
+inline bool to_search_key(const U& value, T* key) {
+  if constexpr (std::is_floating_point_v<U> && sizeof(U) > sizeof(T)) {
+    // finite but out of range, where the conversion is undefined
+    if (value - value == 0 && (value < std::numeric_limits<T>::lowest() ||
+                               value > std::numeric_limits<T>::max())) {
+      return false;
+    }
+  }
+  using common = std::common_type_t<T, U>;
+  *key = static_cast<T>(value);
+  return static_cast<common>(*key) == static_cast<common>(value);
+}
+
+template <typename T>
+inline void fill_pattern(T* first, size_t n, const T& value) {
+  if (n == 0) {
+    return;
+  }
+  if constexpr (sizeof(T) == 1) {
+    unsigned char byte;
+    memcpy(&byte, &value, 1);
+    memset(static_cast<void*>(first), byte, n);
+  } else {
+    unsigned char pattern[32];
+    for (size_t i = 0; i < sizeof(pattern); i += sizeof(T)) {
+      memcpy(pattern + i, &value, sizeof(T));
+    }
+    const simd::Kernels& kernels = simd::ActiveKernels();
+    kernels.fill(first, n * sizeof(T), pattern, kernels.non_temporal_bytes);
+  }
+}
+
+template <typename T>
+inline void copy_bytes(T* result, const T* first, size_t n) {
+  if (n == 0) {
+    return;
+  }
+  size_t bytes = n * sizeof(T);
+  uintptr_t d = reinterpret_cast<uintptr_t>(result);
+  uintptr_t s = reinterpret_cast<uintptr_t>(first);
+  if (d < s + bytes && s < d + bytes) {
+    memmove(static_cast<void*>(result), first, bytes);
+    return;
+  }
+  const simd::Kernels& kernels = simd::ActiveKernels();
+  kernels.copy(result, first, bytes, kernels.non_temporal_bytes);
+}
+
+// Assigns value to every element of [first, last). Contiguous ranges of
+// trivially copyable elements of 1, 2, 4, 8 or 16 bytes are filled with
+// memset or the simd kernels.
+template <typename ForwardIter, typename T>
+inline void fill(ForwardIter first, ForwardIter last, const T& value) {
+  using type = contiguous_element_t<ForwardIter>;
+  if constexpr (is_pattern_fillable_v<type> &&
+                (std::is_same_v<type, T> ||
+                 (std::is_arithmetic_v<type> && std::is_arithmetic_v<T>))) {
+    fill_pattern(sgi::to_address(first),
+                 static_cast<size_t>(last - first), type(value));
+  } else {
+    for (; first != last; ++first) {
+      *first = value;
+    }
+  }
+}
+
+template <typename OutputIter, typename Size, typename T>
+inline OutputIter fill_n(OutputIter first, Size n, const T& value) {
+  if constexpr (is_contiguous_iterator_v<OutputIter>) {
+    if (n <= 0) {
+      return first;
+    }
+    sgi::fill(first, first + n, value);
+    return first + n;
+  } else {
+    for (; n > 0; --n, ++first) {
+      *first = value;
+    }
+    return first;
+  }
+}
+
+// Assigns [first, last) to the range at result, which may only overlap it if
+// it starts before first. Contiguous ranges of the same trivially copyable
+// type go to the simd kernels, or to memmove if they overlap.
+template <typename InputIter, typename OutputIter>
+inline OutputIter copy(InputIter first, InputIter last, OutputIter result) {
+  if constexpr (is_bitwise_copyable_v<contiguous_element_t<InputIter>,
+                                      contiguous_element_t<OutputIter>>) {
+    size_t n = static_cast<size_t>(last - first);
+    copy_bytes(sgi::to_address(result), sgi::to_address(first), n);
+    return result + n;
+  } else {
+    for (; first != last; ++first, ++result) {
+      *result = *first;
+    }
+    return result;
+  }
+}
+
+// Like copy, but the range at result ends at result and may only overlap
+// [first, last) if it ends after last.
+template <typename BidirIter1, typename BidirIter2>
+inline BidirIter2 copy_backward(BidirIter1 first, BidirIter1 last,
+                                BidirIter2 result) {
+  if constexpr (is_bitwise_copyable_v<contiguous_element_t<BidirIter1>,
+                                      contiguous_element_t<BidirIter2>>) {
+    size_t n = static_cast<size_t>(last - first);
+    copy_bytes(sgi::to_address(result) - n, sgi::to_address(first), n);
+    return result - n;
+  } else {
+    while (first != last) {
+      *--result = *--last;
+    }
+    return result;
+  }
+}
+
+// copy with move assignment
+template <typename InputIter, typename OutputIter>
+inline OutputIter move(InputIter first, InputIter last, OutputIter result) {
+  if constexpr (is_bitwise_copyable_v<contiguous_element_t<InputIter>,
+                                      contiguous_element_t<OutputIter>>) {
+    return sgi::copy(first, last, result);
+  } else {
+    for (; first != last; ++first, ++result) {
+      *result = std::move(*first);
+    }
+    return result;
+  }
+}
+
+// copy_backward with move assignment
+template <typename BidirIter1, typename BidirIter2>
+inline BidirIter2 move_backward(BidirIter1 first, BidirIter1 last,
+                                BidirIter2 result) {
+  if constexpr (is_bitwise_copyable_v<contiguous_element_t<BidirIter1>,
+                                      contiguous_element_t<BidirIter2>>) {
+    return sgi::copy_backward(first, last, result);
+  } else {
+    while (first != last) {
+      *--result = std::move(*--last);
+    }
+    return result;
+  }
+}
+
+// The first position where [first1, last1) and the range at first2 differ.
+// Contiguous ranges of the same int32_t, uint8_t or float type are compared
+// with the simd kernels.
+template <typename InputIter1, typename InputIter2>
+inline std::pair<InputIter1, InputIter2> mismatch(InputIter1 first1,
+                                                  InputIter1 last1,
+                                                  InputIter2 first2) {
+  using type1 = std::remove_const_t<contiguous_element_t<InputIter1>>;
+  using type2 = std::remove_const_t<contiguous_element_t<InputIter2>>;
+  if constexpr (std::is_same_v<type1, type2> && is_simd_searchable_v<type1>) {
+    size_t n = static_cast<size_t>(last1 - first1);
+    if (n == 0) {
+      return {first1, first2};
+    }
+    size_t i = simd::ActiveSearchKernels<type1>().mismatch(
+        sgi::to_address(first1), sgi::to_address(first2), n);
+    return {first1 + i, first2 + i};
+  } else {
+    while (first1 != last1 && *first1 == *first2) {
+      ++first1;
+      ++first2;
+    }
+    return {first1, first2};
+  }
+}
+
+// Whether [first1, last1) equals the range at first2. Contiguous ranges of
+// the same integral, enum or pointer type are compared with memcmp, and of
+// floats with the simd kernels.
+template <typename InputIter1, typename InputIter2>
+inline bool equal(InputIter1 first1, InputIter1 last1, InputIter2 first2) {
+  using type1 = std::remove_const_t<contiguous_element_t<InputIter1>>;
+  using type2 = std::remove_const_t<contiguous_element_t<InputIter2>>;
+  if constexpr (std::is_same_v<type1, type2> &&
+                is_bitwise_comparable_v<type1>) {
+    size_t n = static_cast<size_t>(last1 - first1);
+    return n == 0 || memcmp(sgi::to_address(first1), sgi::to_address(first2),
+                            n * sizeof(type1)) == 0;
+  } else if constexpr (std::is_same_v<type1, type2> &&
+                       is_simd_searchable_v<type1>) {
+    return sgi::mismatch(first1, last1, first2).first == last1;
+  } else {
+    for (; first1 != last1; ++first1, ++first2) {
+      if (!(*first1 == *first2)) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+// Whether [first1, last1) orders before [first2, last2). Contiguous ranges of
+// unsigned bytes are compared with memcmp.
+template <typename InputIter1, typename InputIter2>
+inline bool lexicographical_compare(InputIter1 first1, InputIter1 last1,
+                                    InputIter2 first2, InputIter2 last2) {
+  using type1 = std::remove_const_t<contiguous_element_t<InputIter1>>;
+  using type2 = std::remove_const_t<contiguous_element_t<InputIter2>>;
+  if constexpr (std::is_same_v<type1, type2> && is_bytewise_ordered_v<type1>) {
+    size_t n1 = static_cast<size_t>(last1 - first1);
+    size_t n2 = static_cast<size_t>(last2 - first2);
+    size_t n = n1 < n2 ? n1 : n2;
+    int order = n == 0 ? 0
+                       : memcmp(sgi::to_address(first1),
+                                sgi::to_address(first2), n);
+    return order < 0 || (order == 0 && n1 < n2);
+  } else {
+    for (; first1 != last1 && first2 != last2; ++first1, ++first2) {
+      if (*first1 < *first2) {
+        return true;
+      }
+      if (*first2 < *first1) {
+        return false;
+      }
+    }
+    return first1 == last1 && first2 != last2;
+  }
+}
+
+}  // namespace sgi
+
+#endif  // ALGORITHM_ALGOBASE_H_
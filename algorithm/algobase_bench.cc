@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "algobase.h"
+#include "benchmark/benchmark.h"
+
+struct SgiFill {
+  static void Fill(int* first, int* last, int value) {
+    sgi::fill(first, last, value);
+  }
+};
+
+struct StdFill {
+  static void Fill(int* first, int* last, int value) {
+    std::fill(first, last, value);
+  }
+};
+
+// only fills bytes, 0 here
+struct Memset {
+  static void Fill(int* first, int* last, int) {
+    memset(first, 0, (last - first) * sizeof(int));
+  }
+};
+
+// Fills range(0) bytes of ints. Past the non-temporal threshold, sgi::fill
+// stores around the cache, see simd.h.
+template <typename Fill>
+static void BM_Fill(benchmark::State& state) {
+  size_t n = state.range(0) / sizeof(int);
+  std::vector<int> vec(n);
+  for (auto _ : state) {
+    Fill::Fill(vec.data(), vec.data() + n, 0);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_Fill, SgiFill)->RangeMultiplier(8)->Range(64, 64 << 20);
+BENCHMARK_TEMPLATE(BM_Fill, StdFill)->RangeMultiplier(8)->Range(64, 64 << 20);
+BENCHMARK_TEMPLATE(BM_Fill, Memset)->RangeMultiplier(8)->Range(64, 64 << 20);
+
+struct SgiCopy {
+  static void Copy(const int* first, const int* last, int* result) {
+    sgi::copy(first, last, result);
+  }
+};
+
+struct StdCopy {
+  static void Copy(const int* first, const int* last, int* result) {
+    std::copy(first, last, result);
+  }
+};
+
+struct Memcpy {
+  static void Copy(const int* first, const int* last, int* result) {
+    memcpy(result, first, (last - first) * sizeof(int));
+  }
+};
+
+template <typename Copy>
+static void BM_Copy(benchmark::State& state) {
+  size_t n = state.range(0) / sizeof(int);
+  std::vector<int> src(n, 1);
+  std::vector<int> dst(n);
+  for (auto _ : state) {
+    Copy::Copy(src.data(), src.data() + n, dst.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_Copy, SgiCopy)->RangeMultiplier(8)->Range(64, 64 << 20);
+BENCHMARK_TEMPLATE(BM_Copy, StdCopy)->RangeMultiplier(8)->Range(64, 64 << 20);
+BENCHMARK_TEMPLATE(BM_Copy, Memcpy)->RangeMultiplier(8)->Range(64, 64 << 20);
+
+// While a large buffer is filled, how fast a small working set, which fits in
+// the cache, can still be read.
+template <typename Fill>
+static void BM_FillWorkingSet(benchmark::State& state) {
+  std::vector<int> large((64 << 20) / sizeof(int));
+  std::vector<int> working_set((256 << 10) / sizeof(int), 1);
+  long sum = 0;
+  for (auto _ : state) {
+    Fill::Fill(large.data(), large.data() + large.size(), 0);
+    for (int round = 0; round < 16; round++) {
+      for (int value : working_set) {
+        sum += value;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+BENCHMARK_TEMPLATE(BM_FillWorkingSet, SgiFill)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FillWorkingSet, Memset)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,281 @@
+#include "algobase.h"
+
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+struct Pair {
+  int64_t first;
+  int64_t second;
+  bool operator==(const Pair& other) const {
+    return first == other.first && second == other.second;
+  }
+};
+
+// three bytes, filled one element at a time
+struct Rgb {
+  unsigned char r, g, b;
+};
+
+template <typename T>
+void ExpectFilled(const std::vector<T>& vec, size_t first, size_t last,
+                  const T& value, const T& outside) {
+  for (size_t i = 0; i < vec.size(); i++) {
+    ASSERT_EQ(vec[i], i >= first && i < last ? value : outside) << i;
+  }
+}
+
+TEST(Algobase, fill) {
+  // every pattern width, at every alignment of the range
+  for (size_t first = 0; first < 20; first++) {
+    for (size_t last = first; last < 1000; last += 37) {
+      std::vector<char> chars(1000, 'x');
+      sgi::fill(chars.data() + first, chars.data() + last, 'a');
+      ExpectFilled<char>(chars, first, last, 'a', 'x');
+
+      std::vector<int16_t> shorts(1000, -1);
+      sgi::fill(shorts.data() + first, shorts.data() + last, 0x1234);
+      ExpectFilled<int16_t>(shorts, first, last, 0x1234, -1);
+
+      std::vector<float> floats(1000, 0);
+      sgi::fill(floats.data() + first, floats.data() + last, 1.5f);
+      ExpectFilled<float>(floats, first, last, 1.5f, 0);
+
+      std::vector<uint64_t> longs(1000, 0);
+      sgi::fill(longs.data() + first, longs.data() + last,
+                0x0102030405060708);
+      ExpectFilled<uint64_t>(longs, first, last, 0x0102030405060708, 0);
+
+      std::vector<Pair> pairs(1000, Pair{0, 0});
+      sgi::fill(pairs.data() + first, pairs.data() + last, Pair{-1, 7});
+      ExpectFilled<Pair>(pairs, first, last, Pair{-1, 7}, Pair{0, 0});
+    }
+  }
+
+  // converted as by assignment
+  std::vector<char> chars(100);
+  sgi::fill(chars.data(), chars.data() + 100, 65);
+  EXPECT_EQ(chars[99], 'A');
+
+  Rgb rgb[10];
+  sgi::fill(rgb, rgb + 10, Rgb{1, 2, 3});
+  EXPECT_EQ(rgb[9].b, 3);
+
+  std::list<std::string> strs(5);
+  sgi::fill(strs.begin(), strs.end(), "abc");
+  EXPECT_EQ(strs.back(), "abc");
+}
+
+TEST(Algobase, fill_n) {
+  int ints[100] = {};
+  EXPECT_EQ(sgi::fill_n(ints, 50, 3), ints + 50);
+  EXPECT_EQ(ints[49], 3);
+  EXPECT_EQ(ints[50], 0);
+  EXPECT_EQ(sgi::fill_n(ints, 0, 4), ints);
+  EXPECT_EQ(sgi::fill_n(ints, -1, 4), ints);
+  EXPECT_EQ(ints[0], 3);
+
+  std::list<int> lst(10);
+  EXPECT_EQ(sgi::fill_n(lst.begin(), 10, 7), lst.end());
+  EXPECT_EQ(lst.back(), 7);
+}
+
+TEST(Algobase, copy) {
+  std::vector<int> src(1000);
+  for (int i = 0; i < 1000; i++) {
+    src[i] = i;
+  }
+  std::vector<int> dst(1000, -1);
+  EXPECT_EQ(sgi::copy(src.data() + 3, src.data() + 903, dst.data() + 1),
+            dst.data() + 901);
+  EXPECT_EQ(dst[0], -1);
+  EXPECT_EQ(dst[1], 3);
+  EXPECT_EQ(dst[900], 902);
+  EXPECT_EQ(dst[901], -1);
+
+  // overlapping, towards the front
+  std::vector<int> vec = src;
+  sgi::copy(vec.data() + 10, vec.data() + 1000, vec.data());
+  EXPECT_EQ(vec[0], 10);
+  EXPECT_EQ(vec[989], 999);
+
+  // towards the back
+  vec = src;
+  EXPECT_EQ(sgi::copy_backward(vec.data(), vec.data() + 990,
+                               vec.data() + 1000),
+            vec.data() + 10);
+  EXPECT_EQ(vec[10], 0);
+  EXPECT_EQ(vec[999], 989);
+
+  // other iterators and types
+  std::list<int> lst(src.begin(), src.begin() + 10);
+  std::vector<long> longs(10);
+  sgi::copy(lst.begin(), lst.end(), longs.begin());
+  EXPECT_EQ(longs[9], 9);
+  std::vector<std::string> strs = {"a", "b", "c", "d"};
+  sgi::copy_backward(strs.begin(), strs.begin() + 3, strs.end());
+  EXPECT_EQ(strs[1], "a");
+  EXPECT_EQ(strs[3], "c");
+}
+
+TEST(Algobase, move) {
+  std::vector<std::string> strs;
+  for (int i = 0; i < 10; i++) {
+    strs.push_back(std::string(100, 'a' + i));
+  }
+  const char* data = strs[5].data();
+  sgi::move(strs.begin() + 5, strs.end(), strs.begin());
+  EXPECT_EQ(strs[0].data(), data);
+  sgi::move_backward(strs.begin(), strs.begin() + 5, strs.end());
+  EXPECT_EQ(strs[5].data(), data);
+
+  double doubles[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  EXPECT_EQ(sgi::move_backward(doubles, doubles + 8, doubles + 10),
+            doubles + 2);
+  EXPECT_EQ(doubles[2], 0);
+  EXPECT_EQ(doubles[9], 7);
+  EXPECT_EQ(sgi::move(doubles + 2, doubles + 10, doubles), doubles + 8);
+  EXPECT_EQ(doubles[7], 7);
+}
+
+// a contiguous iterator that is not a pointer
+template <typename T>
+struct Wrapped {
+  using iterator_category = sgi::contiguous_iterator_tag;
+  using value_type = std::remove_const_t<T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+
+  T& operator*() const { return *p; }
+  T* operator->() const { return p; }
+  Wrapped& operator++() {
+    ++p;
+    return *this;
+  }
+  Wrapped& operator--() {
+    --p;
+    return *this;
+  }
+  Wrapped operator+(difference_type n) const { return {p + n}; }
+  Wrapped operator-(difference_type n) const { return {p - n}; }
+  difference_type operator-(const Wrapped& other) const {
+    return p - other.p;
+  }
+  bool operator==(const Wrapped& other) const { return p == other.p; }
+  bool operator!=(const Wrapped& other) const { return p != other.p; }
+
+  T* p;
+};
+
+TEST(Algobase, contiguous) {
+  static_assert(std::is_same_v<sgi::contiguous_element_t<Wrapped<const int>>,
+                               const int>);
+  static_assert(std::is_void_v<
+                sgi::contiguous_element_t<std::list<int>::iterator>>);
+
+  int src[100];
+  for (int i = 0; i < 100; i++) {
+    src[i] = i;
+  }
+  int dst[100] = {};
+  Wrapped<const int> first{src};
+  Wrapped<int> result{dst};
+  EXPECT_EQ(sgi::copy(first, first + 100, result).p, dst + 100);
+  EXPECT_TRUE(sgi::equal(first, first + 100, result));
+  EXPECT_EQ(dst[99], 99);
+  sgi::fill(result, result + 50, -1);
+  EXPECT_EQ(dst[49], -1);
+  EXPECT_EQ(dst[50], 50);
+  EXPECT_EQ(sgi::copy_backward(first, first + 10, result + 100).p, dst + 90);
+  EXPECT_EQ(dst[90], 0);
+  EXPECT_EQ(sgi::fill_n(result, 3, 7).p, dst + 3);
+  EXPECT_FALSE(sgi::equal(first, first + 100, result));
+}
+
+enum class Color : uint8_t { RED, GREEN };
+
+TEST(Algobase, equal) {
+  std::vector<int> a(1000, 1);
+  std::vector<int> b(1000, 1);
+  EXPECT_TRUE(sgi::equal(a.data(), a.data() + 1000, b.data()));
+  b[999] = 2;
+  EXPECT_FALSE(sgi::equal(a.data(), a.data() + 1000, b.data()));
+  EXPECT_TRUE(sgi::equal(a.data(), a.data() + 999, b.data()));
+  EXPECT_TRUE(sgi::equal(a.data(), a.data(), b.data()));
+
+  Color colors[3] = {Color::RED, Color::GREEN, Color::RED};
+  Color others[3] = {Color::RED, Color::GREEN, Color::GREEN};
+  EXPECT_FALSE(sgi::equal(colors, colors + 3, others));
+
+  // compared as values, not bytes
+  double zeros[2] = {0.0, -0.0};
+  double negative_zeros[2] = {-0.0, 0.0};
+  EXPECT_TRUE(sgi::equal(zeros, zeros + 2, negative_zeros));
+  std::list<std::string> strs = {"a", "b"};
+  std::vector<std::string> same = {"a", "b"};
+  EXPECT_TRUE(sgi::equal(strs.begin(), strs.end(), same.begin()));
+}
+
+TEST(Algobase, mismatch) {
+  std::vector<int32_t> a(1000, 1);
+  std::vector<int32_t> b(1000, 1);
+  EXPECT_EQ(sgi::mismatch(a.data(), a.data() + 1000, b.data()).first,
+            a.data() + 1000);
+  b[777] = 2;
+  auto [it1, it2] = sgi::mismatch(a.data(), a.data() + 1000, b.data());
+  EXPECT_EQ(it1, a.data() + 777);
+  EXPECT_EQ(it2, b.data() + 777);
+  EXPECT_EQ(sgi::mismatch(a.data(), a.data(), b.data()).second, b.data());
+
+  std::list<int> list = {1, 2, 3};
+  std::vector<long> longs = {1, 2, 4};
+  EXPECT_EQ(*sgi::mismatch(list.begin(), list.end(), longs.begin()).first, 3);
+}
+
+TEST(Algobase, equal_floats) {
+  std::vector<float> a(100, 0.5f);
+  std::vector<float> b(100, 0.5f);
+  EXPECT_TRUE(sgi::equal(a.begin(), a.end(), b.begin()));
+  a[10] = 0.0f;
+  b[10] = -0.0f;
+  EXPECT_TRUE(sgi::equal(a.begin(), a.end(), b.begin()));
+  b[99] = 1.0f;
+  EXPECT_FALSE(sgi::equal(a.begin(), a.end(), b.begin()));
+  // NaN does not equal itself
+  a[0] = std::numeric_limits<float>::quiet_NaN();
+  EXPECT_FALSE(sgi::equal(a.begin(), a.begin() + 1, a.begin()));
+}
+
+TEST(Algobase, lexicographical_compare) {
+  const unsigned char abc[] = {'a', 'b', 'c'};
+  const unsigned char abd[] = {'a', 'b', 'd'};
+  const unsigned char high[] = {0xff};
+  EXPECT_TRUE(sgi::lexicographical_compare(abc, abc + 3, abd, abd + 3));
+  EXPECT_FALSE(sgi::lexicographical_compare(abd, abd + 3, abc, abc + 3));
+  EXPECT_FALSE(sgi::lexicographical_compare(abc, abc + 3, abc, abc + 3));
+  EXPECT_TRUE(sgi::lexicographical_compare(abc, abc + 2, abc, abc + 3));
+  EXPECT_FALSE(sgi::lexicographical_compare(abc, abc + 3, abc, abc + 2));
+  EXPECT_TRUE(sgi::lexicographical_compare(abc, abc, abc, abc + 1));
+  EXPECT_TRUE(sgi::lexicographical_compare(abc, abc + 3, high, high + 1));
+
+  // signed, compared as values
+  const signed char negative[] = {-1};
+  const signed char positive[] = {1};
+  EXPECT_TRUE(
+      sgi::lexicographical_compare(negative, negative + 1, positive,
+                                   positive + 1));
+  std::vector<int> ints = {1, 2, 3};
+  std::list<int> longer = {1, 2, 3, 0};
+  EXPECT_TRUE(sgi::lexicographical_compare(ints.begin(), ints.end(),
+                                           longer.begin(), longer.end()));
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,349 @@
+#ifndef ALGORITHM_EXECUTION_H_
+#define ALGORITHM_EXECUTION_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "algo.h"
+#include "iterator.h"
+#include "thread_pool.h"
+
+namespace sgi {
+namespace execution {
+
+// Runs an algorithm on the calling thread, as its overload without a policy.
+struct sequenced_policy {};
+
+// Splits an algorithm over random access iterators, such as those of
+// sgi::vector, across the threads of a ThreadPool, ThreadPool::Default()
+// unless given with on:
+//
+//   sgi::sort(sgi::execution::par, vec.begin(), vec.end());
+//   sgi::sort(sgi::execution::par.on(pool), vec.begin(), vec.end());
+//
+// The functions given to the algorithm run on several elements at once, so
+// must not race. Unlike with std::execution, an exception they throw is
+// rethrown once every thread is done rather than terminating the program.
+// Other iterators run on the calling thread.
+//
+// Unsequenced, they may also be interleaved on one thread, so must not take
+// locks. Each thread runs a plain loop the compiler is free to vectorize, and
+// no more than that.
+template <bool Unsequenced>
+class basic_parallel_policy {
+ public:
+  constexpr basic_parallel_policy() = default;
+
+  basic_parallel_policy on(ThreadPool& pool) const {
+    return basic_parallel_policy(&pool);
+  }
+
+  ThreadPool& pool() const {
+    return pool_ != nullptr ? *pool_ : ThreadPool::Default();
+  }
+
+ private:
+  explicit basic_parallel_policy(ThreadPool* pool) : pool_(pool) {}
+
+  ThreadPool* pool_ = nullptr;
+};
+
+using parallel_policy = basic_parallel_policy<false>;
+using parallel_unsequenced_policy = basic_parallel_policy<true>;
+
+inline constexpr sequenced_policy seq{};
+inline constexpr parallel_policy par{};
+inline constexpr parallel_unsequenced_policy par_unseq{};
+
+}  // namespace execution
+
+template <typename T>
+struct is_execution_policy : std::false_type {};
+
+template <>
+struct is_execution_policy<execution::sequenced_policy> : std::true_type {};
+
+template <bool Unsequenced>
+struct is_execution_policy<execution::basic_parallel_policy<Unsequenced>>
+    : std::true_type {};
+
+template <typename T>
+inline constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+// Lets the overloads taking a policy first be told apart from those without.
+template <typename ExecutionPolicy, typename T>
+using enable_if_execution_policy_t = std::enable_if_t<
+    is_execution_policy_v<std::decay_t<ExecutionPolicy>>, T>;
+
+// Whether an algorithm given a policy splits [first, last) across threads.
+template <typename ExecutionPolicy, typename Iterator>
+inline constexpr bool is_parallel_v =
+    !std::is_same_v<std::decay_t<ExecutionPolicy>,
+                    execution::sequenced_policy> &&
+    std::is_base_of_v<random_access_iterator_tag,
+                      typename iterator_traits<Iterator>::iterator_category>;
+
+// Ranges are split in chunks of no fewer elements, so that a chunk outweighs
+// handing it to another thread. Smaller ranges run on the calling thread.
+inline constexpr size_t PARALLEL_GRAIN = 1 << 14;
+// Chunks per thread, so that stealing can even out uneven ones.
+inline constexpr size_t PARALLEL_CHUNKS_PER_THREAD = 4;
+
+inline size_t parallel_chunks(size_t n, const ThreadPool& pool) {
+  return std::min(n / PARALLEL_GRAIN,
+                  pool.concurrency() * PARALLEL_CHUNKS_PER_THREAD);
+}
+
+inline size_t chunk_begin(size_t n, size_t nchunks, size_t k) {
+  return n / nchunks * k + std::min(k, n % nchunks);
+}
+
+// Runs chunk(begin, end) over chunks covering [0, n) on the threads of pool.
+template <typename Chunk>
+inline void parallel_for(ThreadPool& pool, size_t n, Chunk chunk) {
+  size_t nchunks = parallel_chunks(n, pool);
+  if (nchunks <= 1) {
+    chunk(0, n);
+    return;
+  }
+  pool.Run(nchunks, [&](size_t k) {
+    chunk(chunk_begin(n, nchunks, k), chunk_begin(n, nchunks, k + 1));
+  });
+}
+
+template <typename ExecutionPolicy, typename ForwardIter, typename Function>
+inline enable_if_execution_policy_t<ExecutionPolicy, void> for_each(
+    ExecutionPolicy&& policy, ForwardIter first, ForwardIter last,
+    Function f) {
+  if constexpr (is_parallel_v<ExecutionPolicy, ForwardIter>) {
+    parallel_for(policy.pool(), static_cast<size_t>(last - first),
+                 [&](size_t begin, size_t end) {
+                   sgi::for_each(first + begin, first + end, f);
+                 });
+  } else {
+    sgi::for_each(first, last, f);
+  }
+}
+
+// The output range may be the input range, but may not otherwise overlap it.
+template <typename ExecutionPolicy, typename ForwardIter1,
+          typename ForwardIter2, typename UnaryOperation>
+inline enable_if_execution_policy_t<ExecutionPolicy, ForwardIter2> transform(
+    ExecutionPolicy&& policy, ForwardIter1 first, ForwardIter1 last,
+    ForwardIter2 result, UnaryOperation op) {
+  if constexpr (is_parallel_v<ExecutionPolicy, ForwardIter1> &&
+                is_parallel_v<ExecutionPolicy, ForwardIter2>) {
+    size_t n = static_cast<size_t>(last - first);
+    parallel_for(policy.pool(), n, [&](size_t begin, size_t end) {
+      sgi::transform(first + begin, first + end, result + begin, op);
+    });
+    return result + n;
+  } else {
+    return sgi::transform(first, last, result, op);
+  }
+}
+
+// Each chunk is folded from its first element, then the chunks into init in
+// order.
+template <typename ExecutionPolicy, typename ForwardIter, typename T,
+          typename BinaryOperation>
+inline enable_if_execution_policy_t<ExecutionPolicy, T> reduce(
+    ExecutionPolicy&& policy, ForwardIter first, ForwardIter last, T init,
+    BinaryOperation op) {
+  if constexpr (is_parallel_v<ExecutionPolicy, ForwardIter>) {
+    ThreadPool& pool = policy.pool();
+    size_t n = static_cast<size_t>(last - first);
+    size_t nchunks = parallel_chunks(n, pool);
+    if (nchunks <= 1) {
+      return sgi::reduce(first, last, std::move(init), op);
+    }
+    std::vector<std::optional<T>> partials(nchunks);
+    pool.Run(nchunks, [&](size_t k) {
+      ForwardIter begin = first + chunk_begin(n, nchunks, k);
+      ForwardIter end = first + chunk_begin(n, nchunks, k + 1);
+      T partial = *begin;
+      partials[k] = sgi::reduce(++begin, end, std::move(partial), op);
+    });
+    for (std::optional<T>& partial : partials) {
+      init = op(std::move(init), std::move(*partial));
+    }
+    return init;
+  } else {
+    return sgi::reduce(first, last, std::move(init), op);
+  }
+}
+
+template <typename ExecutionPolicy, typename ForwardIter, typename T>
+inline enable_if_execution_policy_t<ExecutionPolicy, T> reduce(
+    ExecutionPolicy&& policy, ForwardIter first, ForwardIter last, T init) {
+  return sgi::reduce(std::forward<ExecutionPolicy>(policy), first, last,
+                     std::move(init), std::plus<>());
+}
+
+template <typename ExecutionPolicy, typename ForwardIter>
+inline enable_if_execution_policy_t<
+    ExecutionPolicy, typename iterator_traits<ForwardIter>::value_type>
+reduce(ExecutionPolicy&& policy, ForwardIter first, ForwardIter last) {
+  return sgi::reduce(std::forward<ExecutionPolicy>(policy), first, last,
+                     typename iterator_traits<ForwardIter>::value_type());
+}
+
+// Partitions in place as sort does, then sorts both sides at once. The first
+// partitions are on one thread, which bounds the speedup to about
+// log2(n / PARALLEL_GRAIN), but no buffer is needed.
+template <typename RandomIter, typename Compare>
+inline void parallel_sort(RandomIter first, RandomIter last, int depth_limit,
+                          Compare comp, ThreadPool& pool) {
+  if (last - first <= static_cast<ptrdiff_t>(PARALLEL_GRAIN)) {
+    sgi::sort(first, last, comp);
+    return;
+  }
+  if (depth_limit == 0) {
+    heap_sort(first, last, comp);
+    return;
+  }
+  RandomIter cut = partition_pivot(first, last, comp);
+  pool.Invoke(
+      [&] { parallel_sort(first, cut, depth_limit - 1, comp, pool); },
+      [&] { parallel_sort(cut, last, depth_limit - 1, comp, pool); });
+}
+
+template <typename ExecutionPolicy, typename RandomIter, typename Compare>
+inline enable_if_execution_policy_t<ExecutionPolicy, void> sort(
+    ExecutionPolicy&& policy, RandomIter first, RandomIter last,
+    Compare comp) {
+  if constexpr (is_parallel_v<ExecutionPolicy, RandomIter>) {
+    ThreadPool& pool = policy.pool();
+    if (pool.concurrency() > 1) {
+      parallel_sort(first, last, sort_depth_limit(last - first), comp, pool);
+      return;
+    }
+  }
+  sgi::sort(first, last, comp);
+}
+
+template <typename ExecutionPolicy, typename RandomIter>
+inline enable_if_execution_policy_t<ExecutionPolicy, void> sort(
+    ExecutionPolicy&& policy, RandomIter first, RandomIter last) {
+  sgi::sort(std::forward<ExecutionPolicy>(policy), first, last,
+            std::less<>());
+}
+
+// The first match still wins. Chunks past a match found elsewhere stop early,
+// checking every PARALLEL_FIND_BLOCK elements.
+inline constexpr size_t PARALLEL_FIND_BLOCK = 1024;
+
+// The first match in [first, last), of find_block(begin, end), which returns
+// the first match of a block or its end.
+template <typename ExecutionPolicy, typename ForwardIter, typename FindBlock>
+inline ForwardIter parallel_find(ExecutionPolicy&& policy, ForwardIter first,
+                                 ForwardIter last, FindBlock find_block) {
+  size_t n = static_cast<size_t>(last - first);
+  std::atomic<size_t> found{n};
+  parallel_for(policy.pool(), n, [&](size_t begin, size_t end) {
+    while (begin < end && begin < found.load(std::memory_order_relaxed)) {
+      size_t block_end = std::min(end, begin + PARALLEL_FIND_BLOCK);
+      ForwardIter it = find_block(first + begin, first + block_end);
+      if (it != first + block_end) {
+        size_t index = static_cast<size_t>(it - first);
+        size_t current = found.load();
+        while (index < current &&
+               !found.compare_exchange_weak(current, index)) {
+        }
+        return;
+      }
+      begin = block_end;
+    }
+  });
+  return first + found.load();
+}
+
+template <typename ExecutionPolicy, typename ForwardIter, typename Predicate>
+inline enable_if_execution_policy_t<ExecutionPolicy, ForwardIter> find_if(
+    ExecutionPolicy&& policy, ForwardIter first, ForwardIter last,
+    Predicate pred) {
+  if constexpr (is_parallel_v<ExecutionPolicy, ForwardIter>) {
+    return sgi::parallel_find(policy, first, last,
+                              [&](ForwardIter begin, ForwardIter end) {
+                                return sgi::find_if(begin, end, pred);
+                              });
+  } else {
+    return sgi::find_if(first, last, pred);
+  }
+}
+
+// Blocks are searched by sgi::find, with the simd kernels where it has them.
+template <typename ExecutionPolicy, typename ForwardIter, typename T>
+inline enable_if_execution_policy_t<ExecutionPolicy, ForwardIter> find(
+    ExecutionPolicy&& policy, ForwardIter first, ForwardIter last,
+    const T& value) {
+  if constexpr (is_parallel_v<ExecutionPolicy, ForwardIter>) {
+    return sgi::parallel_find(policy, first, last,
+                              [&](ForwardIter begin, ForwardIter end) {
+                                return sgi::find(begin, end, value);
+                              });
+  } else {
+    return sgi::find(first, last, value);
+  }
+}
+
+// The sum of count_chunk(begin, end) over chunks of [first, last).
+template <typename ExecutionPolicy, typename ForwardIter, typename CountChunk>
+inline typename iterator_traits<ForwardIter>::difference_type parallel_count(
+    ExecutionPolicy&& policy, ForwardIter first, ForwardIter last,
+    CountChunk count_chunk) {
+  using Distance = typename iterator_traits<ForwardIter>::difference_type;
+  ThreadPool& pool = policy.pool();
+  size_t n = static_cast<size_t>(last - first);
+  size_t nchunks = parallel_chunks(n, pool);
+  if (nchunks <= 1) {
+    return count_chunk(first, last);
+  }
+  std::vector<Distance> counts(nchunks);
+  pool.Run(nchunks, [&](size_t k) {
+    counts[k] = count_chunk(first + chunk_begin(n, nchunks, k),
+                            first + chunk_begin(n, nchunks, k + 1));
+  });
+  return sgi::reduce(counts.begin(), counts.end(), Distance(0));
+}
+
+template <typename ExecutionPolicy, typename ForwardIter, typename Predicate>
+inline enable_if_execution_policy_t<
+    ExecutionPolicy, typename iterator_traits<ForwardIter>::difference_type>
+count_if(ExecutionPolicy&& policy, ForwardIter first, ForwardIter last,
+         Predicate pred) {
+  if constexpr (is_parallel_v<ExecutionPolicy, ForwardIter>) {
+    return sgi::parallel_count(policy, first, last,
+                               [&](ForwardIter begin, ForwardIter end) {
+                                 return sgi::count_if(begin, end, pred);
+                               });
+  } else {
+    return sgi::count_if(first, last, pred);
+  }
+}
+
+// Chunks are counted by sgi::count, with the simd kernels where it has them.
+template <typename ExecutionPolicy, typename ForwardIter, typename T>
+inline enable_if_execution_policy_t<
+    ExecutionPolicy, typename iterator_traits<ForwardIter>::difference_type>
+count(ExecutionPolicy&& policy, ForwardIter first, ForwardIter last,
+      const T& value) {
+  if constexpr (is_parallel_v<ExecutionPolicy, ForwardIter>) {
+    return sgi::parallel_count(policy, first, last,
+                               [&](ForwardIter begin, ForwardIter end) {
+                                 return sgi::count(begin, end, value);
+                               });
+  } else {
+    return sgi::count(first, last, value);
+  }
+}
+
+}  // namespace sgi
+
+#endif  // ALGORITHM_EXECUTION_H_
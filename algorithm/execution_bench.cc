@@ -0,0 +1,106 @@
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "benchmark/benchmark.h"
+#include "execution.h"
+#include "vector.h"
+
+constexpr size_t N = 1 << 24;
+
+sgi::vector<double> Random(size_t n) {
+  std::mt19937_64 rng(1);
+  std::uniform_real_distribution<double> dist(0, 1);
+  sgi::vector<double> vec;
+  for (size_t i = 0; i < n; i++) {
+    vec.push_back(dist(rng));
+  }
+  return vec;
+}
+
+// Runs Algorithm over N doubles with range(0) threads, or on the calling
+// thread with sgi::execution::seq when range(0) is 0.
+template <typename Algorithm>
+static void BM_Execution(benchmark::State& state) {
+  sgi::vector<double> input = Random(N);
+  sgi::vector<double> vec(N, 0.0);
+  bool sequential = state.range(0) == 0;
+  sgi::ThreadPool pool(sequential ? 0 : state.range(0) - 1);
+  auto par = sgi::execution::par.on(pool);
+  for (auto _ : state) {
+    state.PauseTiming();
+    sgi::copy(input.begin(), input.end(), vec.begin());
+    state.ResumeTiming();
+    if (sequential) {
+      Algorithm::Run(sgi::execution::seq, vec);
+    } else {
+      Algorithm::Run(par, vec);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+}
+
+struct ForEach {
+  template <typename Policy>
+  static void Run(const Policy& policy, sgi::vector<double>& vec) {
+    sgi::for_each(policy, vec.begin(), vec.end(),
+                  [](double& x) { x = std::sqrt(x); });
+  }
+};
+
+struct Transform {
+  template <typename Policy>
+  static void Run(const Policy& policy, sgi::vector<double>& vec) {
+    sgi::transform(policy, vec.begin(), vec.end(), vec.begin(),
+                   [](double x) { return x * 3 + 1; });
+  }
+};
+
+struct Reduce {
+  template <typename Policy>
+  static void Run(const Policy& policy, sgi::vector<double>& vec) {
+    benchmark::DoNotOptimize(sgi::reduce(policy, vec.begin(), vec.end()));
+  }
+};
+
+struct Sort {
+  template <typename Policy>
+  static void Run(const Policy& policy, sgi::vector<double>& vec) {
+    sgi::sort(policy, vec.begin(), vec.end());
+  }
+};
+
+// no match, the whole range is scanned
+struct Find {
+  template <typename Policy>
+  static void Run(const Policy& policy, sgi::vector<double>& vec) {
+    benchmark::DoNotOptimize(sgi::find(policy, vec.begin(), vec.end(), 2.0));
+  }
+};
+
+struct Count {
+  template <typename Policy>
+  static void Run(const Policy& policy, sgi::vector<double>& vec) {
+    benchmark::DoNotOptimize(sgi::count_if(
+        policy, vec.begin(), vec.end(), [](double x) { return x < 0.5; }));
+  }
+};
+
+// 0 is the sequential baseline, then 1 to 64 threads
+#define BENCHMARK_EXECUTION(Algorithm)              \
+  BENCHMARK_TEMPLATE(BM_Execution, Algorithm)       \
+      ->Arg(0)                                      \
+      ->RangeMultiplier(2)                          \
+      ->Range(1, 64)                                \
+      ->UseRealTime()                               \
+      ->Unit(benchmark::kMillisecond)
+
+BENCHMARK_EXECUTION(ForEach);
+BENCHMARK_EXECUTION(Transform);
+BENCHMARK_EXECUTION(Reduce);
+BENCHMARK_EXECUTION(Sort);
+BENCHMARK_EXECUTION(Find);
+BENCHMARK_EXECUTION(Count);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,200 @@
+#include "execution.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "list.h"
+#include "vector.h"
+
+// large enough to be split across the threads
+constexpr size_t N = 40 * sgi::PARALLEL_GRAIN + 17;
+
+sgi::vector<int64_t> Iota(size_t n) {
+  sgi::vector<int64_t> vec;
+  for (size_t i = 0; i < n; i++) {
+    vec.push_back(static_cast<int64_t>(i));
+  }
+  return vec;
+}
+
+TEST(Execution, policies) {
+  EXPECT_TRUE(sgi::is_execution_policy_v<sgi::execution::sequenced_policy>);
+  EXPECT_TRUE(sgi::is_execution_policy_v<sgi::execution::parallel_policy>);
+  EXPECT_TRUE(sgi::is_execution_policy_v<
+              sgi::execution::parallel_unsequenced_policy>);
+  EXPECT_FALSE(sgi::is_execution_policy_v<int*>);
+  EXPECT_EQ(&sgi::execution::par.pool(), &sgi::ThreadPool::Default());
+  sgi::ThreadPool pool(1);
+  EXPECT_EQ(&sgi::execution::par.on(pool).pool(), &pool);
+  EXPECT_EQ(&sgi::execution::par_unseq.on(pool).pool(), &pool);
+}
+
+TEST(Execution, for_each) {
+  sgi::ThreadPool pool(3);
+  sgi::vector<int64_t> vec = Iota(N);
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  sgi::for_each(sgi::execution::par.on(pool), vec.begin(), vec.end(),
+                [&](int64_t& x) {
+                  x *= 2;
+                  if (x % 1024 == 0) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    threads.insert(std::this_thread::get_id());
+                  }
+                });
+  for (size_t i = 0; i < N; i++) {
+    ASSERT_EQ(vec[i], 2 * static_cast<int64_t>(i));
+  }
+  EXPECT_GT(threads.size(), 1);
+
+  sgi::for_each(sgi::execution::seq, vec.begin(), vec.end(),
+                [](int64_t& x) { x++; });
+  sgi::for_each(sgi::execution::par_unseq.on(pool), vec.begin(), vec.end(),
+                [](int64_t& x) { x++; });
+  EXPECT_EQ(vec[N - 1], 2 * static_cast<int64_t>(N - 1) + 2);
+}
+
+TEST(Execution, transform) {
+  sgi::ThreadPool pool(3);
+  sgi::vector<int64_t> vec = Iota(N);
+  sgi::vector<double> halves(N, 0.0);
+  double* end = sgi::transform(sgi::execution::par.on(pool), vec.begin(),
+                               vec.end(), halves.begin(),
+                               [](int64_t x) { return x / 2.0; });
+  EXPECT_EQ(end, halves.end());
+  for (size_t i = 0; i < N; i++) {
+    ASSERT_EQ(halves[i], i / 2.0);
+  }
+
+  // in place
+  sgi::transform(sgi::execution::par.on(pool), vec.begin(), vec.end(),
+                 vec.begin(), [](int64_t x) { return -x; });
+  EXPECT_EQ(vec[N - 1], -static_cast<int64_t>(N - 1));
+}
+
+TEST(Execution, reduce) {
+  sgi::ThreadPool pool(3);
+  sgi::vector<int64_t> vec = Iota(N);
+  int64_t sum = static_cast<int64_t>(N * (N - 1) / 2);
+  auto par = sgi::execution::par.on(pool);
+  EXPECT_EQ(sgi::reduce(par, vec.begin(), vec.end()), sum);
+  EXPECT_EQ(sgi::reduce(par, vec.begin(), vec.end(), int64_t{5}), sum + 5);
+  EXPECT_EQ(sgi::reduce(par, vec.begin(), vec.end(), int64_t{-1},
+                        [](int64_t a, int64_t b) { return std::max(a, b); }),
+            static_cast<int64_t>(N - 1));
+  EXPECT_EQ(sgi::reduce(sgi::execution::seq, vec.begin(), vec.end()), sum);
+  EXPECT_EQ(sgi::reduce(par, vec.begin(), vec.begin() + 10), 45);
+}
+
+TEST(Execution, sort) {
+  sgi::ThreadPool pool(3);
+  std::mt19937 rng(7);
+  for (size_t n : {size_t{0}, size_t{100}, N, 4 * N}) {
+    sgi::vector<uint32_t> vec;
+    for (size_t i = 0; i < n; i++) {
+      vec.push_back(rng() % (n / 2 + 1));
+    }
+    std::vector<uint32_t> expected(vec.begin(), vec.end());
+    std::sort(expected.begin(), expected.end());
+    sgi::sort(sgi::execution::par.on(pool), vec.begin(), vec.end());
+    ASSERT_TRUE(std::equal(vec.begin(), vec.end(), expected.begin())) << n;
+
+    sgi::sort(sgi::execution::par.on(pool), vec.begin(), vec.end(),
+              std::greater<>());
+    ASSERT_TRUE(std::equal(vec.begin(), vec.end(), expected.rbegin())) << n;
+  }
+
+  // on the calling thread alone
+  sgi::ThreadPool none(0);
+  sgi::vector<int64_t> vec = Iota(N);
+  sgi::sort(sgi::execution::par.on(none), vec.begin(), vec.end(),
+            std::greater<>());
+  EXPECT_EQ(vec[0], static_cast<int64_t>(N - 1));
+}
+
+TEST(Execution, find_count) {
+  sgi::ThreadPool pool(3);
+  auto par = sgi::execution::par.on(pool);
+  sgi::vector<int64_t> vec(N, 0);
+  EXPECT_EQ(sgi::find(par, vec.begin(), vec.end(), 1), vec.end());
+  EXPECT_EQ(sgi::count(par, vec.begin(), vec.end(), 1), 0);
+
+  // the first match wins wherever the others are
+  vec[N - 3] = 1;
+  vec[N / 2] = 1;
+  vec[N / 3] = 1;
+  vec[5] = 2;
+  EXPECT_EQ(sgi::find(par, vec.begin(), vec.end(), 1), vec.begin() + N / 3);
+  EXPECT_EQ(sgi::find_if(par, vec.begin(), vec.end(),
+                         [](int64_t x) { return x > 0; }),
+            vec.begin() + 5);
+  EXPECT_EQ(sgi::count(par, vec.begin(), vec.end(), 1), 3);
+  EXPECT_EQ(sgi::count_if(par, vec.begin(), vec.end(),
+                          [](int64_t x) { return x == 0; }),
+            static_cast<ptrdiff_t>(N - 4));
+}
+
+// elements the simd kernels search, in blocks
+TEST(Execution, find_count_simd) {
+  sgi::ThreadPool pool(3);
+  auto par = sgi::execution::par.on(pool);
+  sgi::vector<uint8_t> bytes(N, 0);
+  sgi::vector<float> floats(N, 0.5f);
+  bytes[N - 2] = bytes[N / 2] = 7;
+  floats[N / 3] = floats[N / 4] = -1.0f;
+  EXPECT_EQ(sgi::find(par, bytes.begin(), bytes.end(), 7),
+            bytes.begin() + N / 2);
+  EXPECT_EQ(sgi::count(par, bytes.begin(), bytes.end(), 7), 2);
+  EXPECT_EQ(sgi::find(par, bytes.begin(), bytes.end(), 7 + 256), bytes.end());
+  EXPECT_EQ(sgi::find(par, floats.begin(), floats.end(), -1.0),
+            floats.begin() + N / 4);
+  EXPECT_EQ(sgi::count(par, floats.begin(), floats.end(), 0.5f),
+            static_cast<ptrdiff_t>(N - 2));
+  EXPECT_EQ(sgi::count(sgi::execution::seq, floats.begin(), floats.end(),
+                       -1.0f),
+            2);
+}
+
+TEST(Execution, exceptions) {
+  sgi::ThreadPool pool(3);
+  sgi::vector<int64_t> vec = Iota(N);
+  std::atomic<size_t> visited{0};
+  EXPECT_THROW(sgi::for_each(sgi::execution::par.on(pool), vec.begin(),
+                             vec.end(),
+                             [&](int64_t x) {
+                               visited++;
+                               if (x == 12345) {
+                                 throw std::runtime_error("element");
+                               }
+                             }),
+               std::runtime_error);
+  EXPECT_GT(visited, 12345);
+}
+
+// list iterators are not random access, so run on the calling thread
+TEST(Execution, sequential_fallback) {
+  sgi::list<int> list;
+  for (int i = 0; i < 100; i++) {
+    list.push_back(i);
+  }
+  auto par = sgi::execution::par;
+  sgi::for_each(par, list.begin(), list.end(), [](int& x) { x *= 3; });
+  EXPECT_EQ(sgi::reduce(par, list.begin(), list.end()), 3 * 99 * 100 / 2);
+  EXPECT_EQ(sgi::count_if(par, list.begin(), list.end(),
+                          [](int x) { return x % 2 == 0; }),
+            50);
+  EXPECT_EQ(*sgi::find(par, list.begin(), list.end(), 30), 30);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
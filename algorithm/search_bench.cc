@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#include "algo.h"
+#include "benchmark/benchmark.h"
+#include "vector.h"
+
+template <typename T>
+sgi::vector<T> Values(size_t n) {
+  sgi::vector<T> vec;
+  vec.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    vec.push_back(static_cast<T>(i * 7 % 100));
+  }
+  return vec;
+}
+
+// Each runs the sgi or the std algorithm over the whole of a, which never
+// holds 100, and b, which equals a.
+
+struct Find {
+  template <bool Std, typename T>
+  static auto Run(const sgi::vector<T>& a, const sgi::vector<T>&) {
+    if constexpr (Std) {
+      return std::find(a.begin(), a.end(), T(100));
+    } else {
+      return sgi::find(a.begin(), a.end(), T(100));
+    }
+  }
+};
+
+struct Count {
+  template <bool Std, typename T>
+  static auto Run(const sgi::vector<T>& a, const sgi::vector<T>&) {
+    if constexpr (Std) {
+      return std::count(a.begin(), a.end(), T(7));
+    } else {
+      return sgi::count(a.begin(), a.end(), T(7));
+    }
+  }
+};
+
+struct Equal {
+  template <bool Std, typename T>
+  static auto Run(const sgi::vector<T>& a, const sgi::vector<T>& b) {
+    if constexpr (Std) {
+      return std::equal(a.begin(), a.end(), b.begin());
+    } else {
+      return sgi::equal(a.begin(), a.end(), b.begin());
+    }
+  }
+};
+
+struct Mismatch {
+  template <bool Std, typename T>
+  static auto Run(const sgi::vector<T>& a, const sgi::vector<T>& b) {
+    if constexpr (Std) {
+      return std::mismatch(a.begin(), a.end(), b.begin()).first;
+    } else {
+      return sgi::mismatch(a.begin(), a.end(), b.begin()).first;
+    }
+  }
+};
+
+struct MinElement {
+  template <bool Std, typename T>
+  static auto Run(const sgi::vector<T>& a, const sgi::vector<T>&) {
+    if constexpr (Std) {
+      return std::min_element(a.begin(), a.end());
+    } else {
+      return sgi::min_element(a.begin(), a.end());
+    }
+  }
+};
+
+struct MaxElement {
+  template <bool Std, typename T>
+  static auto Run(const sgi::vector<T>& a, const sgi::vector<T>&) {
+    if constexpr (Std) {
+      return std::max_element(a.begin(), a.end());
+    } else {
+      return sgi::max_element(a.begin(), a.end());
+    }
+  }
+};
+
+// Searches range(0) bytes of T, counting those of b for the two range ones.
+template <typename Algorithm, typename T, bool Std>
+static void BM_Search(benchmark::State& state) {
+  size_t n = state.range(0) / sizeof(T);
+  sgi::vector<T> a = Values<T>(n);
+  sgi::vector<T> b = Values<T>(n);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Algorithm::template Run<Std>(a, b));
+  }
+  bool two_ranges = std::is_same_v<Algorithm, Equal> ||
+                    std::is_same_v<Algorithm, Mismatch>;
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          (two_ranges ? 2 : 1));
+}
+
+// 64 KB in the L2 cache, 64 MB from memory
+#define BENCHMARK_SEARCH(Algorithm, T)                 \
+  BENCHMARK_TEMPLATE(BM_Search, Algorithm, T, false)   \
+      ->Arg(64 << 10)                                  \
+      ->Arg(64 << 20);                                 \
+  BENCHMARK_TEMPLATE(BM_Search, Algorithm, T, true)    \
+      ->Arg(64 << 10)                                  \
+      ->Arg(64 << 20)
+
+#define BENCHMARK_SEARCH_TYPES(Algorithm) \
+  BENCHMARK_SEARCH(Algorithm, int32_t);   \
+  BENCHMARK_SEARCH(Algorithm, uint8_t);   \
+  BENCHMARK_SEARCH(Algorithm, float)
+
+BENCHMARK_SEARCH_TYPES(Find);
+BENCHMARK_SEARCH_TYPES(Count);
+BENCHMARK_SEARCH_TYPES(Equal);
+BENCHMARK_SEARCH_TYPES(Mismatch);
+BENCHMARK_SEARCH_TYPES(MinElement);
+BENCHMARK_SEARCH_TYPES(MaxElement);
+
+BENCHMARK_MAIN();
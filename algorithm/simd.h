@@ -0,0 +1,837 @@
+#ifndef ALGORITHM_SIMD_H_
+#define ALGORITHM_SIMD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#ifdef __x86_64__
+#include <cpuid.h>
+#include <immintrin.h>
+#include <unistd.h>
+#define SGI_SIMD 1
+#endif  // __x86_64__
+
+namespace sgi {
+
+// Vectorized fill and copy of raw bytes, behind sgi::fill and sgi::copy in
+// algobase.h. Each instruction set has its own kernels, compiled with target
+// attributes so that the rest of the library needs no -m flags, and the best
+// one the CPU and the OS support is picked at the first call, from CPUID.
+// Setting SGI_SIMD to sse2, avx2 or avx512 in the environment caps it, to
+// compare them.
+//
+// Stores bigger than the non-temporal threshold bypass the cache, so that
+// filling or copying a large buffer does not evict the working set. Like
+// glibc, the threshold is three quarters of the last level cache.
+//
+// Search kernels for arrays of int32_t, uint8_t or float back find, count,
+// mismatch, equal, min_element and max_element in algobase.h and algo.h.
+// SSE2, part of x86-64, has all the comparisons they need, and the AVX-512
+// level runs the AVX2 ones.
+namespace simd {
+
+enum class Level { SCALAR, SSE2, AVX2, AVX512 };
+
+// Fills bytes at dst with the 16-byte pattern repeated. pattern holds it
+// twice, so that pattern + k is the pattern starting at its k-th byte.
+using FillFn = void (*)(void* dst, size_t bytes, const unsigned char* pattern,
+                        size_t non_temporal_bytes);
+// Copies bytes from src to dst, which do not overlap.
+using CopyFn = void (*)(void* dst, const void* src, size_t bytes,
+                        size_t non_temporal_bytes);
+
+struct Kernels {
+  Level level;
+  const char* name;
+  FillFn fill;
+  CopyFn copy;
+  size_t non_temporal_bytes;
+};
+
+inline void FillScalar(void* dst, size_t bytes, const unsigned char* pattern,
+                       size_t) {
+  // the filled part doubles at each step, a whole number of patterns
+  char* d = static_cast<char*>(dst);
+  size_t done = bytes < 16 ? bytes : 16;
+  memcpy(d, pattern, done);
+  while (done < bytes) {
+    size_t chunk = done < bytes - done ? done : bytes - done;
+    memcpy(d + done, d, chunk);
+    done += chunk;
+  }
+}
+
+inline void CopyScalar(void* dst, const void* src, size_t bytes, size_t) {
+  memcpy(dst, src, bytes);
+}
+
+// Search kernels, on n elements at p.
+template <typename T>
+struct SearchKernels {
+  Level level;
+  const char* name;
+  // index of the first element equal to value, n if none
+  size_t (*find)(const T* p, size_t n, T value);
+  size_t (*count)(const T* p, size_t n, T value);
+  // index of the first element of a that differs from b's, n if none
+  size_t (*mismatch)(const T* a, const T* b, size_t n);
+  // Stores the least, or greatest, of n > 0 elements in result. Returns
+  // false if one is a NaN, which does not order, leaving it to the caller.
+  bool (*min)(const T* p, size_t n, T* result);
+  bool (*max)(const T* p, size_t n, T* result);
+};
+
+template <typename T>
+inline bool IsNan(T value) {
+  if constexpr (std::is_floating_point_v<T>) {
+    return value != value;
+  } else {
+    return false;
+  }
+}
+
+template <typename T>
+inline size_t FindScalar(const T* p, size_t n, T value) {
+  size_t i = 0;
+  while (i < n && !(p[i] == value)) {
+    i++;
+  }
+  return i;
+}
+
+template <typename T>
+inline size_t CountScalar(const T* p, size_t n, T value) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    count += p[i] == value;
+  }
+  return count;
+}
+
+template <typename T>
+inline size_t MismatchScalar(const T* a, const T* b, size_t n) {
+  size_t i = 0;
+  while (i < n && a[i] == b[i]) {
+    i++;
+  }
+  return i;
+}
+
+// max or min of best and the elements [i, n) at p
+template <typename T, bool Max>
+inline bool ExtremumScalar(const T* p, size_t i, size_t n, T* best) {
+  for (; i < n; i++) {
+    if (IsNan(p[i])) {
+      return false;
+    }
+    if (Max ? *best < p[i] : p[i] < *best) {
+      *best = p[i];
+    }
+  }
+  return true;
+}
+
+template <typename T>
+inline bool MinScalar(const T* p, size_t n, T* result) {
+  *result = p[0];
+  return ExtremumScalar<T, false>(p, 0, n, result);
+}
+
+template <typename T>
+inline bool MaxScalar(const T* p, size_t n, T* result) {
+  *result = p[0];
+  return ExtremumScalar<T, true>(p, 0, n, result);
+}
+
+#ifdef SGI_SIMD
+
+// Loads and stores of one vector at a byte address, the aligned ones at a
+// multiple of the vector size.
+inline __m128i Load128(const void* p) {
+  return _mm_loadu_si128(static_cast<const __m128i*>(p));
+}
+inline void StoreU128(void* p, __m128i v) {
+  _mm_storeu_si128(static_cast<__m128i*>(p), v);
+}
+inline void Store128(void* p, __m128i v) {
+  _mm_store_si128(static_cast<__m128i*>(p), v);
+}
+inline void Stream128(void* p, __m128i v) {
+  _mm_stream_si128(static_cast<__m128i*>(p), v);
+}
+
+__attribute__((target("avx2"))) inline __m256i Load256(const void* p) {
+  return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+}
+__attribute__((target("avx2"))) inline __m256i Broadcast256(const void* p) {
+  return _mm256_broadcastsi128_si256(Load128(p));
+}
+__attribute__((target("avx2"))) inline void StoreU256(void* p, __m256i v) {
+  _mm256_storeu_si256(static_cast<__m256i*>(p), v);
+}
+__attribute__((target("avx2"))) inline void Store256(void* p, __m256i v) {
+  _mm256_store_si256(static_cast<__m256i*>(p), v);
+}
+__attribute__((target("avx2"))) inline void Stream256(void* p, __m256i v) {
+  _mm256_stream_si256(static_cast<__m256i*>(p), v);
+}
+
+__attribute__((target("avx512f"))) inline __m512i Load512(const void* p) {
+  return _mm512_loadu_si512(p);
+}
+__attribute__((target("avx512f"))) inline __m512i Broadcast512(
+    const void* p) {
+  // The unmasked form merges into an undefined vector, which GCC reports as
+  // used uninitialized; a full zeroing mask emits the same broadcast.
+  return _mm512_maskz_broadcast_i32x4(0xffff, Load128(p));
+}
+__attribute__((target("avx512f"))) inline void StoreU512(void* p, __m512i v) {
+  _mm512_storeu_si512(p, v);
+}
+__attribute__((target("avx512f"))) inline void Store512(void* p, __m512i v) {
+  _mm512_store_si512(p, v);
+}
+__attribute__((target("avx512f"))) inline void Stream512(void* p, __m512i v) {
+  _mm512_stream_si512(static_cast<__m512i*>(p), v);
+}
+
+// Every kernel stores the first and the last vector unaligned, and the ones
+// between aligned, overlapping the ends. Ranges shorter than a vector go to
+// the next smaller kernel.
+
+inline void FillSse2(void* dst, size_t bytes, const unsigned char* pattern,
+                     size_t non_temporal_bytes) {
+  if (bytes < 16) {
+    return FillScalar(dst, bytes, pattern, 0);
+  }
+  char* d = static_cast<char*>(dst);
+  size_t i = 16 - reinterpret_cast<uintptr_t>(d) % 16;
+  __m128i body = Load128(pattern + i % 16);
+  StoreU128(d, Load128(pattern));
+  StoreU128(d + bytes - 16, Load128(pattern + (bytes - 16) % 16));
+  if (bytes >= non_temporal_bytes) {
+    for (; i + 16 <= bytes; i += 16) {
+      Stream128(d + i, body);
+    }
+    _mm_sfence();
+    return;
+  }
+  for (; i + 64 <= bytes; i += 64) {
+    Store128(d + i, body);
+    Store128(d + i + 16, body);
+    Store128(d + i + 32, body);
+    Store128(d + i + 48, body);
+  }
+  for (; i + 16 <= bytes; i += 16) {
+    Store128(d + i, body);
+  }
+}
+
+__attribute__((target("avx2"))) inline void FillAvx2(
+    void* dst, size_t bytes, const unsigned char* pattern,
+    size_t non_temporal_bytes) {
+  if (bytes < 32) {
+    return FillSse2(dst, bytes, pattern, non_temporal_bytes);
+  }
+  char* d = static_cast<char*>(dst);
+  size_t i = 32 - reinterpret_cast<uintptr_t>(d) % 32;
+  __m256i body = Broadcast256(pattern + i % 16);
+  StoreU256(d, Broadcast256(pattern));
+  StoreU256(d + bytes - 32, Broadcast256(pattern + (bytes - 32) % 16));
+  if (bytes >= non_temporal_bytes) {
+    for (; i + 32 <= bytes; i += 32) {
+      Stream256(d + i, body);
+    }
+    _mm_sfence();
+    return;
+  }
+  for (; i + 128 <= bytes; i += 128) {
+    Store256(d + i, body);
+    Store256(d + i + 32, body);
+    Store256(d + i + 64, body);
+    Store256(d + i + 96, body);
+  }
+  for (; i + 32 <= bytes; i += 32) {
+    Store256(d + i, body);
+  }
+}
+
+__attribute__((target("avx512f"))) inline void FillAvx512(
+    void* dst, size_t bytes, const unsigned char* pattern,
+    size_t non_temporal_bytes) {
+  if (bytes < 64) {
+    return FillAvx2(dst, bytes, pattern, non_temporal_bytes);
+  }
+  char* d = static_cast<char*>(dst);
+  size_t i = 64 - reinterpret_cast<uintptr_t>(d) % 64;
+  __m512i body = Broadcast512(pattern + i % 16);
+  StoreU512(d, Broadcast512(pattern));
+  StoreU512(d + bytes - 64, Broadcast512(pattern + (bytes - 64) % 16));
+  if (bytes >= non_temporal_bytes) {
+    for (; i + 64 <= bytes; i += 64) {
+      Stream512(d + i, body);
+    }
+    _mm_sfence();
+    return;
+  }
+  for (; i + 256 <= bytes; i += 256) {
+    Store512(d + i, body);
+    Store512(d + i + 64, body);
+    Store512(d + i + 128, body);
+    Store512(d + i + 192, body);
+  }
+  for (; i + 64 <= bytes; i += 64) {
+    Store512(d + i, body);
+  }
+}
+
+// The copy kernels load the ends before storing anything.
+
+inline void CopySse2(void* dst, const void* src, size_t bytes,
+                     size_t non_temporal_bytes) {
+  if (bytes < 16) {
+    return CopyScalar(dst, src, bytes, 0);
+  }
+  char* d = static_cast<char*>(dst);
+  const char* s = static_cast<const char*>(src);
+  __m128i head = Load128(s);
+  __m128i tail = Load128(s + bytes - 16);
+  size_t i = 16 - reinterpret_cast<uintptr_t>(d) % 16;
+  if (bytes >= non_temporal_bytes) {
+    for (; i + 16 <= bytes; i += 16) {
+      Stream128(d + i, Load128(s + i));
+    }
+    _mm_sfence();
+  } else {
+    for (; i + 64 <= bytes; i += 64) {
+      __m128i v0 = Load128(s + i);
+      __m128i v1 = Load128(s + i + 16);
+      __m128i v2 = Load128(s + i + 32);
+      __m128i v3 = Load128(s + i + 48);
+      Store128(d + i, v0);
+      Store128(d + i + 16, v1);
+      Store128(d + i + 32, v2);
+      Store128(d + i + 48, v3);
+    }
+    for (; i + 16 <= bytes; i += 16) {
+      Store128(d + i, Load128(s + i));
+    }
+  }
+  StoreU128(d, head);
+  StoreU128(d + bytes - 16, tail);
+}
+
+__attribute__((target("avx2"))) inline void CopyAvx2(
+    void* dst, const void* src, size_t bytes, size_t non_temporal_bytes) {
+  if (bytes < 32) {
+    return CopySse2(dst, src, bytes, non_temporal_bytes);
+  }
+  char* d = static_cast<char*>(dst);
+  const char* s = static_cast<const char*>(src);
+  __m256i head = Load256(s);
+  __m256i tail = Load256(s + bytes - 32);
+  size_t i = 32 - reinterpret_cast<uintptr_t>(d) % 32;
+  if (bytes >= non_temporal_bytes) {
+    for (; i + 32 <= bytes; i += 32) {
+      Stream256(d + i, Load256(s + i));
+    }
+    _mm_sfence();
+  } else {
+    for (; i + 128 <= bytes; i += 128) {
+      __m256i v0 = Load256(s + i);
+      __m256i v1 = Load256(s + i + 32);
+      __m256i v2 = Load256(s + i + 64);
+      __m256i v3 = Load256(s + i + 96);
+      Store256(d + i, v0);
+      Store256(d + i + 32, v1);
+      Store256(d + i + 64, v2);
+      Store256(d + i + 96, v3);
+    }
+    for (; i + 32 <= bytes; i += 32) {
+      Store256(d + i, Load256(s + i));
+    }
+  }
+  StoreU256(d, head);
+  StoreU256(d + bytes - 32, tail);
+}
+
+__attribute__((target("avx512f"))) inline void CopyAvx512(
+    void* dst, const void* src, size_t bytes, size_t non_temporal_bytes) {
+  if (bytes < 64) {
+    return CopyAvx2(dst, src, bytes, non_temporal_bytes);
+  }
+  char* d = static_cast<char*>(dst);
+  const char* s = static_cast<const char*>(src);
+  __m512i head = Load512(s);
+  __m512i tail = Load512(s + bytes - 64);
+  size_t i = 64 - reinterpret_cast<uintptr_t>(d) % 64;
+  if (bytes >= non_temporal_bytes) {
+    for (; i + 64 <= bytes; i += 64) {
+      Stream512(d + i, Load512(s + i));
+    }
+    _mm_sfence();
+  } else {
+    for (; i + 256 <= bytes; i += 256) {
+      __m512i v0 = Load512(s + i);
+      __m512i v1 = Load512(s + i + 64);
+      __m512i v2 = Load512(s + i + 128);
+      __m512i v3 = Load512(s + i + 192);
+      Store512(d + i, v0);
+      Store512(d + i + 64, v1);
+      Store512(d + i + 128, v2);
+      Store512(d + i + 192, v3);
+    }
+    for (; i + 64 <= bytes; i += 64) {
+      Store512(d + i, Load512(s + i));
+    }
+  }
+  StoreU512(d, head);
+  StoreU512(d + bytes - 64, tail);
+}
+
+// Vectors of int32_t, uint8_t or float, held as integer vectors for the
+// loads and stores above. Eq sets the lanes of equal elements, so that its
+// byte mask has sizeof(T) bits per element.
+
+template <typename T>
+inline __m128i Splat128(T value) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm_set1_epi8(static_cast<char>(value));
+  } else if constexpr (std::is_floating_point_v<T>) {
+    return _mm_castps_si128(_mm_set1_ps(value));
+  } else {
+    return _mm_set1_epi32(value);
+  }
+}
+
+template <typename T>
+inline __m128i Eq128(__m128i a, __m128i b) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm_cmpeq_epi8(a, b);
+  } else if constexpr (std::is_floating_point_v<T>) {
+    return _mm_castps_si128(
+        _mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+  } else {
+    return _mm_cmpeq_epi32(a, b);
+  }
+}
+
+inline unsigned Mask128(__m128i v) {
+  return static_cast<unsigned>(_mm_movemask_epi8(v));
+}
+
+template <typename T>
+inline __m128i Nan128(__m128i v) {
+  if constexpr (std::is_floating_point_v<T>) {
+    __m128 f = _mm_castsi128_ps(v);
+    return _mm_castps_si128(_mm_cmpunord_ps(f, f));
+  } else {
+    return _mm_setzero_si128();
+  }
+}
+
+template <typename T, bool Max>
+inline __m128i Extremum128(__m128i a, __m128i b) {
+  if constexpr (sizeof(T) == 1) {
+    return Max ? _mm_max_epu8(a, b) : _mm_min_epu8(a, b);
+  } else if constexpr (std::is_floating_point_v<T>) {
+    __m128 x = _mm_castsi128_ps(a);
+    __m128 y = _mm_castsi128_ps(b);
+    return _mm_castps_si128(Max ? _mm_max_ps(x, y) : _mm_min_ps(x, y));
+  } else {
+    // pminsd and pmaxsd came with SSE4.1
+    __m128i b_wins = Max ? _mm_cmplt_epi32(a, b) : _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(b_wins, b),
+                        _mm_andnot_si128(b_wins, a));
+  }
+}
+
+// Sums the per-lane counts of Count, lanes of T.
+template <typename T>
+inline size_t SumCounts128(__m128i counts) {
+  if constexpr (sizeof(T) == 1) {
+    __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+    return static_cast<size_t>(_mm_cvtsi128_si64(sums)) +
+           static_cast<size_t>(_mm_cvtsi128_si64(_mm_srli_si128(sums, 8)));
+  } else {
+    alignas(16) uint32_t lanes[4];
+    Store128(lanes, counts);
+    return size_t{lanes[0]} + lanes[1] + lanes[2] + lanes[3];
+  }
+}
+
+template <typename T>
+__attribute__((target("avx2"))) inline __m256i Splat256(T value) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm256_set1_epi8(static_cast<char>(value));
+  } else if constexpr (std::is_floating_point_v<T>) {
+    return _mm256_castps_si256(_mm256_set1_ps(value));
+  } else {
+    return _mm256_set1_epi32(value);
+  }
+}
+
+template <typename T>
+__attribute__((target("avx2"))) inline __m256i Eq256(__m256i a, __m256i b) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm256_cmpeq_epi8(a, b);
+  } else if constexpr (std::is_floating_point_v<T>) {
+    return _mm256_castps_si256(_mm256_cmp_ps(
+        _mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_OQ));
+  } else {
+    return _mm256_cmpeq_epi32(a, b);
+  }
+}
+
+__attribute__((target("avx2"))) inline unsigned Mask256(__m256i v) {
+  return static_cast<unsigned>(_mm256_movemask_epi8(v));
+}
+
+template <typename T>
+__attribute__((target("avx2"))) inline __m256i Nan256(__m256i v) {
+  if constexpr (std::is_floating_point_v<T>) {
+    __m256 f = _mm256_castsi256_ps(v);
+    return _mm256_castps_si256(_mm256_cmp_ps(f, f, _CMP_UNORD_Q));
+  } else {
+    return _mm256_setzero_si256();
+  }
+}
+
+template <typename T, bool Max>
+__attribute__((target("avx2"))) inline __m256i Extremum256(__m256i a,
+                                                           __m256i b) {
+  if constexpr (sizeof(T) == 1) {
+    return Max ? _mm256_max_epu8(a, b) : _mm256_min_epu8(a, b);
+  } else if constexpr (std::is_floating_point_v<T>) {
+    __m256 x = _mm256_castsi256_ps(a);
+    __m256 y = _mm256_castsi256_ps(b);
+    return _mm256_castps_si256(Max ? _mm256_max_ps(x, y)
+                                   : _mm256_min_ps(x, y));
+  } else {
+    return Max ? _mm256_max_epi32(a, b) : _mm256_min_epi32(a, b);
+  }
+}
+
+template <typename T>
+__attribute__((target("avx2"))) inline size_t SumCounts256(__m256i counts) {
+  if constexpr (sizeof(T) == 1) {
+    __m256i sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+    alignas(32) uint64_t lanes[4];
+    Store256(lanes, sums);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  } else {
+    alignas(32) uint32_t lanes[8];
+    Store256(lanes, counts);
+    size_t sum = 0;
+    for (uint32_t lane : lanes) {
+      sum += lane;
+    }
+    return sum;
+  }
+}
+
+// The search kernels test four vectors per step, and the elements past the
+// last whole vector one at a time.
+
+template <typename T>
+inline size_t FindSse2(const T* p, size_t n, T value) {
+  constexpr size_t LANES = 16 / sizeof(T);
+  __m128i needle = Splat128(value);
+  size_t i = 0;
+  for (; i + 4 * LANES <= n; i += 4 * LANES) {
+    __m128i e0 = Eq128<T>(Load128(p + i), needle);
+    __m128i e1 = Eq128<T>(Load128(p + i + LANES), needle);
+    __m128i e2 = Eq128<T>(Load128(p + i + 2 * LANES), needle);
+    __m128i e3 = Eq128<T>(Load128(p + i + 3 * LANES), needle);
+    if (Mask128(_mm_or_si128(_mm_or_si128(e0, e1), _mm_or_si128(e2, e3)))) {
+      break;  // found below
+    }
+  }
+  for (; i + LANES <= n; i += LANES) {
+    unsigned mask = Mask128(Eq128<T>(Load128(p + i), needle));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask) / sizeof(T);
+    }
+  }
+  return i + FindScalar(p + i, n - i, value);
+}
+
+// Each lane counts its matches, which 8-bit lanes can do for 255 vectors.
+template <typename T>
+inline size_t CountSse2(const T* p, size_t n, T value) {
+  constexpr size_t LANES = 16 / sizeof(T);
+  constexpr size_t FLUSH = sizeof(T) == 1 ? 255 : size_t{1} << 30;
+  __m128i needle = Splat128(value);
+  size_t count = 0;
+  size_t i = 0;
+  while (i + LANES <= n) {
+    __m128i counts = _mm_setzero_si128();
+    for (size_t k = 0; k < FLUSH && i + LANES <= n; k++, i += LANES) {
+      __m128i eq = Eq128<T>(Load128(p + i), needle);
+      counts = sizeof(T) == 1 ? _mm_sub_epi8(counts, eq)
+                              : _mm_sub_epi32(counts, eq);
+    }
+    count += SumCounts128<T>(counts);
+  }
+  return count + CountScalar(p + i, n - i, value);
+}
+
+template <typename T>
+inline size_t MismatchSse2(const T* a, const T* b, size_t n) {
+  constexpr size_t LANES = 16 / sizeof(T);
+  size_t i = 0;
+  for (; i + 4 * LANES <= n; i += 4 * LANES) {
+    __m128i e0 = Eq128<T>(Load128(a + i), Load128(b + i));
+    __m128i e1 = Eq128<T>(Load128(a + i + LANES), Load128(b + i + LANES));
+    __m128i e2 =
+        Eq128<T>(Load128(a + i + 2 * LANES), Load128(b + i + 2 * LANES));
+    __m128i e3 =
+        Eq128<T>(Load128(a + i + 3 * LANES), Load128(b + i + 3 * LANES));
+    if (Mask128(_mm_and_si128(_mm_and_si128(e0, e1),
+                              _mm_and_si128(e2, e3))) != 0xffff) {
+      break;
+    }
+  }
+  for (; i + LANES <= n; i += LANES) {
+    unsigned mask = Mask128(Eq128<T>(Load128(a + i), Load128(b + i)));
+    if (mask != 0xffff) {
+      return i + __builtin_ctz(~mask) / sizeof(T);
+    }
+  }
+  return i + MismatchScalar(a + i, b + i, n - i);
+}
+
+template <typename T, bool Max>
+inline bool ExtremumSse2(const T* p, size_t n, T* result) {
+  constexpr size_t LANES = 16 / sizeof(T);
+  *result = p[0];
+  if (n < LANES) {
+    return ExtremumScalar<T, Max>(p, 0, n, result);
+  }
+  __m128i best = Load128(p);
+  __m128i nan = Nan128<T>(best);
+  size_t i = LANES;
+  for (; i + LANES <= n; i += LANES) {
+    __m128i v = Load128(p + i);
+    best = Extremum128<T, Max>(best, v);
+    nan = _mm_or_si128(nan, Nan128<T>(v));
+  }
+  if (Mask128(nan) != 0) {
+    return false;
+  }
+  alignas(16) T lanes[LANES];
+  Store128(lanes, best);
+  return ExtremumScalar<T, Max>(lanes, 0, LANES, result) &&
+         ExtremumScalar<T, Max>(p, i, n, result);
+}
+
+template <typename T>
+__attribute__((target("avx2"))) inline size_t FindAvx2(const T* p, size_t n,
+                                                       T value) {
+  constexpr size_t LANES = 32 / sizeof(T);
+  __m256i needle = Splat256(value);
+  size_t i = 0;
+  for (; i + 4 * LANES <= n; i += 4 * LANES) {
+    __m256i e0 = Eq256<T>(Load256(p + i), needle);
+    __m256i e1 = Eq256<T>(Load256(p + i + LANES), needle);
+    __m256i e2 = Eq256<T>(Load256(p + i + 2 * LANES), needle);
+    __m256i e3 = Eq256<T>(Load256(p + i + 3 * LANES), needle);
+    if (Mask256(_mm256_or_si256(_mm256_or_si256(e0, e1),
+                                _mm256_or_si256(e2, e3)))) {
+      break;  // found below
+    }
+  }
+  for (; i + LANES <= n; i += LANES) {
+    unsigned mask = Mask256(Eq256<T>(Load256(p + i), needle));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask) / sizeof(T);
+    }
+  }
+  return i + FindScalar(p + i, n - i, value);
+}
+
+template <typename T>
+__attribute__((target("avx2"))) inline size_t CountAvx2(const T* p, size_t n,
+                                                        T value) {
+  constexpr size_t LANES = 32 / sizeof(T);
+  constexpr size_t FLUSH = sizeof(T) == 1 ? 255 : size_t{1} << 30;
+  __m256i needle = Splat256(value);
+  size_t count = 0;
+  size_t i = 0;
+  while (i + LANES <= n) {
+    __m256i counts = _mm256_setzero_si256();
+    for (size_t k = 0; k < FLUSH && i + LANES <= n; k++, i += LANES) {
+      __m256i eq = Eq256<T>(Load256(p + i), needle);
+      counts = sizeof(T) == 1 ? _mm256_sub_epi8(counts, eq)
+                              : _mm256_sub_epi32(counts, eq);
+    }
+    count += SumCounts256<T>(counts);
+  }
+  return count + CountScalar(p + i, n - i, value);
+}
+
+template <typename T>
+__attribute__((target("avx2"))) inline size_t MismatchAvx2(const T* a,
+                                                           const T* b,
+                                                           size_t n) {
+  constexpr size_t LANES = 32 / sizeof(T);
+  size_t i = 0;
+  for (; i + 4 * LANES <= n; i += 4 * LANES) {
+    __m256i e0 = Eq256<T>(Load256(a + i), Load256(b + i));
+    __m256i e1 = Eq256<T>(Load256(a + i + LANES), Load256(b + i + LANES));
+    __m256i e2 =
+        Eq256<T>(Load256(a + i + 2 * LANES), Load256(b + i + 2 * LANES));
+    __m256i e3 =
+        Eq256<T>(Load256(a + i + 3 * LANES), Load256(b + i + 3 * LANES));
+    if (Mask256(_mm256_and_si256(_mm256_and_si256(e0, e1),
+                                 _mm256_and_si256(e2, e3))) != 0xffffffff) {
+      break;
+    }
+  }
+  for (; i + LANES <= n; i += LANES) {
+    unsigned mask = Mask256(Eq256<T>(Load256(a + i), Load256(b + i)));
+    if (mask != 0xffffffff) {
+      return i + __builtin_ctz(~mask) / sizeof(T);
+    }
+  }
+  return i + MismatchScalar(a + i, b + i, n - i);
+}
+
+template <typename T, bool Max>
+__attribute__((target("avx2"))) inline bool ExtremumAvx2(const T* p, size_t n,
+                                                         T* result) {
+  constexpr size_t LANES = 32 / sizeof(T);
+  if (n < LANES) {
+    return ExtremumSse2<T, Max>(p, n, result);
+  }
+  *result = p[0];
+  __m256i best = Load256(p);
+  __m256i nan = Nan256<T>(best);
+  size_t i = LANES;
+  for (; i + LANES <= n; i += LANES) {
+    __m256i v = Load256(p + i);
+    best = Extremum256<T, Max>(best, v);
+    nan = _mm256_or_si256(nan, Nan256<T>(v));
+  }
+  if (Mask256(nan) != 0) {
+    return false;
+  }
+  alignas(32) T lanes[LANES];
+  Store256(lanes, best);
+  return ExtremumScalar<T, Max>(lanes, 0, LANES, result) &&
+         ExtremumScalar<T, Max>(p, i, n, result);
+}
+
+// The best level both the CPU and the OS, which must save the wider
+// registers, support.
+inline Level DetectLevel() {
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) ||
+      !(ecx & bit_AVX)) {
+    return Level::SSE2;
+  }
+  unsigned xcr0_low, xcr0_high;
+  __asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+  bool ymm = (xcr0_low & 0x06) == 0x06;
+  bool zmm = (xcr0_low & 0xe6) == 0xe6;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return Level::SSE2;
+  }
+  if (zmm && (ebx & bit_AVX512F)) {
+    return Level::AVX512;
+  }
+  if (ymm && (ebx & bit_AVX2)) {
+    return Level::AVX2;
+  }
+  return Level::SSE2;
+}
+
+inline size_t DefaultNonTemporalBytes() {
+  long cache = sysconf(_SC_LEVEL3_CACHE_SIZE);
+  if (cache <= 0) {
+    cache = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  }
+  return cache > 0 ? static_cast<size_t>(cache) / 4 * 3 : 6 << 20;
+}
+
+#else
+
+inline Level DetectLevel() { return Level::SCALAR; }
+
+inline size_t DefaultNonTemporalBytes() { return SIZE_MAX; }
+
+#endif  // SGI_SIMD
+
+// The kernels of level, which the CPU must support.
+inline Kernels KernelsFor(Level level) {
+  size_t non_temporal_bytes = DefaultNonTemporalBytes();
+  switch (level) {
+#ifdef SGI_SIMD
+    case Level::AVX512:
+      return {level, "avx512", FillAvx512, CopyAvx512, non_temporal_bytes};
+    case Level::AVX2:
+      return {level, "avx2", FillAvx2, CopyAvx2, non_temporal_bytes};
+    case Level::SSE2:
+      return {level, "sse2", FillSse2, CopySse2, non_temporal_bytes};
+#endif  // SGI_SIMD
+    default:
+      return {Level::SCALAR, "scalar", FillScalar, CopyScalar, SIZE_MAX};
+  }
+}
+
+// The search kernels of level, which the CPU must support.
+template <typename T>
+inline SearchKernels<T> SearchKernelsFor(Level level) {
+  switch (level) {
+#ifdef SGI_SIMD
+    case Level::AVX512:
+    case Level::AVX2:
+      return {Level::AVX2, "avx2", FindAvx2<T>, CountAvx2<T>,
+              MismatchAvx2<T>, ExtremumAvx2<T, false>, ExtremumAvx2<T, true>};
+    case Level::SSE2:
+      return {level, "sse2", FindSse2<T>, CountSse2<T>, MismatchSse2<T>,
+              ExtremumSse2<T, false>, ExtremumSse2<T, true>};
+#endif  // SGI_SIMD
+    default:
+      return {Level::SCALAR, "scalar", FindScalar<T>, CountScalar<T>,
+              MismatchScalar<T>, MinScalar<T>, MaxScalar<T>};
+  }
+}
+
+inline Level SelectLevel() {
+  Level level = DetectLevel();
+  const char* cap = getenv("SGI_SIMD");
+  if (cap == nullptr) {
+    return level;
+  }
+  Level capped = level;
+  if (strcmp(cap, "scalar") == 0) {
+    capped = Level::SCALAR;
+  } else if (strcmp(cap, "sse2") == 0) {
+    capped = Level::SSE2;
+  } else if (strcmp(cap, "avx2") == 0) {
+    capped = Level::AVX2;
+  }
+  return capped < level ? capped : level;
+}
+
+// The kernels in use, selected once.
+inline const Kernels& ActiveKernels() {
+  static const Kernels kernels = KernelsFor(SelectLevel());
+  return kernels;
+}
+
+template <typename T>
+inline const SearchKernels<T>& ActiveSearchKernels() {
+  static const SearchKernels<T> kernels = SearchKernelsFor<T>(SelectLevel());
+  return kernels;
+}
+
+}  // namespace simd
+
+}  // namespace sgi
+
+#endif  // ALGORITHM_SIMD_H_
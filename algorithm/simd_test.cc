@@ -0,0 +1,197 @@
+#include "simd.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+// every level the machine supports
+std::vector<sgi::simd::Kernels> SupportedKernels() {
+  std::vector<sgi::simd::Kernels> kernels;
+  sgi::simd::Level best = sgi::simd::DetectLevel();
+  for (auto level : {sgi::simd::Level::SCALAR, sgi::simd::Level::SSE2,
+                     sgi::simd::Level::AVX2, sgi::simd::Level::AVX512}) {
+    if (level <= best) {
+      kernels.push_back(sgi::simd::KernelsFor(level));
+    }
+  }
+  return kernels;
+}
+
+constexpr size_t GUARD = 64;
+constexpr unsigned char GUARD_BYTE = 0xee;
+
+TEST(Simd, Fill) {
+  unsigned char pattern[32];
+  for (int i = 0; i < 16; i++) {
+    pattern[i] = pattern[i + 16] = static_cast<unsigned char>(i + 1);
+  }
+  std::vector<unsigned char> buffer(1024 + 2 * GUARD);
+  for (const sgi::simd::Kernels& kernels : SupportedKernels()) {
+    // cached and non-temporal stores
+    for (size_t non_temporal_bytes : {SIZE_MAX, size_t(0)}) {
+      for (size_t offset = 0; offset < 64; offset++) {
+        for (size_t bytes = 0; bytes <= 700; bytes += 1 + bytes / 16) {
+          memset(buffer.data(), GUARD_BYTE, buffer.size());
+          unsigned char* dst = buffer.data() + GUARD + offset;
+          kernels.fill(dst, bytes, pattern, non_temporal_bytes);
+          for (size_t i = 0; i < bytes; i++) {
+            ASSERT_EQ(dst[i], i % 16 + 1)
+                << kernels.name << " offset " << offset << " bytes " << bytes;
+          }
+          for (size_t i = 0; i < GUARD; i++) {
+            ASSERT_EQ(dst[-1 - i], GUARD_BYTE) << kernels.name;
+            ASSERT_EQ(dst[bytes + i], GUARD_BYTE) << kernels.name;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(Simd, Copy) {
+  std::vector<unsigned char> src(1024);
+  for (size_t i = 0; i < src.size(); i++) {
+    src[i] = static_cast<unsigned char>(i * 7 + 3);
+  }
+  std::vector<unsigned char> buffer(1024 + 2 * GUARD);
+  for (const sgi::simd::Kernels& kernels : SupportedKernels()) {
+    for (size_t non_temporal_bytes : {SIZE_MAX, size_t(0)}) {
+      for (size_t offset = 0; offset < 64; offset++) {
+        for (size_t bytes = 0; bytes <= 700; bytes += 1 + bytes / 16) {
+          memset(buffer.data(), GUARD_BYTE, buffer.size());
+          unsigned char* dst = buffer.data() + GUARD + offset;
+          kernels.copy(dst, src.data() + offset / 2, bytes,
+                       non_temporal_bytes);
+          ASSERT_EQ(memcmp(dst, src.data() + offset / 2, bytes), 0)
+              << kernels.name << " offset " << offset << " bytes " << bytes;
+          for (size_t i = 0; i < GUARD; i++) {
+            ASSERT_EQ(dst[-1 - i], GUARD_BYTE) << kernels.name;
+            ASSERT_EQ(dst[bytes + i], GUARD_BYTE) << kernels.name;
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+std::vector<sgi::simd::SearchKernels<T>> SupportedSearchKernels() {
+  std::vector<sgi::simd::SearchKernels<T>> kernels;
+  for (const sgi::simd::Kernels& fill_copy : SupportedKernels()) {
+    kernels.push_back(sgi::simd::SearchKernelsFor<T>(fill_copy.level));
+  }
+  return kernels;
+}
+
+// Checks the kernels on every offset and size up to 300 elements of values
+// 0 to 4, against the plain loops.
+template <typename T>
+void CheckSearchKernels() {
+  std::vector<T> a(400);
+  for (size_t i = 0; i < a.size(); i++) {
+    a[i] = static_cast<T>(i * 7 % 5);
+  }
+  for (const auto& kernels : SupportedSearchKernels<T>()) {
+    SCOPED_TRACE(kernels.name);
+    for (size_t offset = 0; offset < 32; offset++) {
+      for (size_t n = 0; n <= 300; n += 1 + n / 16) {
+        const T* p = a.data() + offset;
+        for (T value : {T(0), T(3), T(9)}) {
+          size_t find = 0;
+          while (find < n && p[find] != value) {
+            find++;
+          }
+          size_t count = 0;
+          for (size_t i = 0; i < n; i++) {
+            count += p[i] == value;
+          }
+          ASSERT_EQ(kernels.find(p, n, value), find);
+          ASSERT_EQ(kernels.count(p, n, value), count);
+        }
+
+        std::vector<T> b(p, p + n);
+        ASSERT_EQ(kernels.mismatch(p, b.data(), n), n);
+        for (size_t i = 0; i < n; i += 1 + i / 8) {
+          b[i] = T(8);
+          ASSERT_EQ(kernels.mismatch(p, b.data(), n), i);
+          b[i] = p[i];
+        }
+
+        if (n > 0) {
+          std::vector<T> c(p, p + n);
+          c[n / 2] = T(7);
+          c[n - 1] = std::is_signed_v<T> ? T(-1) : T(0);
+          T min = c[0];
+          T max = c[0];
+          for (T x : c) {
+            min = x < min ? x : min;
+            max = max < x ? x : max;
+          }
+          T result;
+          ASSERT_TRUE(kernels.min(c.data(), n, &result));
+          ASSERT_EQ(result, min);
+          ASSERT_TRUE(kernels.max(c.data(), n, &result));
+          ASSERT_EQ(result, max);
+        }
+      }
+    }
+  }
+}
+
+TEST(Simd, Search) {
+  CheckSearchKernels<int32_t>();
+  CheckSearchKernels<uint8_t>();
+  CheckSearchKernels<float>();
+}
+
+// more than 255 vectors of bytes, past what one lane counter holds
+TEST(Simd, CountBytes) {
+  std::vector<uint8_t> bytes(100000, 1);
+  for (const auto& kernels : SupportedSearchKernels<uint8_t>()) {
+    EXPECT_EQ(kernels.count(bytes.data(), bytes.size(), 1), bytes.size());
+    EXPECT_EQ(kernels.find(bytes.data(), bytes.size(), 0), bytes.size());
+  }
+}
+
+TEST(Simd, SearchFloats) {
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  std::vector<float> a(100, 1.0f);
+  a[40] = -0.0f;
+  a[50] = nan;
+  for (const auto& kernels : SupportedSearchKernels<float>()) {
+    SCOPED_TRACE(kernels.name);
+    // NaN equals nothing, -0.0 equals 0.0
+    EXPECT_EQ(kernels.find(a.data(), a.size(), nan), a.size());
+    EXPECT_EQ(kernels.count(a.data(), a.size(), nan), 0);
+    EXPECT_EQ(kernels.find(a.data(), a.size(), 0.0f), 40);
+    EXPECT_EQ(kernels.mismatch(a.data(), a.data(), a.size()), 50);
+
+    float result;
+    EXPECT_FALSE(kernels.min(a.data(), a.size(), &result));
+    EXPECT_FALSE(kernels.max(a.data() + 3, 60, &result));
+    EXPECT_TRUE(kernels.min(a.data(), 50, &result));
+    EXPECT_EQ(result, 0.0f);
+    EXPECT_TRUE(kernels.max(a.data() + 51, 49, &result));
+    EXPECT_EQ(result, 1.0f);
+  }
+}
+
+TEST(Simd, ActiveKernels) {
+  const sgi::simd::Kernels& kernels = sgi::simd::ActiveKernels();
+  EXPECT_EQ(&kernels, &sgi::simd::ActiveKernels());
+  EXPECT_LE(kernels.level, sgi::simd::DetectLevel());
+  EXPECT_GT(kernels.non_temporal_bytes, 0);
+
+  const auto& search = sgi::simd::ActiveSearchKernels<float>();
+  EXPECT_EQ(&search, &sgi::simd::ActiveSearchKernels<float>());
+  EXPECT_LE(search.level, kernels.level);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,310 @@
+#ifndef ALGORITHM_THREAD_POOL_H_
+#define ALGORITHM_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace sgi {
+
+// Work-stealing pool of worker threads for fork-join parallelism:
+//
+//   pool.Invoke([&] { left(); }, [&] { right(); });
+//
+// runs both functions, possibly at once, and returns when both are done.
+// Every worker has a deque of tasks: Invoke pushes the second function on
+// the deque of the calling worker, runs the first, then runs the second
+// itself unless another worker stole it meanwhile, in which case it runs
+// other tasks until the thief is done. Idle workers steal the oldest task of
+// another worker, which in a recursive split is the largest. Threads outside
+// the pool push their tasks on a shared queue and help the same way while
+// they wait, so nested and concurrent calls share the workers.
+//
+//   pool.Run(ntasks, [&](size_t i) { ... });
+//
+// runs the task for every i in [0, ntasks), split in halves with Invoke.
+class ThreadPool {
+ public:
+  // The thread calling Invoke or Run works too, so ThreadPool(0) runs
+  // everything there.
+  explicit ThreadPool(size_t workers);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // One thread per core, made at the first call.
+  static ThreadPool& Default();
+  // Whether Default has made its pool yet.
+  static bool DefaultStarted() { return default_started_.load(); }
+
+  // How many threads may work on a call, the caller included.
+  size_t concurrency() const { return workers_.size() + 1; }
+
+  // If either function throws, the exception is rethrown once both are done,
+  // that of first if both throw.
+  template <typename F1, typename F2>
+  void Invoke(F1&& first, F2&& second);
+
+  // Every task runs even if some throw, then the first exception thrown is
+  // rethrown, so that the caller can tell which tasks completed.
+  template <typename Fn>
+  void Run(size_t ntasks, Fn&& fn);
+
+ private:
+  // Lives on the stack of Invoke, which waits for it.
+  struct Task {
+    void (*execute)(Task* task);
+    void* fn;
+    std::exception_ptr error;
+    std::atomic<bool> done{false};
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task*> tasks;
+  };
+
+  template <typename Leaf>
+  void RunRange(size_t begin, size_t end, Leaf& leaf);
+
+  void Push(Task* task);
+  // Takes task back if no thread has taken it yet.
+  bool Reclaim(Task* task);
+  // Own tasks newest first, then the shared queue, then the oldest task of
+  // another worker.
+  Task* FindTask();
+  void Work(size_t index);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::mutex shared_mutex_;
+  std::deque<Task*> shared_;  // tasks of threads outside the pool
+  std::atomic<size_t> queued_{0};  // tasks on all the deques
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+
+  // the worker of this thread, if it belongs to a pool
+  static inline thread_local ThreadPool* current_pool_ = nullptr;
+  static inline thread_local size_t current_index_ = 0;
+  static inline std::atomic<bool> default_started_{false};
+};
+
+inline ThreadPool::ThreadPool(size_t workers) {
+  for (size_t i = 0; i < workers; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  threads_.reserve(workers);
+  for (size_t i = 0; i < workers; i++) {
+    threads_.emplace_back([this, i] { Work(i); });
+  }
+}
+
+inline ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+inline ThreadPool& ThreadPool::Default() {
+  static ThreadPool pool(std::thread::hardware_concurrency() > 1
+                             ? std::thread::hardware_concurrency() - 1
+                             : 0);
+  default_started_.store(true);
+  return pool;
+}
+
+template <typename F1, typename F2>
+void ThreadPool::Invoke(F1&& first, F2&& second) {
+  if (workers_.empty()) {
+    std::exception_ptr error;
+    try {
+      first();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    try {
+      second();
+    } catch (...) {
+      if (error == nullptr) {
+        error = std::current_exception();
+      }
+    }
+    if (error != nullptr) {
+      std::rethrow_exception(error);
+    }
+    return;
+  }
+
+  using Second = std::remove_reference_t<F2>;
+  Task task;
+  task.execute = [](Task* task) {
+    try {
+      (*static_cast<Second*>(task->fn))();
+    } catch (...) {
+      task->error = std::current_exception();
+    }
+    task->done.store(true, std::memory_order_release);
+  };
+  task.fn = const_cast<void*>(static_cast<const void*>(&second));
+  Push(&task);
+
+  std::exception_ptr error;
+  try {
+    first();
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  if (Reclaim(&task)) {
+    task.execute(&task);
+  } else {
+    // stolen, help until the thief is done
+    while (!task.done.load(std::memory_order_acquire)) {
+      if (Task* other = FindTask()) {
+        other->execute(other);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+  if (error == nullptr) {
+    error = task.error;
+  }
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+template <typename Fn>
+void ThreadPool::Run(size_t ntasks, Fn&& fn) {
+  std::mutex mutex;
+  std::exception_ptr error;
+  auto leaf = [&](size_t i) {
+    try {
+      fn(i);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (error == nullptr) {
+        error = std::current_exception();
+      }
+    }
+  };
+  RunRange(0, ntasks, leaf);
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+template <typename Leaf>
+void ThreadPool::RunRange(size_t begin, size_t end, Leaf& leaf) {
+  if (end - begin == 1) {
+    leaf(begin);
+  } else if (end - begin > 1) {
+    size_t middle = begin + (end - begin) / 2;
+    Invoke([&] { RunRange(begin, middle, leaf); },
+           [&] { RunRange(middle, end, leaf); });
+  }
+}
+
+inline void ThreadPool::Push(Task* task) {
+  if (current_pool_ == this) {
+    Worker& worker = *workers_[current_index_];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.push_back(task);
+  } else {
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+    shared_.push_back(task);
+  }
+  queued_.fetch_add(1);
+  // a worker checks queued_ under the lock before sleeping
+  { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+  wake_.notify_one();
+}
+
+inline bool ThreadPool::Reclaim(Task* task) {
+  std::mutex& mutex = current_pool_ == this
+                          ? workers_[current_index_]->mutex
+                          : shared_mutex_;
+  std::deque<Task*>& tasks =
+      current_pool_ == this ? workers_[current_index_]->tasks : shared_;
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto it = tasks.rbegin(); it != tasks.rend(); ++it) {
+    if (*it == task) {
+      tasks.erase(std::next(it).base());
+      queued_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+inline ThreadPool::Task* ThreadPool::FindTask() {
+  if (queued_.load() == 0) {
+    return nullptr;
+  }
+  size_t self = current_pool_ == this ? current_index_ : workers_.size();
+  if (self < workers_.size()) {
+    Worker& worker = *workers_[self];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (!worker.tasks.empty()) {
+      Task* task = worker.tasks.back();
+      worker.tasks.pop_back();
+      queued_.fetch_sub(1);
+      return task;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+    if (!shared_.empty()) {
+      Task* task = shared_.front();
+      shared_.pop_front();
+      queued_.fetch_sub(1);
+      return task;
+    }
+  }
+  for (size_t i = 1; i <= workers_.size(); i++) {
+    Worker& victim = *workers_[(self + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      Task* task = victim.tasks.front();
+      victim.tasks.pop_front();
+      queued_.fetch_sub(1);
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+inline void ThreadPool::Work(size_t index) {
+  current_pool_ = this;
+  current_index_ = index;
+  while (true) {
+    if (Task* task = FindTask()) {
+      task->execute(task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    wake_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+    if (stop_) {
+      return;
+    }
+  }
+}
+
+}  // namespace sgi
+
+#endif  // ALGORITHM_THREAD_POOL_H_
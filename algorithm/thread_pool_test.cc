@@ -0,0 +1,90 @@
+#include "thread_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(ThreadPool, Run) {
+  sgi::ThreadPool pool(3);
+  EXPECT_EQ(pool.concurrency(), 4);
+  std::vector<int> counts(1000, 0);
+  pool.Run(counts.size(), [&](size_t i) { counts[i]++; });
+  for (int count : counts) {
+    EXPECT_EQ(count, 1);
+  }
+  pool.Run(0, [](size_t) { FAIL(); });
+
+  // the workers and the caller share the tasks
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  std::atomic<int> started{0};
+  pool.Run(4, [&](size_t) {
+    started++;
+    while (started < 4) {
+      std::this_thread::yield();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    threads.insert(std::this_thread::get_id());
+  });
+  EXPECT_EQ(threads.size(), 4);
+  EXPECT_EQ(threads.count(std::this_thread::get_id()), 1);
+}
+
+TEST(ThreadPool, NoWorkers) {
+  sgi::ThreadPool pool(0);
+  EXPECT_EQ(pool.concurrency(), 1);
+  std::vector<std::thread::id> threads;
+  pool.Run(10, [&](size_t) { threads.push_back(std::this_thread::get_id()); });
+  EXPECT_EQ(threads, std::vector<std::thread::id>(
+                         10, std::this_thread::get_id()));
+}
+
+TEST(ThreadPool, Exceptions) {
+  sgi::ThreadPool pool(3);
+  std::atomic<int> ran{0};
+  EXPECT_THROW(pool.Run(100,
+                        [&](size_t i) {
+                          ran++;
+                          if (i % 10 == 3) {
+                            throw std::runtime_error("task");
+                          }
+                        }),
+               std::runtime_error);
+  EXPECT_EQ(ran, 100);  // the other tasks still ran
+}
+
+TEST(ThreadPool, Nested) {
+  sgi::ThreadPool pool(3);
+  std::atomic<int> sum{0};
+  pool.Run(8, [&](size_t i) {
+    pool.Run(8, [&](size_t j) { sum += i * 8 + j; });
+  });
+  EXPECT_EQ(sum, 63 * 64 / 2);
+}
+
+TEST(ThreadPool, Callers) {
+  sgi::ThreadPool pool(2);
+  std::atomic<long> sum{0};
+  std::vector<std::thread> callers;
+  for (int t = 0; t < 4; t++) {
+    callers.emplace_back([&] {
+      for (int round = 0; round < 100; round++) {
+        pool.Run(16, [&](size_t i) { sum += i; });
+      }
+    });
+  }
+  for (std::thread& caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(sum, 4 * 100 * (15 * 16 / 2));
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,597 @@
+#ifndef ALGORITHM_VIEW_H_
+#define ALGORITHM_VIEW_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "iterator.h"
+#include "vector.h"
+
+namespace sgi {
+namespace view {
+
+// Lazy views over the elements of a container, such as sgi::vector or
+// sgi::list, composed with |:
+//
+//   sgi::vector<double> prices = sgi::view::all(orders)
+//       | sgi::view::filter([](const Order& o) { return o.open; })
+//       | sgi::view::transform([](const Order& o) { return o.price; })
+//       | sgi::view::collect();
+//
+// Nothing is computed until the view is iterated, and then in one pass: the
+// iterator of a view wraps that of the view below it, so the stages inline
+// into a single loop over the container without temporary containers. The
+// functions given to the views are kept as they are, so a lambda inlines
+// into that loop where a function pointer stays an indirect call.
+//
+// A view refers to the container it was made from, which must outlive it,
+// and its iterators to the view, which must outlive them too. Views are
+// cheap to copy, and are kept by value by the views made from them.
+struct view_base {};
+
+template <typename T>
+inline constexpr bool is_view_v =
+    std::is_base_of_v<view_base, std::remove_cv_t<std::remove_reference_t<T>>>;
+
+template <typename Iterator>
+inline constexpr bool is_random_access_iterator_v =
+    std::is_base_of_v<random_access_iterator_tag,
+                      typename iterator_traits<Iterator>::iterator_category>;
+
+// the weaker of two iterator categories
+template <typename Category, typename Bound>
+using min_category_t =
+    std::conditional_t<std::is_base_of_v<Bound, Category>, Bound, Category>;
+
+template <typename View>
+using iterator_t = decltype(std::declval<const View&>().begin());
+
+// Advances it by n, but not past last.
+template <typename Iterator>
+inline Iterator advance_bounded(Iterator it, size_t n, Iterator last) {
+  if constexpr (is_random_access_iterator_v<Iterator>) {
+    auto remaining = static_cast<size_t>(last - it);
+    return it + static_cast<std::ptrdiff_t>(std::min(n, remaining));
+  } else {
+    for (; n > 0 && it != last; n--) {
+      ++it;
+    }
+    return it;
+  }
+}
+
+// [first, last) as a view. Views whose size is known without iterating over
+// them, here those over random access iterators, say so with sized, and
+// collect reserves that size.
+template <typename Iterator>
+class iterator_range : public view_base {
+ public:
+  using iterator = Iterator;
+  static constexpr bool sized = is_random_access_iterator_v<Iterator>;
+
+  iterator_range() = default;
+  iterator_range(Iterator first, Iterator last)
+      : first_(first), last_(last) {}
+
+  Iterator begin() const { return first_; }
+  Iterator end() const { return last_; }
+  bool empty() const { return first_ == last_; }
+  // O(n) unless sized
+  size_t size() const {
+    return static_cast<size_t>(sgi::distance(first_, last_));
+  }
+
+ private:
+  Iterator first_{};
+  Iterator last_{};
+};
+
+// A view of range: itself if it is a view, else its elements. Containers
+// must outlive the view, so temporaries are refused.
+template <typename Range>
+inline auto all(Range&& range) {
+  if constexpr (is_view_v<Range>) {
+    return std::decay_t<Range>(std::forward<Range>(range));
+  } else {
+    static_assert(std::is_lvalue_reference_v<Range>,
+                  "a view cannot outlive a temporary container");
+    return iterator_range<decltype(range.begin())>(range.begin(),
+                                                   range.end());
+  }
+}
+
+template <typename Range>
+using all_t = decltype(view::all(std::declval<Range>()));
+
+// Made by the one-argument forms of the views, to be applied to a range
+// with |.
+template <typename Fn>
+struct adaptor {
+  Fn fn;
+};
+
+template <typename Fn>
+adaptor(Fn) -> adaptor<Fn>;
+
+template <typename Range, typename Fn>
+inline auto operator|(Range&& range, const adaptor<Fn>& adaptor) {
+  return adaptor.fn(std::forward<Range>(range));
+}
+
+// The elements of Base for which pred is true.
+template <typename Base, typename Predicate>
+class filter_view : public view_base {
+  using base_iterator = iterator_t<Base>;
+  using base_traits = iterator_traits<base_iterator>;
+
+ public:
+  class iterator {
+   public:
+    using iterator_category =
+        min_category_t<typename base_traits::iterator_category,
+                       forward_iterator_tag>;
+    using value_type = typename base_traits::value_type;
+    using difference_type = typename base_traits::difference_type;
+    using pointer = typename base_traits::pointer;
+    using reference = typename base_traits::reference;
+
+    iterator() = default;
+    iterator(base_iterator it, base_iterator last, const Predicate* pred)
+        : it_(it), last_(last), pred_(pred) {
+      Satisfy();
+    }
+
+    reference operator*() const { return *it_; }
+    iterator& operator++() {
+      ++it_;
+      Satisfy();
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+    bool operator==(const iterator& other) const { return it_ == other.it_; }
+    bool operator!=(const iterator& other) const { return it_ != other.it_; }
+
+   private:
+    void Satisfy() {
+      while (it_ != last_ && !(*pred_)(*it_)) {
+        ++it_;
+      }
+    }
+
+    base_iterator it_{};
+    base_iterator last_{};
+    const Predicate* pred_ = nullptr;
+  };
+
+  static constexpr bool sized = false;
+
+  filter_view(Base base, Predicate pred)
+      : base_(std::move(base)), pred_(std::move(pred)) {}
+
+  iterator begin() const {
+    return iterator(base_.begin(), base_.end(), &pred_);
+  }
+  iterator end() const { return iterator(base_.end(), base_.end(), &pred_); }
+
+ private:
+  Base base_;
+  Predicate pred_;
+};
+
+template <typename Range, typename Predicate>
+inline auto filter(Range&& range, Predicate pred) {
+  return filter_view<all_t<Range>, Predicate>(
+      view::all(std::forward<Range>(range)), std::move(pred));
+}
+
+template <typename Predicate>
+inline auto filter(Predicate pred) {
+  return adaptor{[pred = std::move(pred)](auto&& range) {
+    return view::filter(std::forward<decltype(range)>(range), pred);
+  }};
+}
+
+// fn applied to each element of Base, when it is dereferenced. Random access
+// if Base is.
+template <typename Base, typename Fn>
+class transform_view : public view_base {
+  using base_iterator = iterator_t<Base>;
+  using base_traits = iterator_traits<base_iterator>;
+
+ public:
+  class iterator {
+   public:
+    using iterator_category =
+        min_category_t<typename base_traits::iterator_category,
+                       random_access_iterator_tag>;
+    using reference =
+        std::invoke_result_t<const Fn&, typename base_traits::reference>;
+    using value_type =
+        std::remove_cv_t<std::remove_reference_t<reference>>;
+    using difference_type = typename base_traits::difference_type;
+    using pointer = void;
+
+    iterator() = default;
+    iterator(base_iterator it, const Fn* fn) : it_(it), fn_(fn) {}
+
+    reference operator*() const { return (*fn_)(*it_); }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    iterator& operator++() {
+      ++it_;
+      return *this;
+    }
+    iterator operator++(int) { return iterator(it_++, fn_); }
+    iterator& operator--() {
+      --it_;
+      return *this;
+    }
+    iterator operator--(int) { return iterator(it_--, fn_); }
+    iterator& operator+=(difference_type n) {
+      it_ += n;
+      return *this;
+    }
+    iterator& operator-=(difference_type n) {
+      it_ -= n;
+      return *this;
+    }
+    iterator operator+(difference_type n) const {
+      return iterator(it_ + n, fn_);
+    }
+    iterator operator-(difference_type n) const {
+      return iterator(it_ - n, fn_);
+    }
+    difference_type operator-(const iterator& other) const {
+      return it_ - other.it_;
+    }
+
+    bool operator==(const iterator& other) const { return it_ == other.it_; }
+    bool operator!=(const iterator& other) const { return it_ != other.it_; }
+    bool operator<(const iterator& other) const { return it_ < other.it_; }
+
+   private:
+    base_iterator it_{};
+    const Fn* fn_ = nullptr;
+  };
+
+  static constexpr bool sized = Base::sized;
+
+  transform_view(Base base, Fn fn)
+      : base_(std::move(base)), fn_(std::move(fn)) {}
+
+  iterator begin() const { return iterator(base_.begin(), &fn_); }
+  iterator end() const { return iterator(base_.end(), &fn_); }
+  size_t size() const { return base_.size(); }
+
+ private:
+  Base base_;
+  Fn fn_;
+};
+
+template <typename Range, typename Fn>
+inline auto transform(Range&& range, Fn fn) {
+  return transform_view<all_t<Range>, Fn>(
+      view::all(std::forward<Range>(range)), std::move(fn));
+}
+
+template <typename Fn>
+inline auto transform(Fn fn) {
+  return adaptor{[fn = std::move(fn)](auto&& range) {
+    return view::transform(std::forward<decltype(range)>(range), fn);
+  }};
+}
+
+// The first n elements of Base, or all of them if it has fewer. Over a sized
+// random access view, these are that view's own iterators.
+template <typename Base>
+class take_view : public view_base {
+  using base_iterator = iterator_t<Base>;
+  using base_traits = iterator_traits<base_iterator>;
+  static constexpr bool random_access =
+      Base::sized && is_random_access_iterator_v<base_iterator>;
+
+ public:
+  // an iterator of Base and how many elements are left to take
+  class counted_iterator {
+   public:
+    using iterator_category =
+        min_category_t<typename base_traits::iterator_category,
+                       forward_iterator_tag>;
+    using value_type = typename base_traits::value_type;
+    using difference_type = typename base_traits::difference_type;
+    using pointer = typename base_traits::pointer;
+    using reference = typename base_traits::reference;
+
+    counted_iterator() = default;
+    counted_iterator(base_iterator it, size_t remaining)
+        : it_(it), remaining_(remaining) {}
+
+    reference operator*() const { return *it_; }
+    counted_iterator& operator++() {
+      ++it_;
+      --remaining_;
+      return *this;
+    }
+    counted_iterator operator++(int) {
+      counted_iterator old = *this;
+      ++*this;
+      return old;
+    }
+    // the end is reached when either runs out
+    bool operator==(const counted_iterator& other) const {
+      return remaining_ == other.remaining_ || it_ == other.it_;
+    }
+    bool operator!=(const counted_iterator& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    base_iterator it_{};
+    size_t remaining_ = 0;
+  };
+
+  using iterator =
+      std::conditional_t<random_access, base_iterator, counted_iterator>;
+
+  static constexpr bool sized = Base::sized;
+
+  take_view(Base base, size_t n) : base_(std::move(base)), n_(n) {}
+
+  iterator begin() const {
+    if constexpr (random_access) {
+      return base_.begin();
+    } else {
+      return counted_iterator(base_.begin(), n_);
+    }
+  }
+  iterator end() const {
+    if constexpr (random_access) {
+      return base_.begin() + static_cast<std::ptrdiff_t>(size());
+    } else {
+      return counted_iterator(base_.end(), 0);
+    }
+  }
+  size_t size() const { return std::min(n_, base_.size()); }
+
+ private:
+  Base base_;
+  size_t n_;
+};
+
+template <typename Range>
+inline auto take(Range&& range, size_t n) {
+  return take_view<all_t<Range>>(view::all(std::forward<Range>(range)), n);
+}
+
+inline auto take(size_t n) {
+  return adaptor{[n](auto&& range) {
+    return view::take(std::forward<decltype(range)>(range), n);
+  }};
+}
+
+// Pairs of the elements of Base1 and Base2 at the same position, as
+// std::pair of their references, as many as the shorter has. Random access
+// if both are sized and random access.
+template <typename Base1, typename Base2>
+class zip_view : public view_base {
+  using base_iterator1 = iterator_t<Base1>;
+  using base_iterator2 = iterator_t<Base2>;
+  using base_traits1 = iterator_traits<base_iterator1>;
+  using base_traits2 = iterator_traits<base_iterator2>;
+  static constexpr bool random_access =
+      Base1::sized && Base2::sized &&
+      is_random_access_iterator_v<base_iterator1> &&
+      is_random_access_iterator_v<base_iterator2>;
+
+ public:
+  class iterator {
+   public:
+    using iterator_category =
+        std::conditional_t<random_access, random_access_iterator_tag,
+                           forward_iterator_tag>;
+    using value_type = std::pair<typename base_traits1::value_type,
+                                 typename base_traits2::value_type>;
+    using reference = std::pair<typename base_traits1::reference,
+                                typename base_traits2::reference>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+
+    iterator() = default;
+    iterator(base_iterator1 it1, base_iterator2 it2) : it1_(it1), it2_(it2) {}
+
+    reference operator*() const { return reference(*it1_, *it2_); }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    iterator& operator++() {
+      ++it1_;
+      ++it2_;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+    iterator& operator--() {
+      --it1_;
+      --it2_;
+      return *this;
+    }
+    iterator operator--(int) {
+      iterator old = *this;
+      --*this;
+      return old;
+    }
+    iterator& operator+=(difference_type n) {
+      it1_ += n;
+      it2_ += n;
+      return *this;
+    }
+    iterator& operator-=(difference_type n) { return *this += -n; }
+    iterator operator+(difference_type n) const {
+      return iterator(it1_ + n, it2_ + n);
+    }
+    iterator operator-(difference_type n) const { return *this + -n; }
+    difference_type operator-(const iterator& other) const {
+      return it1_ - other.it1_;
+    }
+
+    // Random access ends are in step. Otherwise the end is reached when
+    // either runs out.
+    bool operator==(const iterator& other) const {
+      if constexpr (random_access) {
+        return it1_ == other.it1_;
+      } else {
+        return it1_ == other.it1_ || it2_ == other.it2_;
+      }
+    }
+    bool operator!=(const iterator& other) const { return !(*this == other); }
+    bool operator<(const iterator& other) const { return it1_ < other.it1_; }
+
+   private:
+    base_iterator1 it1_{};
+    base_iterator2 it2_{};
+  };
+
+  static constexpr bool sized = Base1::sized && Base2::sized;
+
+  zip_view(Base1 base1, Base2 base2)
+      : base1_(std::move(base1)), base2_(std::move(base2)) {}
+
+  iterator begin() const { return iterator(base1_.begin(), base2_.begin()); }
+  iterator end() const {
+    if constexpr (random_access) {
+      auto n = static_cast<std::ptrdiff_t>(size());
+      return iterator(base1_.begin() + n, base2_.begin() + n);
+    } else {
+      return iterator(base1_.end(), base2_.end());
+    }
+  }
+  size_t size() const { return std::min(base1_.size(), base2_.size()); }
+
+ private:
+  Base1 base1_;
+  Base2 base2_;
+};
+
+template <typename Range1, typename Range2>
+inline auto zip(Range1&& range1, Range2&& range2) {
+  return zip_view<all_t<Range1>, all_t<Range2>>(
+      view::all(std::forward<Range1>(range1)),
+      view::all(std::forward<Range2>(range2)));
+}
+
+// range | zip(other) pairs the elements of range with those of other.
+template <typename Range>
+inline auto zip(Range&& other) {
+  return adaptor{[other = view::all(std::forward<Range>(other))](
+                     auto&& range) {
+    return view::zip(std::forward<decltype(range)>(range), other);
+  }};
+}
+
+// The elements of Base in consecutive iterator_ranges of n, the last one
+// possibly shorter.
+template <typename Base>
+class chunk_view : public view_base {
+  using base_iterator = iterator_t<Base>;
+  using base_traits = iterator_traits<base_iterator>;
+
+ public:
+  class iterator {
+   public:
+    using iterator_category = forward_iterator_tag;
+    using value_type = iterator_range<base_iterator>;
+    using reference = value_type;
+    using difference_type = typename base_traits::difference_type;
+    using pointer = void;
+
+    iterator() = default;
+    iterator(base_iterator first, base_iterator last, size_t n)
+        : first_(first), next_(advance_bounded(first, n, last)),
+          last_(last), n_(n) {}
+
+    reference operator*() const { return reference(first_, next_); }
+    iterator& operator++() {
+      first_ = next_;
+      next_ = advance_bounded(first_, n_, last_);
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+    bool operator==(const iterator& other) const {
+      return first_ == other.first_;
+    }
+    bool operator!=(const iterator& other) const {
+      return first_ != other.first_;
+    }
+
+   private:
+    base_iterator first_{};
+    base_iterator next_{};  // end of the current chunk
+    base_iterator last_{};
+    size_t n_ = 0;
+  };
+
+  static constexpr bool sized = Base::sized;
+
+  // n must not be 0
+  chunk_view(Base base, size_t n) : base_(std::move(base)), n_(n) {}
+
+  iterator begin() const { return iterator(base_.begin(), base_.end(), n_); }
+  iterator end() const { return iterator(base_.end(), base_.end(), n_); }
+  size_t size() const { return (base_.size() + n_ - 1) / n_; }
+
+ private:
+  Base base_;
+  size_t n_;
+};
+
+template <typename Range>
+inline auto chunk(Range&& range, size_t n) {
+  return chunk_view<all_t<Range>>(view::all(std::forward<Range>(range)), n);
+}
+
+inline auto chunk(size_t n) {
+  return adaptor{[n](auto&& range) {
+    return view::chunk(std::forward<decltype(range)>(range), n);
+  }};
+}
+
+// Copies the elements of range into a new sgi::vector. The storage of a
+// sized view is reserved once up front. Views that are not, such as filter
+// or anything over a sgi::list, whose size is O(n), grow it as push_back
+// does.
+template <typename Range>
+inline auto collect(Range&& range) {
+  auto view = view::all(std::forward<Range>(range));
+  using iterator = iterator_t<decltype(view)>;
+  sgi::vector<typename iterator_traits<iterator>::value_type> result;
+  if constexpr (decltype(view)::sized) {
+    result.reserve(view.size());
+  }
+  for (iterator it = view.begin(), last = view.end(); it != last; ++it) {
+    result.emplace_back(*it);
+  }
+  return result;
+}
+
+inline auto collect() {
+  return adaptor{[](auto&& range) {
+    return view::collect(std::forward<decltype(range)>(range));
+  }};
+}
+
+}  // namespace view
+}  // namespace sgi
+
+#endif  // ALGORITHM_VIEW_H_
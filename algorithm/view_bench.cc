@@ -0,0 +1,100 @@
+#include <cstdint>
+#include <random>
+
+#include "algo.h"
+#include "benchmark/benchmark.h"
+#include "list.h"
+#include "vector.h"
+#include "view.h"
+
+struct Order {
+  int64_t price;
+  int32_t quantity;
+  bool open;
+};
+
+template <typename Container>
+Container Orders(size_t n) {
+  std::mt19937 rng(1);
+  Container orders;
+  for (size_t i = 0; i < n; i++) {
+    orders.push_back({static_cast<int64_t>(rng() % 1000),
+                      static_cast<int32_t>(rng() % 100), rng() % 2 == 0});
+  }
+  return orders;
+}
+
+// lambdas rather than functions, whose pointers the views would keep
+auto IsOpen = [](const Order& order) { return order.open; };
+auto Value = [](const Order& order) { return order.price * order.quantity; };
+
+// filter -> transform -> reduce, each stage into a new vector
+template <typename Container>
+static void BM_Materialized(benchmark::State& state) {
+  Container orders = Orders<Container>(state.range(0));
+  for (auto _ : state) {
+    sgi::vector<Order> open;
+    for (const Order& order : orders) {
+      if (IsOpen(order)) {
+        open.push_back(order);
+      }
+    }
+    sgi::vector<int64_t> values;
+    for (const Order& order : open) {
+      values.push_back(Value(order));
+    }
+    benchmark::DoNotOptimize(sgi::reduce(values.begin(), values.end()));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_Materialized, sgi::vector<Order>)
+    ->RangeMultiplier(16)
+    ->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Materialized, sgi::list<Order>)
+    ->RangeMultiplier(16)
+    ->Range(1 << 10, 1 << 22);
+
+// the same pipeline on views, in one loop
+template <typename Container>
+static void BM_Fused(benchmark::State& state) {
+  Container orders = Orders<Container>(state.range(0));
+  for (auto _ : state) {
+    auto values = orders | sgi::view::filter(IsOpen) |
+                  sgi::view::transform(Value);
+    benchmark::DoNotOptimize(sgi::reduce(values.begin(), values.end()));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_Fused, sgi::vector<Order>)
+    ->RangeMultiplier(16)
+    ->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Fused, sgi::list<Order>)
+    ->RangeMultiplier(16)
+    ->Range(1 << 10, 1 << 22);
+
+// transform into a vector: push_back against collect, which reserves
+static void BM_CollectPushBack(benchmark::State& state) {
+  auto orders = Orders<sgi::vector<Order>>(state.range(0));
+  for (auto _ : state) {
+    sgi::vector<int64_t> values;
+    for (const Order& order : orders) {
+      values.push_back(Value(order));
+    }
+    benchmark::DoNotOptimize(values.begin());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CollectPushBack)->RangeMultiplier(16)->Range(1 << 10, 1 << 22);
+
+static void BM_Collect(benchmark::State& state) {
+  auto orders = Orders<sgi::vector<Order>>(state.range(0));
+  for (auto _ : state) {
+    sgi::vector<int64_t> values =
+        orders | sgi::view::transform(Value) | sgi::view::collect();
+    benchmark::DoNotOptimize(values.begin());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Collect)->RangeMultiplier(16)->Range(1 << 10, 1 << 22);
+
+BENCHMARK_MAIN();
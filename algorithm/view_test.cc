@@ -0,0 +1,193 @@
+#include "view.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "algo.h"
+#include "gtest/gtest.h"
+#include "list.h"
+#include "vector.h"
+
+sgi::vector<int> Iota(int n) {
+  sgi::vector<int> vec;
+  for (int i = 0; i < n; i++) {
+    vec.push_back(i);
+  }
+  return vec;
+}
+
+template <typename Range>
+std::string Join(const Range& range) {
+  std::string res;
+  for (auto it = range.begin(); it != range.end(); ++it) {
+    res += (res.empty() ? "" : ",") + std::to_string(*it);
+  }
+  return res;
+}
+
+TEST(View, all) {
+  sgi::vector<int> vec = Iota(5);
+  auto view = sgi::view::all(vec);
+  static_assert(decltype(view)::sized);
+  EXPECT_EQ(view.begin(), vec.begin());
+  EXPECT_EQ(view.size(), 5);
+  EXPECT_EQ(Join(view), "0,1,2,3,4");
+
+  sgi::list<int> list;
+  list.push_back(1);
+  list.push_back(2);
+  auto list_view = sgi::view::all(list);
+  static_assert(!decltype(list_view)::sized);
+  EXPECT_EQ(list_view.size(), 2);
+}
+
+TEST(View, filter) {
+  sgi::vector<int> vec = Iota(10);
+  auto even = sgi::view::filter(vec, [](int x) { return x % 2 == 0; });
+  static_assert(!decltype(even)::sized);
+  EXPECT_EQ(Join(even), "0,2,4,6,8");
+  EXPECT_EQ(Join(vec | sgi::view::filter([](int x) { return x > 6; })),
+            "7,8,9");
+  EXPECT_EQ(Join(vec | sgi::view::filter([](int) { return false; })), "");
+
+  // the elements themselves
+  for (int& x : vec | sgi::view::filter([](int x) { return x < 3; })) {
+    x = -x;
+  }
+  EXPECT_EQ(vec[2], -2);
+  EXPECT_EQ(vec[3], 3);
+}
+
+TEST(View, transform) {
+  sgi::vector<int> vec = Iota(5);
+  auto squares = vec | sgi::view::transform([](int x) { return x * x; });
+  static_assert(decltype(squares)::sized);
+  static_assert(std::is_same_v<decltype(squares.begin())::iterator_category,
+                               sgi::random_access_iterator_tag>);
+  EXPECT_EQ(Join(squares), "0,1,4,9,16");
+  EXPECT_EQ(squares.size(), 5);
+  EXPECT_EQ(squares.begin()[3], 9);
+  EXPECT_EQ(squares.end() - squares.begin(), 5);
+
+  // evaluated on dereference only, once per element
+  int calls = 0;
+  auto counted = vec | sgi::view::transform([&](int x) {
+                   calls++;
+                   return x;
+                 });
+  EXPECT_EQ(calls, 0);
+  EXPECT_EQ(sgi::reduce(counted.begin(), counted.end()), 10);
+  EXPECT_EQ(calls, 5);
+}
+
+TEST(View, take) {
+  sgi::vector<int> vec = Iota(10);
+  auto first = vec | sgi::view::take(3);
+  static_assert(std::is_same_v<decltype(first.begin()), int*>);
+  EXPECT_EQ(Join(first), "0,1,2");
+  EXPECT_EQ(first.size(), 3);
+  EXPECT_EQ(Join(vec | sgi::view::take(20)), Join(vec));
+  EXPECT_EQ(Join(vec | sgi::view::take(0)), "");
+
+  // stops early on unsized views
+  int tested = 0;
+  auto odd = vec | sgi::view::filter([&](int x) {
+               tested++;
+               return x % 2 == 1;
+             }) |
+             sgi::view::take(2);
+  EXPECT_EQ(Join(odd), "1,3");
+  EXPECT_LE(tested, 2 * 4 + 1);
+
+  sgi::list<int> list;
+  for (int i = 0; i < 5; i++) {
+    list.push_back(i);
+  }
+  EXPECT_EQ(Join(list | sgi::view::take(2)), "0,1");
+  EXPECT_EQ(Join(list | sgi::view::take(9)), "0,1,2,3,4");
+}
+
+TEST(View, zip) {
+  sgi::vector<int> ints = Iota(4);
+  sgi::list<std::string> strings;
+  strings.push_back("a");
+  strings.push_back("b");
+  strings.push_back("c");
+
+  std::string res;
+  for (auto [i, s] : sgi::view::zip(ints, strings)) {
+    res += std::to_string(i) + s;
+    s += "!";  // references
+  }
+  EXPECT_EQ(res, "0a1b2c");
+  EXPECT_EQ(strings.front(), "a!");
+
+  // random access over two vectors, as long as the shorter
+  sgi::vector<double> doubles(2, 0.5);
+  auto pairs = ints | sgi::view::zip(doubles);
+  static_assert(decltype(pairs)::sized);
+  EXPECT_EQ(pairs.size(), 2);
+  EXPECT_EQ(pairs.end() - pairs.begin(), 2);
+  EXPECT_EQ(pairs.begin()[1].first, 1);
+  sgi::vector<std::pair<int, double>> collected =
+      pairs | sgi::view::collect();
+  EXPECT_EQ(collected.size(), 2);
+  EXPECT_EQ(collected[1], std::make_pair(1, 0.5));
+}
+
+TEST(View, chunk) {
+  sgi::vector<int> vec = Iota(7);
+  auto chunks = vec | sgi::view::chunk(3);
+  EXPECT_EQ(chunks.size(), 3);
+  std::string res;
+  for (auto chunk : chunks) {
+    res += "[" + Join(chunk) + "]";
+  }
+  EXPECT_EQ(res, "[0,1,2][3,4,5][6]");
+
+  sgi::list<int> list;
+  for (int i = 0; i < 4; i++) {
+    list.push_back(i);
+  }
+  res.clear();
+  for (auto chunk : list | sgi::view::chunk(2)) {
+    res += "[" + Join(chunk) + "]";
+  }
+  EXPECT_EQ(res, "[0,1][2,3]");
+  sgi::vector<int> empty;
+  auto no_chunks = empty | sgi::view::chunk(2);
+  EXPECT_EQ(no_chunks.begin(), no_chunks.end());
+}
+
+TEST(View, collect) {
+  sgi::vector<int> vec = Iota(100);
+  sgi::vector<int64_t> squares =
+      vec | sgi::view::transform([](int x) { return int64_t{x} * x; }) |
+      sgi::view::collect();
+  // reserved up front
+  EXPECT_EQ(squares.size(), 100);
+  EXPECT_EQ(squares.capacity(), 100);
+  EXPECT_EQ(squares[99], 99 * 99);
+
+  sgi::vector<std::string> strings =
+      vec | sgi::view::filter([](int x) { return x % 10 == 0; }) |
+      sgi::view::transform([](int x) { return std::to_string(x); }) |
+      sgi::view::take(3) | sgi::view::collect();
+  EXPECT_EQ(strings.size(), 3);
+  EXPECT_EQ(strings[2], "20");
+
+  // sums of chunks
+  sgi::vector<int> sums = sgi::view::collect(
+      sgi::view::chunk(vec, 10) | sgi::view::transform([](auto chunk) {
+        return sgi::reduce(chunk.begin(), chunk.end());
+      }));
+  EXPECT_EQ(sums.size(), 10);
+  EXPECT_EQ(sums[0], 45);
+  EXPECT_EQ(sums[9], 945);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -6,6 +6,8 @@
 #include <cstdlib>
 #include <cstring>
 #include <new>
+#include <type_traits>
+#include <utility>
 
 #include "default_alloc.h"
 #include "malloc_alloc.h"
@@ -19,24 +21,213 @@ using alloc = MallocAlloc;
 using alloc = DefaultAlloc;
 #endif  //  __USE_MALLOC_ALLOC
 
+// An Alloc policy either has static Allocate and Deallocate functions, like
+// DefaultAlloc, or is an object whose member functions carry state, like a
+// handle to a per-tenant pool. Stateful policies must be copyable and
+// comparable with ==, two policies being equal when either can free what the
+// other allocated. They may define the following members to choose what
+// containers do with their allocator, all default to std::false_type:
+//
+//   propagate_on_container_copy_assignment
+//   propagate_on_container_move_assignment
+//   propagate_on_container_swap
+//
+// is_always_equal defaults to std::is_empty<Alloc>.
+//
+// Policies guarantee ALIGN byte alignment. Over-aligned types are allocated
+// with Allocate(bytes, align) and freed with Deallocate(p, bytes, align),
+// which a policy has to provide to hold such types.
+#define SGI_ALLOC_TRAIT(name, default_type)                             \
+  template <typename Alloc, typename = void>                            \
+  struct name : default_type {};                                        \
+  template <typename Alloc>                                             \
+  struct name<Alloc, std::void_t<typename Alloc::name>>                 \
+      : std::integral_constant<bool, Alloc::name::value> {};
+
+namespace alloc_traits {
+SGI_ALLOC_TRAIT(propagate_on_container_copy_assignment, std::false_type)
+SGI_ALLOC_TRAIT(propagate_on_container_move_assignment, std::false_type)
+SGI_ALLOC_TRAIT(propagate_on_container_swap, std::false_type)
+SGI_ALLOC_TRAIT(is_always_equal, std::is_empty<Alloc>)
+}  // namespace alloc_traits
+
+#undef SGI_ALLOC_TRAIT
+
+namespace alloc_traits {
+template <typename Alloc, typename = void>
+struct has_reallocate : std::false_type {};
+template <typename Alloc>
+struct has_reallocate<Alloc,
+                      std::void_t<decltype(std::declval<Alloc&>().Reallocate(
+                          nullptr, size_t(), size_t()))>> : std::true_type {};
+
+template <typename Alloc, typename = void>
+struct has_allocate_batch : std::false_type {};
+template <typename Alloc>
+struct has_allocate_batch<
+    Alloc, std::void_t<decltype(std::declval<Alloc&>().AllocateBatch(
+                           size_t(), size_t(), static_cast<void**>(nullptr))),
+                       decltype(std::declval<Alloc&>().DeallocateBatch(
+                           static_cast<void**>(nullptr), size_t(), size_t()))>>
+    : std::true_type {};
+}  // namespace alloc_traits
+
+// Typed front end of an Alloc policy. It derives from the policy, so that a
+// stateless policy adds nothing to the size of the containers holding it.
 template <typename T, typename Alloc = alloc>
-class allocator {
+class allocator : private Alloc {
  public:
-  static T* allocate(size_t n) {
-    return n <= 0 ? nullptr : static_cast<T*>(Alloc::Allocate(n * sizeof(T)));
-  }
+  using value_type = T;
+  using policy_type = Alloc;
+  using propagate_on_container_copy_assignment =
+      alloc_traits::propagate_on_container_copy_assignment<Alloc>;
+  using propagate_on_container_move_assignment =
+      alloc_traits::propagate_on_container_move_assignment<Alloc>;
+  using propagate_on_container_swap =
+      alloc_traits::propagate_on_container_swap<Alloc>;
+  using is_always_equal = alloc_traits::is_always_equal<Alloc>;
 
-  static T* allocate(void) {
-    return static_cast<T*>(Alloc::Allocate(sizeof(T)));
+  allocator() = default;
+  explicit allocator(const Alloc& policy) : Alloc(policy) {}
+
+  // rebinding, for instance from the element type to the list node type
+  template <typename U>
+  allocator(const allocator<U, Alloc>& other) : Alloc(other.policy()) {}
+
+  const Alloc& policy() const { return *this; }
+
+  T* allocate(size_t n) {
+    return n <= 0 ? nullptr : static_cast<T*>(Allocate(n * sizeof(T)));
   }
 
-  static void deallocate(T* p, size_t n) {
+  T* allocate(void) { return static_cast<T*>(Allocate(sizeof(T))); }
+
+  void deallocate(T* p, size_t n) {
     if (n != 0) {
-      Alloc::Deallocate(p, n * sizeof(T));
+      Deallocate(p, n * sizeof(T));
+    }
+  }
+
+  void deallocate(T* p) { Deallocate(p, sizeof(T)); }
+
+  // Whether reallocate may be used: the policy has Reallocate(p, old_sz,
+  // new_sz), and T is not over-aligned, since Reallocate keeps only ALIGN.
+  static constexpr bool can_reallocate =
+      alloc_traits::has_reallocate<Alloc>::value && alignof(T) <= ALIGN;
+
+  // Resizes the storage of old_n objects to new_n objects and moves them
+  // bytewise, so T must be trivially copyable. A large block may grow in
+  // place.
+  T* reallocate(T* p, size_t old_n, size_t new_n) {
+    static_assert(can_reallocate);
+    if (p == nullptr) {
+      return allocate(new_n);
+    }
+    return static_cast<T*>(
+        Alloc::Reallocate(p, old_n * sizeof(T), new_n * sizeof(T)));
+  }
+
+  // Whether allocate_batch and deallocate_batch take whole free list segments
+  // at once: the policy has AllocateBatch(bytes, n, out) and
+  // DeallocateBatch(ptrs, n, bytes), and T is not over-aligned. Otherwise
+  // they loop over allocate() and deallocate().
+  static constexpr bool can_batch =
+      alloc_traits::has_allocate_batch<Alloc>::value && alignof(T) <= ALIGN;
+
+  // Stores n pointers to single objects in out.
+  void allocate_batch(size_t n, T** out) {
+    if constexpr (can_batch) {
+      Alloc::AllocateBatch(sizeof(T), n, reinterpret_cast<void**>(out));
+    } else {
+      for (size_t i = 0; i < n; i++) {
+        out[i] = allocate();
+      }
+    }
+  }
+
+  // Frees the n single objects ptrs points to.
+  void deallocate_batch(T** ptrs, size_t n) {
+    if constexpr (can_batch) {
+      Alloc::DeallocateBatch(reinterpret_cast<void**>(ptrs), n, sizeof(T));
+    } else {
+      for (size_t i = 0; i < n; i++) {
+        deallocate(ptrs[i]);
+      }
+    }
+  }
+
+  template <typename U>
+  bool operator==(const allocator<U, Alloc>& other) const {
+    if constexpr (is_always_equal::value) {
+      return true;
+    } else {
+      return policy() == other.policy();
+    }
+  }
+
+  template <typename U>
+  bool operator!=(const allocator<U, Alloc>& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  void* Allocate(size_t bytes) {
+    if constexpr (alignof(T) > ALIGN) {
+      return Alloc::Allocate(bytes, alignof(T));
+    } else {
+      return Alloc::Allocate(bytes);
+    }
+  }
+
+  void Deallocate(void* p, size_t bytes) {
+    if constexpr (alignof(T) > ALIGN) {
+      Alloc::Deallocate(p, bytes, alignof(T));
+    } else {
+      Alloc::Deallocate(p, bytes);
     }
   }
+};
+
+// Policy adapter aligning every allocation of Alloc to at least Align bytes,
+// a power of two. With the default CACHE_LINE_BYTES, a container's storage
+// starts on a cache line of its own, as in
+//
+//   sgi::vector<Counter, sgi::AlignedAlloc<>> counters;
+//
+// Elements that must not share cache lines with each other still need
+// alignas(CACHE_LINE_BYTES) on their type.
+template <typename Alloc = alloc, size_t Align = CACHE_LINE_BYTES>
+class AlignedAlloc : public Alloc {
+  static_assert((Align & (Align - 1)) == 0, "Align must be a power of two");
 
-  static void deallocate(T* p) { Alloc::Deallocate(p, sizeof(T)); }
+ public:
+  using Alloc::Alloc;
+
+  void* Allocate(size_t bytes) { return Alloc::Allocate(bytes, Align); }
+
+  void* Allocate(size_t bytes, size_t align) {
+    return Alloc::Allocate(bytes, align > Align ? align : Align);
+  }
+
+  void Deallocate(void* p, size_t bytes) {
+    Alloc::Deallocate(p, bytes, Align);
+  }
+
+  void Deallocate(void* p, size_t bytes, size_t align) {
+    Alloc::Deallocate(p, bytes, align > Align ? align : Align);
+  }
+
+  // neither would the batches of Alloc, allocator falls back to single objects
+  void AllocateBatch(size_t bytes, size_t n, void** out) = delete;
+  void DeallocateBatch(void** ptrs, size_t n, size_t bytes) = delete;
+
+  // Alloc::Reallocate would not keep the alignment
+  void* Reallocate(void* p, size_t old_sz, size_t new_sz) {
+    void* new_p = Allocate(new_sz);
+    memcpy(new_p, p, old_sz < new_sz ? old_sz : new_sz);
+    Deallocate(p, old_sz);
+    return new_p;
+  }
 };
 
 }  // namespace sgi
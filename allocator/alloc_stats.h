@@ -0,0 +1,103 @@
+#ifndef ALLOCATOR_ALLOC_STATS_H_
+#define ALLOCATOR_ALLOC_STATS_H_
+
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Event counters cost one plain store on the fast path. Define
+// SGI_NO_ALLOC_STATS to compile them out.
+#ifdef SGI_NO_ALLOC_STATS
+#define SGI_ALLOC_STAT(statement)
+#else
+#define SGI_ALLOC_STAT(statement) statement
+#endif  // SGI_NO_ALLOC_STATS
+
+namespace sgi {
+using size_t = std::size_t;
+
+// A counter written by a single thread and read by any thread. Updates are a
+// relaxed load and store rather than an atomic read-modify-write, so they cost
+// the same as on a plain integer.
+template <typename T>
+class RelaxedCounter {
+ public:
+  operator T() const { return value_.load(std::memory_order_relaxed); }
+
+  RelaxedCounter& operator=(T value) {
+    value_.store(value, std::memory_order_relaxed);
+    return *this;
+  }
+
+  RelaxedCounter& operator+=(T n) { return *this = *this + n; }
+  RelaxedCounter& operator-=(T n) { return *this = *this - n; }
+
+  T operator++() { return *this += 1; }
+  T operator--() { return *this -= 1; }
+
+  T operator++(int) {
+    T old_value = *this;
+    *this = old_value + 1;
+    return old_value;
+  }
+
+  T operator--(int) {
+    T old_value = *this;
+    *this = old_value - 1;
+    return old_value;
+  }
+
+ private:
+  std::atomic<T> value_;
+};
+
+// A snapshot of DefaultAlloc, see DefaultAlloc::GetStats.
+template <int NumClasses>
+struct AllocStats {
+  struct SizeClass {
+    size_t size;
+    uint64_t allocations;     // objects handed out by Allocate
+    uint64_t deallocations;   // objects taken back by Deallocate
+    uint64_t refills;         // calls to Refill
+    uint64_t refill_objects;  // objects Refill brought into thread caches
+    size_t free_list_bytes;   // free objects in thread caches and central pool
+  };
+  SizeClass size_classes[NumClasses];
+
+  size_t free_list_bytes;   // sum of free_list_bytes over all size classes
+  size_t pool_bytes;        // not carved yet, between start_free_ and end_free_
+  size_t extend_heap_size;  // bytes of all spans obtained so far
+  size_t free_span_bytes;   // bytes of fully free spans kept for reuse
+  size_t released_bytes;    // part of free_span_bytes given back to the OS
+  size_t thread_caches;     // thread caches ever created
+};
+
+template <int NumClasses>
+void DumpStats(const AllocStats<NumClasses>& stats, std::FILE* out) {
+  fprintf(out, "------------------------------------------------\n");
+  fprintf(out, "extend heap size: %12zu bytes\n", stats.extend_heap_size);
+  fprintf(out, "free lists:       %12zu bytes\n", stats.free_list_bytes);
+  fprintf(out, "memory pool:      %12zu bytes\n", stats.pool_bytes);
+  fprintf(out, "free spans:       %12zu bytes (%zu released)\n",
+          stats.free_span_bytes, stats.released_bytes);
+  fprintf(out, "thread caches:    %12zu\n", stats.thread_caches);
+  fprintf(out, "------------------------------------------------\n");
+  fprintf(out, "%6s %12s %12s %10s %12s %12s\n", "class", "allocs", "frees",
+          "refills", "refill objs", "free bytes");
+  for (const auto& size_class : stats.size_classes) {
+    if (size_class.allocations == 0 && size_class.free_list_bytes == 0) {
+      continue;
+    }
+    fprintf(out, "%6zu %12" PRIu64 " %12" PRIu64 " %10" PRIu64 " %12" PRIu64
+                 " %12zu\n",
+            size_class.size, size_class.allocations, size_class.deallocations,
+            size_class.refills, size_class.refill_objects,
+            size_class.free_list_bytes);
+  }
+}
+
+}  // namespace sgi
+
+#endif  // ALLOCATOR_ALLOC_STATS_H_
@@ -0,0 +1,91 @@
+#include "alloc_stats.h"
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "default_alloc.h"
+#include "gtest/gtest.h"
+
+using alloc = sgi::DefaultAlloc;
+
+TEST(AllocStats, RelaxedCounter) {
+  sgi::RelaxedCounter<int> counter;
+  counter = 1;
+  EXPECT_EQ(counter++, 1);
+  EXPECT_EQ(++counter, 3);
+  counter += 5;
+  counter -= 2;
+  EXPECT_EQ(counter--, 6);
+  EXPECT_EQ(--counter, 4);
+}
+
+const alloc::Stats::SizeClass& SizeClassOf(const alloc::Stats& stats,
+                                           size_t bytes) {
+  for (const auto& size_class : stats.size_classes) {
+    if (size_class.size >= bytes) {
+      return size_class;
+    }
+  }
+  return stats.size_classes[0];
+}
+
+TEST(AllocStats, GetStats) {
+  constexpr size_t kBytes = 72;
+  constexpr int kCount = 1000;
+  alloc::Stats before = alloc::GetStats();
+  std::vector<void*> ptrs(kCount);
+  std::thread([&] {
+    for (auto& ptr : ptrs) {
+      ptr = alloc::Allocate(kBytes);
+    }
+  }).join();
+
+  alloc::Stats after = alloc::GetStats();
+  const auto& size_class_after = SizeClassOf(after, kBytes);
+  EXPECT_EQ(size_class_after.size, kBytes);
+  EXPECT_GT(after.extend_heap_size, 0);
+  EXPECT_GE(after.thread_caches, 1);
+#ifndef SGI_NO_ALLOC_STATS
+  const auto& size_class_before = SizeClassOf(before, kBytes);
+  EXPECT_EQ(size_class_after.allocations - size_class_before.allocations,
+            kCount);
+  EXPECT_GT(size_class_after.refills, size_class_before.refills);
+  EXPECT_GE(size_class_after.refill_objects - size_class_before.refill_objects,
+            kCount);
+#endif  // SGI_NO_ALLOC_STATS
+
+  // frees by another thread are counted by the freeing thread
+  for (auto& ptr : ptrs) {
+    alloc::Deallocate(ptr, kBytes);
+  }
+  alloc::Stats freed = alloc::GetStats();
+  EXPECT_GE(freed.free_list_bytes + freed.pool_bytes,
+            after.free_list_bytes + after.pool_bytes);
+#ifndef SGI_NO_ALLOC_STATS
+  const auto& size_class_freed = SizeClassOf(freed, kBytes);
+  EXPECT_EQ(size_class_freed.deallocations - size_class_after.deallocations,
+            kCount);
+#endif  // SGI_NO_ALLOC_STATS
+
+  alloc::Trim();
+  EXPECT_GT(alloc::GetStats().free_span_bytes, 0);
+}
+
+TEST(AllocStats, DumpStats) {
+  void* p = alloc::Allocate(24);
+  char buf[4096] = {0};
+  std::FILE* out = fmemopen(buf, sizeof(buf), "w");
+  ASSERT_NE(out, nullptr);
+  alloc::DumpStats(out);
+  std::fclose(out);
+  EXPECT_NE(strstr(buf, "extend heap size"), nullptr);
+  EXPECT_NE(strstr(buf, "    24 "), nullptr);
+  alloc::Deallocate(p, 24);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,5 +1,11 @@
 #include "alloc.h"
 
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "arena_alloc.h"
 #include "gtest/gtest.h"
 
 TEST(allocator, allocator) {
@@ -10,7 +16,106 @@ TEST(allocator, allocator) {
   alloc.deallocate(ptr2);
 }
 
+TEST(allocator, traits) {
+  using default_allocator = sgi::allocator<int>;
+  static_assert(std::is_empty_v<default_allocator>);
+  static_assert(default_allocator::is_always_equal::value);
+  static_assert(!default_allocator::propagate_on_container_swap::value);
+
+  using arena_allocator = sgi::allocator<int, sgi::ArenaRef>;
+  static_assert(sizeof(arena_allocator) == sizeof(sgi::Arena*));
+  static_assert(!arena_allocator::is_always_equal::value);
+  static_assert(
+      !arena_allocator::propagate_on_container_copy_assignment::value);
+  static_assert(arena_allocator::propagate_on_container_swap::value);
+}
+
+TEST(allocator, stateful) {
+  sgi::Arena arena1;
+  sgi::Arena arena2;
+  sgi::allocator<int, sgi::ArenaRef> alloc1{sgi::ArenaRef(&arena1)};
+  sgi::allocator<int, sgi::ArenaRef> alloc2{sgi::ArenaRef(&arena2)};
+  int* ptr = alloc1.allocate(100);
+  alloc1.deallocate(ptr, 100);
+  EXPECT_EQ(arena1.allocated_bytes(), 400);
+  EXPECT_EQ(arena2.allocated_bytes(), 0);
+  EXPECT_NE(alloc1, alloc2);
+
+  // rebinding keeps the state
+  sgi::allocator<double, sgi::ArenaRef> alloc3(alloc1);
+  EXPECT_EQ(alloc3, alloc1);
+  EXPECT_EQ(alloc3.policy().arena(), &arena1);
+  alloc3.allocate(10);
+  EXPECT_EQ(arena1.allocated_bytes(), 480);
+}
+
+struct alignas(64) Counter {
+  long value;
+};
+
+template <typename Alloc>
+void CheckAligned(size_t align) {
+  sgi::allocator<Counter, Alloc> counter_alloc;
+  sgi::allocator<char, Alloc> char_alloc;
+  std::vector<std::pair<Counter*, char*>> ptrs;
+  for (int i = 0; i < 100; i++) {
+    Counter* counters = counter_alloc.allocate(i % 5 + 1);
+    char* chars = char_alloc.allocate(i % 7 + 1);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(counters) % alignof(Counter), 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(chars) % align, 0);
+    ptrs.emplace_back(counters, chars);
+  }
+  for (int i = 0; i < 100; i++) {
+    counter_alloc.deallocate(ptrs[i].first, i % 5 + 1);
+    char_alloc.deallocate(ptrs[i].second, i % 7 + 1);
+  }
+}
+
+TEST(allocator, aligned) {
+  CheckAligned<sgi::DefaultAlloc>(1);
+  CheckAligned<sgi::MallocAlloc>(1);
+  CheckAligned<sgi::ArenaAlloc>(1);
+  CheckAligned<sgi::AlignedAlloc<>>(sgi::CACHE_LINE_BYTES);
+  CheckAligned<sgi::AlignedAlloc<sgi::MallocAlloc, 256>>(256);
+  static_assert(std::is_empty_v<sgi::allocator<int, sgi::AlignedAlloc<>>>);
+}
+
+TEST(allocator, reallocate) {
+  static_assert(sgi::allocator<int>::can_reallocate);
+  static_assert(sgi::allocator<int, sgi::ArenaRef>::can_reallocate);
+  static_assert(!sgi::allocator<Counter>::can_reallocate);
+
+  sgi::allocator<int> alloc;
+  int* ptr = alloc.reallocate(nullptr, 0, 10);
+  ptr[9] = 9;
+  ptr = alloc.reallocate(ptr, 10, 1 << 20);
+  EXPECT_EQ(ptr[9], 9);
+  alloc.deallocate(ptr, 1 << 20);
+}
+
+TEST(allocator, batch) {
+  static_assert(sgi::allocator<int>::can_batch);
+  static_assert(!sgi::allocator<int, sgi::MallocAlloc>::can_batch);
+  static_assert(!sgi::allocator<Counter>::can_batch);
+  static_assert(!sgi::allocator<int, sgi::AlignedAlloc<>>::can_batch);
+
+  auto check = [](auto alloc) {
+    using T = typename decltype(alloc)::value_type;
+    T* ptrs[100];
+    alloc.allocate_batch(100, ptrs);
+    for (T* ptr : ptrs) {
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignof(T), 0);
+      *ptr = T();
+    }
+    alloc.deallocate_batch(ptrs, 100);
+  };
+  check(sgi::allocator<double>());
+  check(sgi::allocator<double, sgi::MallocAlloc>());
+  check(sgi::allocator<Counter>());
+  check(sgi::allocator<double, sgi::AlignedAlloc<>>());
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}
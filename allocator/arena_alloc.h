@@ -0,0 +1,236 @@
+#ifndef ALLOCATOR_ARENA_ALLOC_H_
+#define ALLOCATOR_ARENA_ALLOC_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "malloc_alloc.h"
+
+namespace sgi {
+using size_t = std::size_t;
+
+inline constexpr size_t ARENA_ALIGN = alignof(std::max_align_t);
+inline constexpr size_t ARENA_BLOCK_BYTES = 64 * 1024;
+
+// Bump pointer allocator for request-scoped data. Memory is carved from
+// blocks of block_bytes obtained from MallocAlloc; requests larger than a
+// quarter of a block get a block of their own. Nothing is freed until Release,
+// which gives back every block at once.
+class Arena {
+ public:
+  explicit Arena(size_t block_bytes = ARENA_BLOCK_BYTES)
+      : block_bytes_(block_bytes) {}
+  ~Arena() { Release(); }
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  void* Allocate(size_t bytes) {
+    bytes = RoundUp(bytes);
+    if (bytes > static_cast<size_t>(end_ - ptr_)) {
+      return AllocateSlow(bytes);
+    }
+    char* res = ptr_;
+    ptr_ += bytes;
+    allocated_bytes_ += bytes;
+    return res;
+  }
+
+  // align must be a power of two
+  void* Allocate(size_t bytes, size_t align) {
+    if (align <= ARENA_ALIGN) {
+      return Allocate(bytes);
+    }
+    char* res = AlignUp(ptr_, align);
+    if (ptr_ != nullptr && res <= end_ &&
+        RoundUp(bytes) <= static_cast<size_t>(end_ - res)) {
+      allocated_bytes_ += res + RoundUp(bytes) - ptr_;
+      ptr_ = res + RoundUp(bytes);
+      return res;
+    }
+    // blocks are aligned to ARENA_ALIGN
+    return AlignUp(static_cast<char*>(Allocate(bytes + align - ARENA_ALIGN)),
+                   align);
+  }
+
+  // The latest allocation grows or shrinks in place when the block has room,
+  // any other one is copied to a new allocation.
+  void* Reallocate(void* p, size_t old_sz, size_t new_sz) {
+    old_sz = RoundUp(old_sz);
+    new_sz = RoundUp(new_sz);
+    if (static_cast<char*>(p) + old_sz == ptr_ &&
+        new_sz <= static_cast<size_t>(end_ - static_cast<char*>(p))) {
+      ptr_ = static_cast<char*>(p) + new_sz;
+      allocated_bytes_ += new_sz - old_sz;
+      return p;
+    }
+    if (new_sz <= old_sz) {
+      return p;
+    }
+
+    void* new_p = Allocate(new_sz);
+    memcpy(new_p, p, old_sz);
+    return new_p;
+  }
+
+  // Frees every block. All memory handed out so far becomes invalid.
+  void Release() {
+    while (blocks_ != nullptr) {
+      Block* next = blocks_->next_;
+      MallocAlloc::Deallocate(blocks_, blocks_->bytes_);
+      blocks_ = next;
+    }
+    ptr_ = end_ = nullptr;
+    allocated_bytes_ = 0;
+    block_bytes_total_ = 0;
+  }
+
+  // bytes handed out since the last Release
+  size_t allocated_bytes() const { return allocated_bytes_; }
+
+  // bytes of all blocks obtained since the last Release
+  size_t block_bytes_total() const { return block_bytes_total_; }
+
+ private:
+  struct Block {
+    Block* next_;
+    size_t bytes_;
+  };
+  static constexpr size_t BLOCK_HEADER_BYTES =
+      (sizeof(Block) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+  static size_t RoundUp(size_t bytes) {
+    return (bytes + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+  }
+
+  static char* AlignUp(char* p, size_t align) {
+    return reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(p) + align - 1) & ~(align - 1));
+  }
+
+  void* AllocateSlow(size_t bytes);
+
+  size_t block_bytes_;
+  Block* blocks_ = nullptr;
+  char* ptr_ = nullptr;
+  char* end_ = nullptr;
+  size_t allocated_bytes_ = 0;
+  size_t block_bytes_total_ = 0;
+};
+
+inline void* Arena::AllocateSlow(size_t bytes) {
+  // a large request does not throw away the rest of the current block
+  bool own_block = bytes > block_bytes_ / 4;
+  size_t block_bytes = BLOCK_HEADER_BYTES + (own_block ? bytes : block_bytes_);
+  Block* block = static_cast<Block*>(MallocAlloc::Allocate(block_bytes));
+  block->bytes_ = block_bytes;
+  block_bytes_total_ += block_bytes;
+  allocated_bytes_ += bytes;
+
+  char* res = reinterpret_cast<char*>(block) + BLOCK_HEADER_BYTES;
+  if (own_block && blocks_ != nullptr) {
+    block->next_ = blocks_->next_;
+    blocks_->next_ = block;
+    return res;
+  }
+
+  block->next_ = blocks_;
+  blocks_ = block;
+  ptr_ = res + bytes;
+  end_ = reinterpret_cast<char*>(block) + block_bytes;
+  return res;
+}
+
+// Memory policy for containers over the calling thread's current Arena, for
+// instance sgi::list<T, ArenaAlloc>. Deallocate is a no-op, so containers
+// never touch a free list; ArenaAlloc::Release frees everything the thread
+// has allocated through ArenaAlloc once the request is done.
+//
+// Each thread owns an Arena that is used by default. SetArena installs
+// another one for the calling thread, for instance one per request.
+class ArenaAlloc {
+ public:
+  static void* Allocate(size_t bytes) {
+    assert(bytes > 0);
+    return CurrentArena()->Allocate(bytes);
+  }
+
+  static void* Allocate(size_t bytes, size_t align) {
+    assert(bytes > 0);
+    return CurrentArena()->Allocate(bytes, align);
+  }
+
+  static void Deallocate(void*, size_t) {}
+  static void Deallocate(void*, size_t, size_t) {}
+
+  static void* Reallocate(void* p, size_t old_sz, size_t new_sz) {
+    return CurrentArena()->Reallocate(p, old_sz, new_sz);
+  }
+
+  // Frees the current arena of the calling thread. Containers allocated from
+  // it must not be used afterwards, not even destroyed if their destructors
+  // touch their elements.
+  static void Release() { CurrentArena()->Release(); }
+
+  // The calling thread allocates from arena, which must outlive its use.
+  // nullptr restores the thread's own arena.
+  static Arena* SetArena(Arena* arena) {
+    Arena* old_arena = CurrentArena();
+    arena_ = arena;
+    return old_arena;
+  }
+
+  static Arena* CurrentArena() {
+    return arena_ != nullptr ? arena_ : &thread_arena_;
+  }
+
+ private:
+  static inline thread_local Arena thread_arena_{ARENA_BLOCK_BYTES};
+  static inline thread_local Arena* arena_ = nullptr;
+};
+
+// Stateful policy allocating from the Arena it was given, for instance one per
+// tenant, so that containers of different tenants never share memory. A
+// default constructed ArenaRef uses the calling thread's current arena.
+// Containers keep their arena on copy and move assignment, and exchange it on
+// swap.
+class ArenaRef {
+ public:
+  using propagate_on_container_swap = std::true_type;
+
+  ArenaRef() : arena_(ArenaAlloc::CurrentArena()) {}
+  explicit ArenaRef(Arena* arena) : arena_(arena) {}
+
+  void* Allocate(size_t bytes) {
+    assert(bytes > 0);
+    return arena_->Allocate(bytes);
+  }
+
+  void* Allocate(size_t bytes, size_t align) {
+    assert(bytes > 0);
+    return arena_->Allocate(bytes, align);
+  }
+
+  void Deallocate(void*, size_t) {}
+  void Deallocate(void*, size_t, size_t) {}
+
+  void* Reallocate(void* p, size_t old_sz, size_t new_sz) {
+    return arena_->Reallocate(p, old_sz, new_sz);
+  }
+
+  Arena* arena() const { return arena_; }
+
+  bool operator==(const ArenaRef& other) const {
+    return arena_ == other.arena_;
+  }
+
+ private:
+  Arena* arena_;
+};
+
+}  // namespace sgi
+
+#endif  // ALLOCATOR_ARENA_ALLOC_H_
@@ -0,0 +1,115 @@
+#include "arena_alloc.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "alloc.h"
+#include "gtest/gtest.h"
+
+bool IsAligned(void* p) {
+  return reinterpret_cast<uintptr_t>(p) % sgi::ARENA_ALIGN == 0;
+}
+
+TEST(Arena, Allocate) {
+  sgi::Arena arena(4096);
+  char* ptr1 = static_cast<char*>(arena.Allocate(10));
+  char* ptr2 = static_cast<char*>(arena.Allocate(20));
+  EXPECT_TRUE(IsAligned(ptr1));
+  EXPECT_TRUE(IsAligned(ptr2));
+  EXPECT_EQ(ptr2, ptr1 + sgi::ARENA_ALIGN);
+  memset(ptr1, 1, 10);
+  memset(ptr2, 2, 20);
+
+  // filling up the block starts a new one
+  for (int i = 0; i < 1000; i++) {
+    char* ptr = static_cast<char*>(arena.Allocate(24));
+    EXPECT_TRUE(IsAligned(ptr));
+    memset(ptr, 3, 24);
+  }
+  EXPECT_EQ(ptr1[9], 1);
+  EXPECT_EQ(ptr2[19], 2);
+  EXPECT_GT(arena.block_bytes_total(), 4096);
+
+  // a large request gets its own block and the current one stays in use
+  char* ptr3 = static_cast<char*>(arena.Allocate(16));
+  char* large = static_cast<char*>(arena.Allocate(100000));
+  memset(large, 4, 100000);
+  char* ptr4 = static_cast<char*>(arena.Allocate(16));
+  EXPECT_EQ(ptr4, ptr3 + 16);
+
+  arena.Release();
+  EXPECT_EQ(arena.allocated_bytes(), 0);
+  EXPECT_EQ(arena.block_bytes_total(), 0);
+  EXPECT_NE(arena.Allocate(8), nullptr);
+}
+
+TEST(Arena, Reallocate) {
+  sgi::Arena arena(4096);
+  char* ptr1 = static_cast<char*>(arena.Allocate(100));
+  memset(ptr1, 1, 100);
+
+  // the latest allocation grows in place
+  EXPECT_EQ(arena.Reallocate(ptr1, 100, 1000), ptr1);
+  EXPECT_EQ(arena.allocated_bytes(), 1008);
+
+  // others are copied
+  char* ptr2 = static_cast<char*>(arena.Allocate(10));
+  char* ptr3 = static_cast<char*>(arena.Reallocate(ptr1, 1000, 2000));
+  EXPECT_NE(ptr3, ptr1);
+  EXPECT_EQ(ptr3, ptr2 + 16);
+  EXPECT_EQ(ptr3[99], 1);
+
+  // or moved to a new block when the current one is full
+  char* ptr4 = static_cast<char*>(arena.Reallocate(ptr3, 2000, 4000));
+  EXPECT_NE(ptr4, ptr3);
+  EXPECT_EQ(ptr4[0], 1);
+}
+
+TEST(Arena, Aligned) {
+  sgi::Arena arena(4096);
+  arena.Allocate(8);
+  for (size_t align = 32; align <= 4096; align *= 2) {
+    void* ptr = arena.Allocate(100, align);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % align, 0);
+    memset(ptr, 1, 100);
+  }
+}
+
+TEST(ArenaAlloc, Allocate_Deallocate) {
+  std::thread([] {
+    sgi::Arena* arena = sgi::ArenaAlloc::CurrentArena();
+    sgi::allocator<int, sgi::ArenaAlloc> allocator;
+    int* ptr1 = allocator.allocate(10);
+    allocator.deallocate(ptr1, 10);
+    int* ptr2 = allocator.allocate(10);
+    EXPECT_NE(ptr1, ptr2);
+    EXPECT_EQ(arena->allocated_bytes(), 2 * 48);
+
+    sgi::ArenaAlloc::Release();
+    EXPECT_EQ(arena->allocated_bytes(), 0);
+  }).join();
+}
+
+TEST(ArenaAlloc, SetArena) {
+  sgi::Arena request_arena;
+  sgi::Arena* thread_arena = sgi::ArenaAlloc::SetArena(&request_arena);
+  EXPECT_NE(thread_arena, &request_arena);
+  EXPECT_EQ(sgi::ArenaAlloc::CurrentArena(), &request_arena);
+
+  sgi::ArenaAlloc::Allocate(100);
+  EXPECT_EQ(request_arena.allocated_bytes(), 112);
+
+  // every thread has its own current arena
+  std::thread([&] {
+    EXPECT_NE(sgi::ArenaAlloc::CurrentArena(), &request_arena);
+  }).join();
+
+  EXPECT_EQ(sgi::ArenaAlloc::SetArena(nullptr), &request_arena);
+  EXPECT_EQ(sgi::ArenaAlloc::CurrentArena(), thread_arena);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,115 @@
+#ifndef ALLOCATOR_CHUNK_PROVIDER_H_
+#define ALLOCATOR_CHUNK_PROVIDER_H_
+
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sgi {
+using size_t = std::size_t;
+
+inline constexpr size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+
+// Source of the memory chunks DefaultAlloc carves its spans from, installed
+// with DefaultAlloc::SetChunkProvider. Both functions are called with
+// DefaultAlloc's central lock held, so implementations need no locking.
+class ChunkProvider {
+ public:
+  // Returns bytes of memory aligned to bytes, which is a power of two, or
+  // nullptr if the system is out of memory.
+  virtual void* AllocateChunk(size_t bytes) = 0;
+
+  // Gives the pages of [p, p + bytes) back to the operating system. The range
+  // stays mapped and reads as zeros when touched again.
+  virtual void ReleasePages(void* p, size_t bytes) {
+    madvise(p, bytes, MADV_DONTNEED);
+  }
+
+ protected:
+  ~ChunkProvider() = default;
+};
+
+// Maps every chunk on its own.
+class MmapChunkProvider : public ChunkProvider {
+ public:
+  void* AllocateChunk(size_t bytes) override {
+    // map twice the size and cut the ends off to get an aligned chunk
+    void* p = mmap(nullptr, 2 * bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+      return nullptr;
+    }
+
+    char* start = static_cast<char*>(p);
+    char* aligned = reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(start) + bytes - 1) & ~(bytes - 1));
+    if (aligned != start) {
+      munmap(start, aligned - start);
+    }
+    munmap(aligned + bytes, start + bytes - aligned);
+    return aligned;
+  }
+};
+
+// Reserves region_bytes at a time, aligned to HUGE_PAGE_BYTES, and carves
+// chunks from them one after another. Chunks of the same region are
+// contiguous, and with huge_pages set the regions are backed by transparent
+// huge pages (MADV_HUGEPAGE), so walking many pool objects needs far fewer
+// TLB entries. Regions are never unmapped.
+class RegionChunkProvider : public ChunkProvider {
+ public:
+  explicit RegionChunkProvider(bool huge_pages = true,
+                               size_t region_bytes = 64 * 1024 * 1024)
+      : huge_pages_(huge_pages), region_bytes_(region_bytes) {}
+
+  void* AllocateChunk(size_t bytes) override {
+    char* res = reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(next_) + bytes - 1) & ~(bytes - 1));
+    if (next_ == nullptr || res + bytes > end_) {
+      if (!ReserveRegion(bytes)) {
+        return nullptr;
+      }
+      res = next_;
+    }
+    next_ = res + bytes;
+    return res;
+  }
+
+ private:
+  bool ReserveRegion(size_t bytes) {
+    size_t region_bytes = region_bytes_ < bytes ? bytes : region_bytes_;
+    size_t align = bytes < HUGE_PAGE_BYTES ? HUGE_PAGE_BYTES : bytes;
+    region_bytes = (region_bytes + align - 1) & ~(align - 1);
+
+    void* p = mmap(nullptr, region_bytes + align, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) {
+      return false;
+    }
+
+    char* start = static_cast<char*>(p);
+    char* aligned = reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(start) + align - 1) & ~(align - 1));
+    if (aligned != start) {
+      munmap(start, aligned - start);
+    }
+    munmap(aligned + region_bytes, start + align - aligned);
+    if (huge_pages_) {
+      madvise(aligned, region_bytes, MADV_HUGEPAGE);
+    }
+
+    next_ = aligned;
+    end_ = aligned + region_bytes;
+    return true;
+  }
+
+  bool huge_pages_;
+  size_t region_bytes_;
+  char* next_ = nullptr;
+  char* end_ = nullptr;
+};
+
+}  // namespace sgi
+
+#endif  // ALLOCATOR_CHUNK_PROVIDER_H_
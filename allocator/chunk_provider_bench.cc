@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "alloc.h"
+#include "benchmark/benchmark.h"
+#include "chunk_provider.h"
+#include "default_alloc.h"
+
+struct Node {
+  Node* next;
+  long value;
+};
+
+enum Provider { MMAP, REGION, REGION_HUGE_PAGES };
+
+// Links range(0) pool-allocated nodes in random order and walks them, which
+// misses the TLB on almost every node once the nodes span more pages than
+// the TLB covers.
+static void BM_RandomTraversal(benchmark::State& state) {
+  static sgi::RegionChunkProvider region_provider(false);
+  static sgi::RegionChunkProvider huge_page_provider(true);
+  switch (state.range(1)) {
+    case MMAP:
+      sgi::DefaultAlloc::SetChunkProvider(nullptr);
+      state.SetLabel("mmap");
+      break;
+    case REGION:
+      sgi::DefaultAlloc::SetChunkProvider(&region_provider);
+      state.SetLabel("region");
+      break;
+    case REGION_HUGE_PAGES:
+      sgi::DefaultAlloc::SetChunkProvider(&huge_page_provider);
+      state.SetLabel("region+huge_pages");
+      break;
+  }
+
+  size_t n = state.range(0);
+  sgi::allocator<Node> allocator;
+  std::vector<Node*> nodes(n);
+  for (size_t i = 0; i < n; i++) {
+    nodes[i] = allocator.allocate();
+    nodes[i]->value = i;
+  }
+  std::shuffle(nodes.begin(), nodes.end(), std::mt19937(42));
+  for (size_t i = 0; i + 1 < n; i++) {
+    nodes[i]->next = nodes[i + 1];
+  }
+  nodes[n - 1]->next = nullptr;
+
+  for (auto _ : state) {
+    long sum = 0;
+    for (Node* node = nodes[0]; node != nullptr; node = node->next) {
+      sum += node->value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+
+  for (Node* node : nodes) {
+    allocator.deallocate(node);
+  }
+  // keeps the next run from reusing spans of this provider
+  sgi::DefaultAlloc::Trim();
+  sgi::DefaultAlloc::SetChunkProvider(nullptr);
+}
+BENCHMARK(BM_RandomTraversal)
+    ->ArgsProduct({{1 << 16, 1 << 20, 1 << 22},
+                   {MMAP, REGION, REGION_HUGE_PAGES}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
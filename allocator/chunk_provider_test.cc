@@ -0,0 +1,78 @@
+#include "chunk_provider.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "default_alloc.h"
+#include "gtest/gtest.h"
+
+constexpr size_t CHUNK_BYTES = 256 * 1024;
+
+bool IsAligned(void* p, size_t align) {
+  return reinterpret_cast<uintptr_t>(p) % align == 0;
+}
+
+TEST(ChunkProvider, MmapChunkProvider) {
+  sgi::MmapChunkProvider provider;
+  char* chunk = static_cast<char*>(provider.AllocateChunk(CHUNK_BYTES));
+  ASSERT_NE(chunk, nullptr);
+  EXPECT_TRUE(IsAligned(chunk, CHUNK_BYTES));
+  memset(chunk, 1, CHUNK_BYTES);
+
+  provider.ReleasePages(chunk, CHUNK_BYTES);
+  EXPECT_EQ(chunk[0], 0);
+  EXPECT_EQ(chunk[CHUNK_BYTES - 1], 0);
+}
+
+TEST(ChunkProvider, RegionChunkProvider) {
+  sgi::RegionChunkProvider provider(true, 4 * sgi::HUGE_PAGE_BYTES);
+  char* first = static_cast<char*>(provider.AllocateChunk(CHUNK_BYTES));
+  ASSERT_NE(first, nullptr);
+  EXPECT_TRUE(IsAligned(first, sgi::HUGE_PAGE_BYTES));
+
+  // chunks of one region are contiguous
+  int chunks_per_region = 4 * sgi::HUGE_PAGE_BYTES / CHUNK_BYTES;
+  for (int i = 1; i < chunks_per_region; i++) {
+    char* chunk = static_cast<char*>(provider.AllocateChunk(CHUNK_BYTES));
+    EXPECT_EQ(chunk, first + i * CHUNK_BYTES);
+    memset(chunk, 1, CHUNK_BYTES);
+  }
+
+  // the next region
+  char* chunk = static_cast<char*>(provider.AllocateChunk(CHUNK_BYTES));
+  ASSERT_NE(chunk, nullptr);
+  EXPECT_TRUE(IsAligned(chunk, sgi::HUGE_PAGE_BYTES));
+
+  // chunks larger than a region
+  char* large = static_cast<char*>(
+      provider.AllocateChunk(8 * sgi::HUGE_PAGE_BYTES));
+  ASSERT_NE(large, nullptr);
+  EXPECT_TRUE(IsAligned(large, 8 * sgi::HUGE_PAGE_BYTES));
+}
+
+TEST(ChunkProvider, DefaultAlloc) {
+  sgi::RegionChunkProvider provider;
+  sgi::ChunkProvider* old_provider = sgi::DefaultAlloc::SetChunkProvider(
+      &provider);
+  EXPECT_NE(old_provider, nullptr);
+
+  std::thread([] {
+    std::vector<void*> ptrs(100000);
+    for (auto& ptr : ptrs) {
+      ptr = sgi::DefaultAlloc::Allocate(40);
+      memset(ptr, 1, 40);
+    }
+    for (auto& ptr : ptrs) {
+      sgi::DefaultAlloc::Deallocate(ptr, 40);
+    }
+  }).join();
+  EXPECT_GT(sgi::DefaultAlloc::ReleaseFreeMemory(), 0);
+
+  EXPECT_EQ(sgi::DefaultAlloc::SetChunkProvider(nullptr), &provider);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -2,19 +2,18 @@
 #define ALLOCATOR_CONSTRUCT_H_
 
 #include <iterator>
+#include <new>
 #include <type_traits>
+#include <utility>
 
 namespace sgi {
 
-template <typename T>
-inline void _construct(T* pointer) {
-  new (static_cast<void*>(pointer)) T();
-}
-
-// TODO(leisy): supports class T1's constructor with multiple parameters
-template <typename T1, typename T2>
-inline void _construct(T1* pointer, const T2& value) {
-  new (static_cast<void*>(pointer)) T1(value);
+// Constructs a T at pointer from args, forwarded as they were passed, so that
+// elements are built in place, or moved rather than copied. Without args, T is
+// value-initialized.
+template <typename T, typename... Args>
+inline void _construct(T* pointer, Args&&... args) {
+  new (static_cast<void*>(pointer)) T(std::forward<Args>(args)...);
 }
 
 template <typename T>
@@ -44,14 +43,9 @@ inline void _destroy(ForwardIterator first, ForwardIterator last) {
   _destroy_aux(first, last, typename std::is_trivially_destructible<type>());
 }
 
-template <typename T>
-inline void construct(T* pointer) {
-  _construct(pointer);
-}
-
-template <typename T1, typename T2>
-inline void construct(T1* pointer, const T2& value) {
-  _construct(pointer, value);
+template <typename T, typename... Args>
+inline void construct(T* pointer, Args&&... args) {
+  _construct(pointer, std::forward<Args>(args)...);
 }
 
 template <typename T>
@@ -1,5 +1,9 @@
 #include "construct.h"
 
+#include <memory>
+#include <string>
+#include <utility>
+
 #include "alloc.h"
 #include "gtest/gtest.h"
 
@@ -70,6 +74,36 @@ TEST(Construct, destroy) {
   temp_alloc.deallocate(temp_ptr, 10);
 }
 
+struct Pair {
+  Pair(std::string name, std::unique_ptr<int> value, int count)
+      : name(std::move(name)), value(std::move(value)), count(count) {}
+
+  std::string name;
+  std::unique_ptr<int> value;
+  int count;
+};
+
+TEST(Construct, construct_args) {
+  sgi::allocator<Pair> alloc;
+  Pair* ptr = alloc.allocate(1);
+  std::string name(100, 'x');
+  const char* data = name.data();
+  sgi::construct(ptr, std::move(name), std::make_unique<int>(7), 3);
+  EXPECT_EQ(ptr->name.data(), data);  // moved, not copied
+  EXPECT_EQ(*ptr->value, 7);
+  EXPECT_EQ(ptr->count, 3);
+  sgi::destroy(ptr);
+  alloc.deallocate(ptr, 1);
+
+  // without arguments, the object is value-initialized
+  sgi::allocator<int> int_alloc;
+  int* i = int_alloc.allocate(1);
+  *i = 42;
+  sgi::construct(i);
+  EXPECT_EQ(*i, 0);
+  int_alloc.deallocate(i, 1);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
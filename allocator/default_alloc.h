@@ -1,64 +1,405 @@
 #ifndef ALLOCATOR_DEFAULT_ALLOC_H_
 #define ALLOCATOR_DEFAULT_ALLOC_H_
 
+#include <pthread.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <iterator>
+#include <mutex>
 #include <new>
 
+#include "alloc_stats.h"
+#include "chunk_provider.h"
+#include "heap_profiler.h"
 #include "malloc_alloc.h"
 
+// Requires a static to be initialized at compile time, before any dynamic
+// initializer runs, where the compiler can check it.
+#if defined(__cpp_constinit)
+#define SGI_CONSTINIT constinit
+#elif defined(__clang__)
+#define SGI_CONSTINIT [[clang::require_constant_initialization]]
+#elif defined(__GNUC__) && __GNUC__ >= 10
+#define SGI_CONSTINIT __constinit
+#else
+#define SGI_CONSTINIT
+#endif
+
 namespace sgi {
 
 inline constexpr int ALIGN = 8;
 inline constexpr int MAX_BYTES = 128;
-inline constexpr int NFREELISTS = MAX_BYTES / ALIGN;
 inline constexpr int DEFAULT_CHUNKS = 20;
 
+// Above MAX_BYTES the slab tier takes over up to MAX_SLAB_BYTES, with
+// SLAB_STEPS geometric size classes per doubling. A request wastes less than
+// 1 / (SLAB_STEPS + 1) of its size class.
+inline constexpr int MAX_SLAB_BYTES = 32 * 1024;
+inline constexpr int SLAB_STEPS = 4;
+inline constexpr int NSLABCLASSES = 8 * SLAB_STEPS;  // 128 << 8 == 32K
+inline constexpr int NFREELISTS = MAX_BYTES / ALIGN + NSLABCLASSES;
+
+// Refill uses slow start: a size class begins at MIN_BATCH objects per refill
+// and doubles its batch on every refill, up to MAX_BATCH_BYTES worth of
+// objects and at most MAX_BATCH_OBJECTS, but never less than two objects.
+// Every SCAVENGE_REFILLS refills, a thread cache halves the batch of the size
+// classes that have not refilled since. A thread cache keeps up to two batches
+// per size class, the surplus is returned to the central pool one batch at a
+// time.
+//
+// Define SGI_FIXED_REFILL_BATCH to refill DEFAULT_CHUNKS objects at a time
+// instead, bounded by MAX_BATCH_BYTES.
+inline constexpr int MIN_BATCH = 2;
+inline constexpr int MAX_BATCH_OBJECTS = 256;
+inline constexpr int MAX_BATCH_BYTES = 32 * 1024;
+inline constexpr int SCAVENGE_REFILLS = 64;
+
+// The memory pool is made of spans: SPAN_BYTES sized blocks aligned to their
+// size, obtained from a ChunkProvider and each owned by one thread cache. The
+// first SPAN_HEADER_BYTES hold the owner, so that Deallocate can find it by
+// masking the address.
+inline constexpr size_t SPAN_BYTES = 256 * 1024;
+inline constexpr size_t SPAN_HEADER_BYTES = 64;
+
+// Objects of a size class are aligned to the largest power of two dividing
+// the class size, up to CACHE_LINE_BYTES, so a 64 byte object never straddles
+// two cache lines and Allocate(bytes, align) can serve alignments up to
+// CACHE_LINE_BYTES from the pool.
+inline constexpr size_t CACHE_LINE_BYTES = 64;
+
+// The default size classes: ALIGN byte steps up to MAX_BYTES, then SLAB_STEPS
+// geometric classes per doubling up to MAX_SLAB_BYTES.
+struct DefaultSizeClasses {
+  static constexpr std::array<size_t, NFREELISTS> sizes = [] {
+    std::array<size_t, NFREELISTS> sizes = {};
+    int n = 0;
+    for (size_t size = ALIGN; size <= MAX_BYTES; size += ALIGN) {
+      sizes[n++] = size;
+    }
+    for (size_t base = MAX_BYTES; base < MAX_SLAB_BYTES; base *= 2) {
+      for (int i = 1; i <= SLAB_STEPS; i++) {
+        sizes[n++] = base + base / SLAB_STEPS * i;
+      }
+    }
+    return sizes;
+  }();
+};
+
+// Whether sizes, an array of size classes, can be looked up by SizeClasses:
+// at most 256 strictly increasing multiples of ALIGN, from ALIGN up to
+// MAX_SLAB_BYTES, and multiples of 128 above 1024 bytes.
+template <typename Sizes>
+constexpr bool ValidSizeClasses(const Sizes& sizes) {
+  size_t n = std::size(sizes);
+  if (n == 0 || n > 256 || sizes[0] != ALIGN ||
+      sizes[n - 1] != MAX_SLAB_BYTES) {
+    return false;
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (sizes[i] % ALIGN != 0 || (sizes[i] > 1024 && sizes[i] % 128 != 0) ||
+        (i > 0 && sizes[i] <= sizes[i - 1])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Size of every free list's objects, and lookup tables mapping a request
+// to its free list, generated at compile time from Config::sizes: by 8 byte
+// steps up to 1024 bytes and by 128 byte steps above, so the lookup is a
+// single table index however uneven the classes are.
+//
+// Config is a type like DefaultSizeClasses whose static constexpr sizes array
+// holds the class sizes, for instance a table fitted to the sizes a workload
+// allocates by size_class_tool:
+//
+//   struct ObjectSizeClasses {
+//     static constexpr size_t sizes[] = {8, 16, 24, 40, 72, ..., 32768};
+//   };
+//   using ObjectAlloc = sgi::BasicDefaultAlloc<ObjectSizeClasses>;
+template <typename Config>
+struct SizeClasses {
+  static_assert(ValidSizeClasses(Config::sizes),
+                "size classes must be increasing multiples of ALIGN from "
+                "ALIGN to MAX_SLAB_BYTES, and of 128 above 1024 bytes");
+
+  static constexpr int NUM_CLASSES =
+      static_cast<int>(std::size(Config::sizes));
+
+  size_t sizes_[NUM_CLASSES];
+  size_t aligns_[NUM_CLASSES];
+  int batches_[NUM_CLASSES];  // upper bound of the slow start
+  unsigned char small_index_[1024 / 8 + 1];
+  unsigned char large_index_[MAX_SLAB_BYTES / 128 + 1];
+
+  constexpr SizeClasses()
+      : sizes_(), aligns_(), batches_(), small_index_(), large_index_() {
+    for (int i = 0; i < NUM_CLASSES; i++) {
+      sizes_[i] = Config::sizes[i];
+      size_t align = sizes_[i] & (~sizes_[i] + 1);
+      aligns_[i] = align > CACHE_LINE_BYTES ? CACHE_LINE_BYTES : align;
+
+      int batch = static_cast<int>(MAX_BATCH_BYTES / sizes_[i]);
+      batches_[i] = batch > MAX_BATCH_OBJECTS ? MAX_BATCH_OBJECTS
+                                              : (batch < 2 ? 2 : batch);
+    }
+
+    int index = 0;
+    for (size_t i = 0; i <= 1024 / 8; i++) {
+      while (sizes_[index] < i * 8) {
+        index++;
+      }
+      small_index_[i] = index;
+    }
+    index = 0;
+    for (size_t i = 0; i <= MAX_SLAB_BYTES / 128; i++) {
+      while (sizes_[index] < i * 128) {
+        index++;
+      }
+      large_index_[i] = index;
+    }
+  }
+
+  // The class of bytes, which must not exceed MAX_SLAB_BYTES.
+  constexpr size_t Index(size_t bytes) const {
+    if (bytes <= 1024) {
+      return small_index_[(bytes + 7) >> 3];
+    }
+    return large_index_[(bytes + 127) >> 7];
+  }
+
+  // The first class that holds bytes and is aligned to align, or NUM_CLASSES
+  // if there is none.
+  constexpr size_t AlignedIndex(size_t bytes, size_t align) const {
+    bytes = (bytes + align - 1) & ~(align - 1);
+    if (align > CACHE_LINE_BYTES || bytes > MAX_SLAB_BYTES) {
+      return NUM_CLASSES;
+    }
+    size_t index = Index(bytes);
+    while (aligns_[index] < align) {
+      index++;  // the largest size class is aligned to CACHE_LINE_BYTES
+    }
+    return index;
+  }
+};
+
 // second level memory allocator
-class DefaultAlloc {
+//
+// Requests up to MAX_SLAB_BYTES are served from size classes carved from
+// page-aligned spans: with DefaultSizeClasses, 8 bytes apart up to MAX_BYTES
+// and from the geometric slab tier above. Larger requests go to MallocAlloc.
+//
+// Every thread owns a ThreadCache with its own free lists and memory pool, so
+// Allocate and Deallocate take no lock on the fast path. The central pool,
+// guarded by central_mutex_, grows the heap and moves free objects between
+// threads in batches.
+//
+// An object freed by a thread other than the owner of its span is pushed to
+// the owner's lock-free remote_lists_, which the owner drains in Refill.
+//
+// Spans whose objects are all free can be handed back with Trim and
+// ReleaseFreeMemory, or automatically once the central pool holds more than
+// the threshold given to SetReleaseThreshold.
+//
+// Config supplies the size classes, see SizeClasses. Allocators with
+// different Configs have separate thread caches and pools.
+template <typename Config = DefaultSizeClasses>
+class BasicDefaultAlloc {
  public:
+  static constexpr int NUM_CLASSES = SizeClasses<Config>::NUM_CLASSES;
+
   static void* Allocate(size_t bytes) {
     assert(bytes > 0);
 
     // use malloc_alloc to allocate larger memory
-    if (bytes > MAX_BYTES) {
-      return sgi::MallocAlloc::Allocate(bytes);
+    if (bytes > MAX_SLAB_BYTES) {
+      void* p = sgi::MallocAlloc::Allocate(bytes);
+      ThreadCache* cache = GetThreadCache();
+      if ((cache->bytes_until_sample_ -= bytes) < 0) {
+        Sample(cache, p, bytes);
+      }
+      return p;
     }
 
-    bytes = RoundUp(bytes);
     size_t index = FreeListsIndex(bytes);
-    obj* free_head = free_lists_[index];
+    bytes = size_classes_.sizes_[index];
+    ThreadCache* cache = GetThreadCache();
+    SGI_ALLOC_STAT(cache->stats_[index].allocations_++);
+    obj* free_head = cache->free_lists_[index];
     if (free_head == nullptr) {
-      void* p = Refill(bytes);
-      return p;
+      free_head = reinterpret_cast<obj*>(Refill(cache, bytes));
+    } else {
+      cache->free_lists_[index] = free_head->next_free_obj;
+      cache->lengths_[index]--;
+      free_head->next_free_obj = nullptr;
     }
 
-    free_lists_[index] = free_head->next_free_obj;
-    free_head->next_free_obj = nullptr;
+    if ((cache->bytes_until_sample_ -= bytes) < 0) {
+      Sample(cache, free_head, bytes);
+    }
     return free_head;
   }
 
+  // align must be a power of two. Alignments up to CACHE_LINE_BYTES are
+  // served from the size classes, larger ones by MallocAlloc.
+  static void* Allocate(size_t bytes, size_t align) {
+    if (align <= ALIGN) {
+      return Allocate(bytes);
+    }
+    size_t index = AlignedFreeListsIndex(bytes, align);
+    if (index == NUM_CLASSES) {
+      return MallocAlloc::Allocate(bytes, align);
+    }
+    return Allocate(size_classes_.sizes_[index]);
+  }
+
   static void Deallocate(void* p, size_t bytes) {
-    if (bytes > MAX_BYTES) {
+    if (bytes > MAX_SLAB_BYTES) {
+      if (HeapProfiler::live_samples() != 0) {
+        HeapProfiler::RecordDeallocation(p);
+      }
       return MallocAlloc::Deallocate(p, bytes);
     }
 
-    bytes = RoundUp(bytes);
     size_t index = FreeListsIndex(bytes);
+    ThreadCache* cache = GetThreadCache();
+    SGI_ALLOC_STAT(cache->stats_[index].deallocations_++);
+    Span* span = SpanOf(p);
+    if (span->samples_.load(std::memory_order_relaxed) != 0) {
+      Unsample(span, p);
+    }
+    ThreadCache* owner = span->owner_;
+    if (owner != cache) {
+      return PushRemote(owner, index, static_cast<obj*>(p));
+    }
 
-    obj* free_head = free_lists_[index];
+    obj* free_head = cache->free_lists_[index];
     static_cast<obj*>(p)->next_free_obj = free_head;
-    free_lists_[index] = static_cast<obj*>(p);
+    cache->free_lists_[index] = static_cast<obj*>(p);
+    int batch = cache->batches_[index];
+    if (++cache->lengths_[index] > 2 * batch) {
+      ReleaseToCentral(cache, index, batch);
+    }
+  }
+
+  // p must come from Allocate(bytes, align)
+  static void Deallocate(void* p, size_t bytes, size_t align) {
+    if (align <= ALIGN) {
+      return Deallocate(p, bytes);
+    }
+    size_t index = AlignedFreeListsIndex(bytes, align);
+    if (index == NUM_CLASSES) {
+      return MallocAlloc::Deallocate(p, bytes, align);
+    }
+    Deallocate(p, size_classes_.sizes_[index]);
+  }
+
+  // Stores n objects of bytes in out. They are taken a free list segment at
+  // a time: first the thread cache's free list, then whole remote lists,
+  // batches of the central pool and runs carved from the memory pool, so
+  // building n objects costs O(n / batch) refills rather than O(n) calls to
+  // Allocate. Each object is freed with Deallocate or DeallocateBatch.
+  static void AllocateBatch(size_t bytes, size_t n, void** out) {
+    assert(bytes > 0);
+    if (bytes > MAX_SLAB_BYTES) {
+      for (size_t i = 0; i < n; i++) {
+        out[i] = Allocate(bytes);
+      }
+      return;
+    }
+
+    size_t index = FreeListsIndex(bytes);
+    bytes = size_classes_.sizes_[index];
+    ThreadCache* cache = GetThreadCache();
+    SGI_ALLOC_STAT(cache->stats_[index].allocations_ += n);
+    size_t count = 0;
+    while (true) {
+      obj* head = cache->free_lists_[index];
+      size_t taken = 0;
+      for (; count < n && head != nullptr; taken++) {
+        out[count++] = head;
+        head = head->next_free_obj;
+      }
+      cache->free_lists_[index] = head;
+      cache->lengths_[index] -= static_cast<int>(taken);
+      if (count == n) {
+        break;
+      }
+      count += RefillBatch(cache, bytes, n - count, out + count);
+    }
+
+    // a sample falls on each object where the countdown runs out
+    if ((cache->bytes_until_sample_ -= n * bytes) < 0) {
+      int64_t distance = cache->bytes_until_sample_ + n * bytes;
+      for (size_t i = 0; i < n; i++) {
+        if ((distance -= bytes) < 0) {
+          Sample(cache, out[i], bytes);
+          distance = cache->bytes_until_sample_;
+        }
+      }
+      cache->bytes_until_sample_ = distance;
+    }
+  }
+
+  // Frees the n objects of bytes ptrs points to. Objects of this thread's
+  // spans are linked into the free list in one go, and the surplus beyond one
+  // batch goes to the central pool under a single lock.
+  static void DeallocateBatch(void** ptrs, size_t n, size_t bytes) {
+    if (bytes > MAX_SLAB_BYTES) {
+      for (size_t i = 0; i < n; i++) {
+        Deallocate(ptrs[i], bytes);
+      }
+      return;
+    }
+
+    size_t index = FreeListsIndex(bytes);
+    ThreadCache* cache = GetThreadCache();
+    SGI_ALLOC_STAT(cache->stats_[index].deallocations_ += n);
+    obj* head = cache->free_lists_[index];
+    int count = 0;
+    for (size_t i = 0; i < n; i++) {
+      obj* p = static_cast<obj*>(ptrs[i]);
+      Span* span = SpanOf(p);
+      if (span->samples_.load(std::memory_order_relaxed) != 0) {
+        Unsample(span, p);
+      }
+      ThreadCache* owner = span->owner_;
+      if (owner != cache) {
+        PushRemote(owner, index, p);
+        continue;
+      }
+      p->next_free_obj = head;
+      head = p;
+      count++;
+    }
+    cache->free_lists_[index] = head;
+    cache->lengths_[index] += count;
+
+    int batch = cache->batches_[index];
+    if (cache->lengths_[index] > 2 * batch) {
+      ReleaseToCentral(cache, index, cache->lengths_[index] - batch);
+    }
   }
 
   static void* Reallocate(void* p, size_t old_sz, size_t new_sz) {
-    if (old_sz > MAX_BYTES && new_sz > MAX_BYTES) {
-      return std::realloc(p, new_sz);
+    if (old_sz > MAX_SLAB_BYTES && new_sz > MAX_SLAB_BYTES) {
+      // the block may move, it is not tracked any more
+      if (HeapProfiler::live_samples() != 0) {
+        HeapProfiler::RecordDeallocation(p);
+      }
+      return MallocAlloc::Reallocate(p, old_sz, new_sz);
     }
 
-    if (RoundUp(old_sz) == RoundUp(new_sz)) {
+    if (old_sz <= MAX_SLAB_BYTES && new_sz <= MAX_SLAB_BYTES &&
+        FreeListsIndex(old_sz) == FreeListsIndex(new_sz)) {
       return p;
     }
 
@@ -69,88 +410,808 @@ class DefaultAlloc {
     return new_p;
   }
 
+  // Moves the fully free spans of the calling thread to the central pool,
+  // where any thread can reuse them. Returns the number of bytes moved.
+  static size_t Trim();
+
+  // Trims the calling thread and the threads that have exited, then returns
+  // the pages of all unused spans to the operating system through their
+  // ChunkProvider, with madvise(MADV_DONTNEED) by default. Returns the number
+  // of bytes released.
+  //
+  // Also registered as a MemoryPressure callback, see memory_pressure.h, so
+  // it runs when the system is out of memory or over the soft limit. Spans
+  // are charged to MemoryPressure until their pages are released.
+  static size_t ReleaseFreeMemory();
+
+  // Calls ReleaseFreeMemory whenever the central pool holds more than bytes
+  // of free objects. 0, the default, turns it off.
+  static void SetReleaseThreshold(size_t bytes) {
+    std::lock_guard<std::mutex> lock(central_mutex_);
+    release_threshold_ = bytes;
+  }
+
+  // New spans come from provider, which must outlive every span it handed
+  // out. nullptr restores the default MmapChunkProvider. Unused spans are
+  // only reused while their provider is installed.
+  static ChunkProvider* SetChunkProvider(ChunkProvider* provider) {
+    std::lock_guard<std::mutex> lock(central_mutex_);
+    ChunkProvider* old_provider = chunk_provider_;
+    chunk_provider_ =
+        provider != nullptr ? provider : &default_chunk_provider_;
+    return old_provider;
+  }
+
+  // Samples one allocation every bytes allocated on average for the heap
+  // profile, see heap_profiler.h. 0, the default, turns sampling off;
+  // allocations sampled so far are tracked until they are freed.
+  static void SetProfileSampleInterval(size_t bytes);
+
+  using Stats = AllocStats<NUM_CLASSES>;
+
+  // Adds up the counters of all thread caches and the central pool. The
+  // event counters read zero when SGI_NO_ALLOC_STATS is defined.
+  static Stats GetStats();
+
+  static void DumpStats(std::FILE* out = stderr) {
+    sgi::DumpStats(GetStats(), out);
+  }
+
  private:
   union obj {
     obj* next_free_obj;
     char data[1];
   };
 
+  struct Span;
+
+  struct SizeClassStats {
+    RelaxedCounter<uint64_t> allocations_;
+    RelaxedCounter<uint64_t> deallocations_;
+    RelaxedCounter<uint64_t> refills_;
+    RelaxedCounter<uint64_t> refill_objects_;
+  };
+
+  // Per-thread front end. Only the owning thread writes it, except while it
+  // sits in idle_caches_ after its thread has exited, and except for
+  // remote_lists_ which any thread may push to. GetStats reads the counters
+  // from any thread.
+  struct ThreadCache {
+    obj* free_lists_[NUM_CLASSES];
+    RelaxedCounter<int> lengths_[NUM_CLASSES];
+
+    // slow start, see Refill
+    int batches_[NUM_CLASSES];
+    bool refilled_[NUM_CLASSES];  // since the last Scavenge
+    unsigned refills_;
+
+    // memory pool
+    char* start_free_;
+    char* end_free_;
+    RelaxedCounter<size_t> pool_bytes_;  // end_free_ - start_free_
+    Span* spans_;
+
+    // heap profile, see Sample
+    RelaxedCounter<int64_t> bytes_until_sample_;
+    uint64_t sample_rng_;
+
+    ThreadCache* next_idle_;
+    ThreadCache* next_cache_;  // all_caches_
+
+#ifndef SGI_NO_ALLOC_STATS
+    SizeClassStats stats_[NUM_CLASSES];
+#endif  // SGI_NO_ALLOC_STATS
+
+    // Multi-producer single-consumer stacks of objects freed by other
+    // threads. Producers only push, and the owner takes a whole stack at once
+    // with exchange, so no popped node is ever reused under a pending CAS
+    // and the ABA problem cannot occur.
+    alignas(64) std::atomic<obj*> remote_lists_[NUM_CLASSES];
+  };
+
+  struct Span {
+    ThreadCache* owner_;
+    ChunkProvider* provider_;
+    Span* next_;         // in the owner's spans_ or in free_spans_
+    size_t free_bytes_;  // scratch space for TrimCache
+    bool released_;      // pages have been returned to the OS
+    std::atomic<int> samples_;  // sampled objects for the heap profile
+  };
+  static_assert(sizeof(Span) <= SPAN_HEADER_BYTES);
+
   static size_t RoundUp(size_t bytes) {
     return (bytes + ALIGN - 1) & (~(ALIGN - 1));
   }
 
+  // bytes must not exceed MAX_SLAB_BYTES
   static size_t FreeListsIndex(size_t bytes) {
-    return (bytes + ALIGN - 1) / ALIGN - 1;
+    return size_classes_.Index(bytes);
+  }
+
+  // The first size class that holds bytes and is aligned to align, or
+  // NUM_CLASSES if there is none.
+  static size_t AlignedFreeListsIndex(size_t bytes, size_t align) {
+    return size_classes_.AlignedIndex(bytes, align);
+  }
+
+  static ThreadCache* GetThreadCache() {
+    ThreadCache* cache = thread_cache_;
+    if (cache == nullptr) {
+      cache = CreateThreadCache();
+    }
+    return cache;
   }
 
-  static char* AllocChunk(size_t bytes, int& objs);  // nobj may change
-  static char* Refill(size_t bytes);
+  static Span* SpanOf(void* p) {
+    return reinterpret_cast<Span*>(reinterpret_cast<uintptr_t>(p) &
+                                   ~(SPAN_BYTES - 1));
+  }
+
+  static void PushRemote(ThreadCache* owner, size_t index, obj* p) {
+    obj* head = owner->remote_lists_[index].load(std::memory_order_relaxed);
+    do {
+      p->next_free_obj = head;
+    } while (!owner->remote_lists_[index].compare_exchange_weak(
+        head, p, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  static ThreadCache* CreateThreadCache();
+  static void ReleaseThreadCache(void* cache);  // runs at thread exit
+
+  // the following two require central_mutex_ to be held
+  static void ReclaimCentral();
+  static size_t TrimCache(ThreadCache* cache);
+
+  static char* AllocChunk(ThreadCache* cache, size_t bytes,
+                          int& nobjs);  // nobjs may change
+  static void FreeLeftover(ThreadCache* cache, size_t bytes);
+  static char* Refill(ThreadCache* cache, size_t bytes);
+  static size_t RefillBatch(ThreadCache* cache, size_t bytes, size_t n,
+                            void** out);
+  static void Scavenge(ThreadCache* cache);
+  static char* ExtendHeap(ThreadCache* cache, bool use_oom_handler);
+  static void Sample(ThreadCache* cache, void* p, size_t bytes);
+  static void Unsample(Span* span, void* p);
+
+  static size_t RelieveMemoryPressure(void*) { return ReleaseFreeMemory(); }
+  static obj* DrainRemote(ThreadCache* cache, size_t index, int& nobjs);
+
+  // batch transfer between a thread cache and the central pool
+  static obj* FetchFromCentral(size_t index, int& nobjs);  // nobjs may change
+  static void ReleaseToCentral(ThreadCache* cache, size_t index, int nobjs);
 
-  static obj* free_lists_[NFREELISTS];
+  static constexpr SizeClasses<Config> size_classes_{};
+  static thread_local ThreadCache* thread_cache_;
 
-  // memory pool
-  static char* start_free_;
-  static char* end_free_;
+  // central pool
+  static std::mutex central_mutex_;
+  static obj* central_lists_[NUM_CLASSES];
+  static size_t central_lengths_[NUM_CLASSES];
+  static size_t central_bytes_;
+  static size_t release_threshold_;
   static size_t extend_heap_size_;
+  static Span* free_spans_;
+  static MmapChunkProvider default_chunk_provider_;
+  static ChunkProvider* chunk_provider_;
+  static ThreadCache* idle_caches_;
+  static ThreadCache* all_caches_;
+  static size_t num_caches_;
 };
 
-DefaultAlloc::obj* DefaultAlloc::free_lists_[NFREELISTS] = {nullptr};
-char* DefaultAlloc::start_free_ = nullptr;
-char* DefaultAlloc::end_free_ = nullptr;
-size_t DefaultAlloc::extend_heap_size_ = 0;
+using DefaultAlloc = BasicDefaultAlloc<>;
 
-char* DefaultAlloc::AllocChunk(size_t bytes, int& nobjs) {
-  size_t total_bytes = bytes * nobjs;
-  size_t bytes_left = end_free_ - start_free_;
+// The statics are all constant initialized, so that DefaultAlloc works from
+// the constructors of other translation units and libraries, which may run
+// first, as malloc_shim.cc needs.
+template <typename Config>
+SGI_CONSTINIT thread_local typename BasicDefaultAlloc<Config>::ThreadCache*
+    BasicDefaultAlloc<Config>::thread_cache_ = nullptr;
+template <typename Config>
+SGI_CONSTINIT std::mutex BasicDefaultAlloc<Config>::central_mutex_;
+template <typename Config>
+SGI_CONSTINIT typename BasicDefaultAlloc<Config>::obj*
+    BasicDefaultAlloc<Config>::central_lists_[NUM_CLASSES] = {nullptr};
+template <typename Config>
+SGI_CONSTINIT size_t
+    BasicDefaultAlloc<Config>::central_lengths_[NUM_CLASSES] = {0};
+template <typename Config>
+SGI_CONSTINIT size_t BasicDefaultAlloc<Config>::central_bytes_ = 0;
+template <typename Config>
+SGI_CONSTINIT size_t BasicDefaultAlloc<Config>::release_threshold_ = 0;
+template <typename Config>
+SGI_CONSTINIT size_t BasicDefaultAlloc<Config>::extend_heap_size_ = 0;
+template <typename Config>
+SGI_CONSTINIT typename BasicDefaultAlloc<Config>::Span*
+    BasicDefaultAlloc<Config>::free_spans_ = nullptr;
+template <typename Config>
+SGI_CONSTINIT MmapChunkProvider
+    BasicDefaultAlloc<Config>::default_chunk_provider_;
+template <typename Config>
+SGI_CONSTINIT ChunkProvider* BasicDefaultAlloc<Config>::chunk_provider_ =
+    &BasicDefaultAlloc<Config>::default_chunk_provider_;
+template <typename Config>
+SGI_CONSTINIT typename BasicDefaultAlloc<Config>::ThreadCache*
+    BasicDefaultAlloc<Config>::idle_caches_ = nullptr;
+template <typename Config>
+SGI_CONSTINIT typename BasicDefaultAlloc<Config>::ThreadCache*
+    BasicDefaultAlloc<Config>::all_caches_ = nullptr;
+template <typename Config>
+SGI_CONSTINIT size_t BasicDefaultAlloc<Config>::num_caches_ = 0;
 
-  char* res = start_free_;
-  if (bytes_left >= total_bytes) {
-    start_free_ += total_bytes;
-    return res;
+template <typename Config>
+typename BasicDefaultAlloc<Config>::ThreadCache*
+BasicDefaultAlloc<Config>::CreateThreadCache() {
+  // set up with the first thread cache, as the order in which the statics of
+  // class templates are initialized is unspecified
+  static const pthread_key_t cache_key = [] {
+    pthread_key_t key;
+    pthread_key_create(&key, ReleaseThreadCache);
+    MemoryPressure::AddCallback(RelieveMemoryPressure, nullptr);
+    return key;
+  }();
+
+  ThreadCache* cache = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(central_mutex_);
+    if (idle_caches_ != nullptr) {
+      cache = idle_caches_;
+      idle_caches_ = cache->next_idle_;
+    }
+  }
+
+  if (cache == nullptr) {
+    void* p = MallocAlloc::Allocate(sizeof(ThreadCache), alignof(ThreadCache));
+    cache = new (p) ThreadCache();
+    for (int i = 0; i < NUM_CLASSES; i++) {
+#ifdef SGI_FIXED_REFILL_BATCH
+      int batch = size_classes_.batches_[i];
+      cache->batches_[i] = batch > DEFAULT_CHUNKS ? DEFAULT_CHUNKS : batch;
+#else
+      cache->batches_[i] = MIN_BATCH;
+#endif  // SGI_FIXED_REFILL_BATCH
+    }
+    cache->sample_rng_ = reinterpret_cast<uintptr_t>(cache) | 1;
+    cache->bytes_until_sample_ = HeapProfiler::NextSampleDistance(
+        cache->sample_rng_);
+
+    std::lock_guard<std::mutex> lock(central_mutex_);
+    cache->next_cache_ = all_caches_;
+    all_caches_ = cache;
+    num_caches_++;
   }
+  cache->next_idle_ = nullptr;
 
-  if (bytes_left >= bytes) {
-    nobjs = bytes_left / bytes;
-    total_bytes = nobjs * bytes;
-    start_free_ += total_bytes;
+  // the key destructor hands the cache back when this thread exits
+  pthread_setspecific(cache_key, cache);
+  thread_cache_ = cache;
+  return cache;
+}
+
+template <typename Config>
+void BasicDefaultAlloc<Config>::ReleaseThreadCache(void* ptr) {
+  ThreadCache* cache = static_cast<ThreadCache*>(ptr);
+  for (int i = 0; i < NUM_CLASSES; i++) {
+    if (cache->lengths_[i] > 0) {
+      ReleaseToCentral(cache, i, cache->lengths_[i]);
+    }
+  }
+
+  // the remaining memory pool and the remote lists are kept and reused by the
+  // next new thread
+  std::lock_guard<std::mutex> lock(central_mutex_);
+  cache->next_idle_ = idle_caches_;
+  idle_caches_ = cache;
+  thread_cache_ = nullptr;
+}
+
+template <typename Config>
+typename BasicDefaultAlloc<Config>::obj*
+BasicDefaultAlloc<Config>::FetchFromCentral(size_t index, int& nobjs) {
+  std::lock_guard<std::mutex> lock(central_mutex_);
+  obj* head = central_lists_[index];
+  if (head == nullptr) {
+    return nullptr;
+  }
+
+  obj* tail = head;
+  int count = 1;
+  while (count < nobjs && tail->next_free_obj != nullptr) {
+    tail = tail->next_free_obj;
+    count++;
+  }
+  central_lists_[index] = tail->next_free_obj;
+  tail->next_free_obj = nullptr;
+  central_lengths_[index] -= count;
+  central_bytes_ -= count * size_classes_.sizes_[index];
+  nobjs = count;
+  return head;
+}
+
+template <typename Config>
+void BasicDefaultAlloc<Config>::ReleaseToCentral(ThreadCache* cache,
+                                                 size_t index, int nobjs) {
+  // cut the batch off the thread cache before taking the lock
+  obj* head = cache->free_lists_[index];
+  obj* tail = head;
+  for (int i = 1; i < nobjs; i++) {
+    tail = tail->next_free_obj;
+  }
+  cache->free_lists_[index] = tail->next_free_obj;
+  cache->lengths_[index] -= nobjs;
+
+  bool over_threshold = false;
+  {
+    std::lock_guard<std::mutex> lock(central_mutex_);
+    tail->next_free_obj = central_lists_[index];
+    central_lists_[index] = head;
+    central_lengths_[index] += nobjs;
+    central_bytes_ += nobjs * size_classes_.sizes_[index];
+    over_threshold =
+        release_threshold_ != 0 && central_bytes_ > release_threshold_;
+  }
+
+  if (over_threshold) {
+    ReleaseFreeMemory();
+  }
+}
+
+template <typename Config>
+void BasicDefaultAlloc<Config>::ReclaimCentral() {
+  // every object goes back to the owner of its span, which can then find
+  // out whether the span is fully free
+  for (int i = 0; i < NUM_CLASSES; i++) {
+    obj* curr = central_lists_[i];
+    while (curr != nullptr) {
+      obj* next = curr->next_free_obj;
+      PushRemote(SpanOf(curr)->owner_, i, curr);
+      curr = next;
+    }
+    central_lists_[i] = nullptr;
+    central_lengths_[i] = 0;
+  }
+  central_bytes_ = 0;
+}
+
+template <typename Config>
+size_t BasicDefaultAlloc<Config>::TrimCache(ThreadCache* cache) {
+  for (int i = 0; i < NUM_CLASSES; i++) {
+    int nobjs = 0;
+    obj* head = DrainRemote(cache, i, nobjs);
+    while (head != nullptr) {
+      obj* next = head->next_free_obj;
+      head->next_free_obj = cache->free_lists_[i];
+      cache->free_lists_[i] = head;
+      head = next;
+    }
+    cache->lengths_[i] += nobjs;
+  }
+
+  // add up the free bytes of every span of this cache
+  for (Span* span = cache->spans_; span != nullptr; span = span->next_) {
+    span->free_bytes_ = 0;
+  }
+  for (int i = 0; i < NUM_CLASSES; i++) {
+    for (obj* curr = cache->free_lists_[i]; curr != nullptr;
+         curr = curr->next_free_obj) {
+      Span* span = SpanOf(curr);
+      if (span->owner_ == cache) {
+        span->free_bytes_ += size_classes_.sizes_[i];
+      }
+    }
+  }
+  if (cache->start_free_ != cache->end_free_ &&
+      SpanOf(cache->start_free_)->owner_ == cache) {
+    SpanOf(cache->start_free_)->free_bytes_ +=
+        cache->end_free_ - cache->start_free_;
+  }
+
+  const size_t payload = SPAN_BYTES - SPAN_HEADER_BYTES;
+  Span* busy_spans = nullptr;
+  Span* idle_spans = nullptr;
+  size_t trimmed = 0;
+  for (Span* span = cache->spans_; span != nullptr;) {
+    Span* next = span->next_;
+    if (span->free_bytes_ == payload) {
+      span->next_ = idle_spans;
+      idle_spans = span;
+      trimmed += SPAN_BYTES;
+    } else {
+      span->next_ = busy_spans;
+      busy_spans = span;
+    }
+    span = next;
+  }
+  cache->spans_ = busy_spans;
+  if (idle_spans == nullptr) {
+    return 0;
+  }
+
+  // drop the objects of fully free spans from the free lists
+  for (int i = 0; i < NUM_CLASSES; i++) {
+    obj** link = &cache->free_lists_[i];
+    while (*link != nullptr) {
+      Span* span = SpanOf(*link);
+      if (span->owner_ == cache && span->free_bytes_ == payload) {
+        *link = (*link)->next_free_obj;
+        cache->lengths_[i]--;
+      } else {
+        link = &(*link)->next_free_obj;
+      }
+    }
+  }
+  if (cache->start_free_ != cache->end_free_ &&
+      SpanOf(cache->start_free_)->free_bytes_ == payload) {
+    cache->start_free_ = cache->end_free_ = nullptr;
+    cache->pool_bytes_ = 0;
+  }
+
+  while (idle_spans != nullptr) {
+    Span* next = idle_spans->next_;
+    idle_spans->owner_ = nullptr;
+    idle_spans->next_ = free_spans_;
+    free_spans_ = idle_spans;
+    idle_spans = next;
+  }
+  return trimmed;
+}
+
+template <typename Config>
+size_t BasicDefaultAlloc<Config>::Trim() {
+  ThreadCache* cache = GetThreadCache();
+  std::lock_guard<std::mutex> lock(central_mutex_);
+  ReclaimCentral();
+  return TrimCache(cache);
+}
+
+template <typename Config>
+size_t BasicDefaultAlloc<Config>::ReleaseFreeMemory() {
+  // may run while the calling thread creates its cache, see MemoryPressure
+  ThreadCache* cache = thread_cache_;
+  std::lock_guard<std::mutex> lock(central_mutex_);
+  ReclaimCentral();
+  if (cache != nullptr) {
+    TrimCache(cache);
+  }
+  for (ThreadCache* idle = idle_caches_; idle != nullptr;
+       idle = idle->next_idle_) {
+    TrimCache(idle);
+  }
+
+  // keep the header page, it links the span into free_spans_
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t released = 0;
+  for (Span* span = free_spans_; span != nullptr; span = span->next_) {
+    if (!span->released_) {
+      span->provider_->ReleasePages(reinterpret_cast<char*>(span) + page_size,
+                                    SPAN_BYTES - page_size);
+      span->released_ = true;
+      released += SPAN_BYTES - page_size;
+    }
+  }
+  MemoryPressure::Uncharge(released);
+  return released;
+}
+
+template <typename Config>
+typename BasicDefaultAlloc<Config>::obj*
+BasicDefaultAlloc<Config>::DrainRemote(ThreadCache* cache, size_t index,
+                                       int& nobjs) {
+  obj* head = cache->remote_lists_[index].exchange(nullptr,
+                                                   std::memory_order_acquire);
+  nobjs = 0;
+  for (obj* curr = head; curr != nullptr; curr = curr->next_free_obj) {
+    nobjs++;
+  }
+  return head;
+}
+
+template <typename Config>
+typename BasicDefaultAlloc<Config>::Stats
+BasicDefaultAlloc<Config>::GetStats() {
+  Stats stats = {};
+  std::lock_guard<std::mutex> lock(central_mutex_);
+  for (int i = 0; i < NUM_CLASSES; i++) {
+    stats.size_classes[i].size = size_classes_.sizes_[i];
+    stats.size_classes[i].free_list_bytes =
+        central_lengths_[i] * size_classes_.sizes_[i];
+  }
+
+  for (ThreadCache* cache = all_caches_; cache != nullptr;
+       cache = cache->next_cache_) {
+    for (int i = 0; i < NUM_CLASSES; i++) {
+      typename Stats::SizeClass& size_class = stats.size_classes[i];
+      size_class.free_list_bytes += cache->lengths_[i] * size_class.size;
+#ifndef SGI_NO_ALLOC_STATS
+      size_class.allocations += cache->stats_[i].allocations_;
+      size_class.deallocations += cache->stats_[i].deallocations_;
+      size_class.refills += cache->stats_[i].refills_;
+      size_class.refill_objects += cache->stats_[i].refill_objects_;
+#endif  // SGI_NO_ALLOC_STATS
+    }
+    stats.pool_bytes += cache->pool_bytes_;
+  }
+
+  for (const auto& size_class : stats.size_classes) {
+    stats.free_list_bytes += size_class.free_list_bytes;
+  }
+  for (Span* span = free_spans_; span != nullptr; span = span->next_) {
+    stats.free_span_bytes += SPAN_BYTES;
+    if (span->released_) {
+      stats.released_bytes += SPAN_BYTES;
+    }
+  }
+  stats.extend_heap_size = extend_heap_size_;
+  stats.thread_caches = num_caches_;
+  return stats;
+}
+
+// Returns the first free byte of a new span owned by cache. If the system is
+// out of memory, returns nullptr unless use_oom_handler is set.
+template <typename Config>
+char* BasicDefaultAlloc<Config>::ExtendHeap(ThreadCache* cache,
+                                            bool use_oom_handler) {
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  Span* span = nullptr;
+  ChunkProvider* provider = nullptr;
+  size_t charge = 0;  // charged once the lock is released
+  {
+    std::lock_guard<std::mutex> lock(central_mutex_);
+    provider = chunk_provider_;
+    for (Span** link = &free_spans_; *link != nullptr;
+         link = &(*link)->next_) {
+      if ((*link)->provider_ == provider) {
+        span = *link;
+        *link = span->next_;
+        // released pages come back as they are touched
+        charge = span->released_ ? SPAN_BYTES - page_size : 0;
+        break;
+      }
+    }
+
+    if (span == nullptr) {
+      span = static_cast<Span*>(provider->AllocateChunk(SPAN_BYTES));
+      if (span != nullptr) {
+        extend_heap_size_ += SPAN_BYTES;
+        charge = SPAN_BYTES;
+      }
+    }
+  }
+
+  if (span == nullptr) {
+    if (!use_oom_handler) {
+      return nullptr;
+    }
+    // pages of a malloc'ed span can be given back with madvise too
+    provider = &default_chunk_provider_;
+    span = static_cast<Span*>(MallocAlloc::Allocate(SPAN_BYTES, SPAN_BYTES));
+    std::lock_guard<std::mutex> lock(central_mutex_);
+    extend_heap_size_ += SPAN_BYTES;
+  }
+
+  span->owner_ = cache;
+  span->provider_ = provider;
+  span->next_ = cache->spans_;
+  span->free_bytes_ = 0;
+  span->released_ = false;
+  span->samples_.store(0, std::memory_order_relaxed);
+  cache->spans_ = span;
+
+  // may run ReleaseFreeMemory, which finds no free object in the new span
+  MemoryPressure::Charge(charge);
+  return reinterpret_cast<char*>(span) + SPAN_HEADER_BYTES;
+}
+
+template <typename Config>
+char* BasicDefaultAlloc<Config>::AllocChunk(ThreadCache* cache, size_t bytes,
+                                            int& nobjs) {
+  size_t bytes_left = cache->end_free_ - cache->start_free_;
+  size_t align = size_classes_.aligns_[FreeListsIndex(bytes)];
+  size_t gap = (~reinterpret_cast<uintptr_t>(cache->start_free_) + 1) &
+               (align - 1);
+
+  if (bytes_left >= gap + bytes) {
+    // the gap up to the alignment of the size class goes to the free lists
+    FreeLeftover(cache, gap);
+    bytes_left -= gap;
+    if (bytes_left < bytes * nobjs) {
+      nobjs = bytes_left / bytes;
+    }
+    char* res = cache->start_free_;
+    cache->start_free_ += bytes * nobjs;
     return res;
   }
 
   // memory pool expansion: add the remaining space to
   // free_lists_ and then apply for memory
-  assert(bytes_left % ALIGN == 0);
-  if (bytes_left != 0) {
-    int index = FreeListsIndex(bytes_left);
-    obj* curr = reinterpret_cast<obj*>(start_free_);
-    curr->next_free_obj = free_lists_[index];
-    free_lists_[index] = curr;
-    start_free_ = end_free_ = nullptr;
-  }
-
-  size_t bytes_to_get = 2 * total_bytes + RoundUp(extend_heap_size_ >> 4);
-  start_free_ = static_cast<char*>(std::malloc(bytes_to_get));
-  if (start_free_ == nullptr) {
-    for (int i = bytes; i <= MAX_BYTES; i += ALIGN) {
-      int index = FreeListsIndex(i);
-      obj* ptr = free_lists_[index];
+  FreeLeftover(cache, bytes_left);
+  cache->start_free_ = cache->end_free_ = nullptr;
+
+  cache->start_free_ = ExtendHeap(cache, false);
+  if (cache->start_free_ == nullptr) {
+    for (int index = FreeListsIndex(bytes); index < NUM_CLASSES; index++) {
+      obj* ptr = cache->free_lists_[index];
       if (ptr != nullptr) {
-        free_lists_[index] = ptr->next_free_obj;
-        start_free_ = reinterpret_cast<char*>(ptr);
-        end_free_ = start_free_ + i;
-        return AllocChunk(bytes, nobjs);
+        cache->free_lists_[index] = ptr->next_free_obj;
+        cache->lengths_[index]--;
+        cache->start_free_ = reinterpret_cast<char*>(ptr);
+        cache->end_free_ = cache->start_free_ + size_classes_.sizes_[index];
+        return AllocChunk(cache, bytes, nobjs);
       }
     }
     // Go to malloc's OOM handler
-    return static_cast<char*>(MallocAlloc::Allocate(total_bytes));
+    cache->start_free_ = ExtendHeap(cache, true);
   }
-  end_free_ = start_free_ + bytes_to_get;
-  extend_heap_size_ += bytes_to_get;
-  return AllocChunk(bytes, nobjs);
+  cache->end_free_ = cache->start_free_ + (SPAN_BYTES - SPAN_HEADER_BYTES);
+  return AllocChunk(cache, bytes, nobjs);
 }
 
-char* DefaultAlloc::Refill(size_t bytes) {
-  int nobjs = DEFAULT_CHUNKS;
-  char* start = AllocChunk(bytes, nobjs);  // nobjs may change
+template <typename Config>
+void BasicDefaultAlloc<Config>::SetProfileSampleInterval(size_t bytes) {
+  HeapProfiler::SetSampleInterval(bytes);
+  // the threads draw their next distance once this one runs out
+  std::lock_guard<std::mutex> lock(central_mutex_);
+  for (ThreadCache* cache = all_caches_; cache != nullptr;
+       cache = cache->next_cache_) {
+    cache->bytes_until_sample_ = bytes == 0 ? INT64_MAX : bytes;
+  }
+}
+
+// Called once the sampling countdown of cache runs out, p being the object
+// allocated last. Draws the next countdown and records p unless sampling has
+// been turned off since.
+template <typename Config>
+void BasicDefaultAlloc<Config>::Sample(ThreadCache* cache, void* p,
+                                       size_t bytes) {
+  cache->bytes_until_sample_ = HeapProfiler::NextSampleDistance(
+      cache->sample_rng_);
+  if (HeapProfiler::sample_interval() == 0 ||
+      !HeapProfiler::RecordAllocation(p, bytes)) {
+    return;
+  }
+  if (bytes <= MAX_SLAB_BYTES) {
+    SpanOf(p)->samples_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// p is an object of span, which has sampled objects
+template <typename Config>
+void BasicDefaultAlloc<Config>::Unsample(Span* span, void* p) {
+  if (HeapProfiler::RecordDeallocation(p)) {
+    span->samples_.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+// Stores up to n objects of bytes in out, one segment at a time: the whole
+// remote list, a batch of up to n objects from the central pool, or a run of
+// up to a span's worth carved from the memory pool. Remote objects beyond n
+// go to the free list. Returns the number of objects stored.
+template <typename Config>
+size_t BasicDefaultAlloc<Config>::RefillBatch(ThreadCache* cache, size_t bytes,
+                                              size_t n, void** out) {
+  size_t index = FreeListsIndex(bytes);
+  SGI_ALLOC_STAT(cache->stats_[index].refills_++);
+  cache->refilled_[index] = true;
+  size_t span_objs = (SPAN_BYTES - SPAN_HEADER_BYTES) / bytes;
+  int wanted = static_cast<int>(n < span_objs ? n : span_objs);
+
+  int nobjs = 0;
+  obj* head = DrainRemote(cache, index, nobjs);
+  if (head == nullptr) {
+    nobjs = wanted;
+    head = FetchFromCentral(index, nobjs);  // nobjs may change
+  }
+  if (head != nullptr) {
+    SGI_ALLOC_STAT(cache->stats_[index].refill_objects_ += nobjs);
+    size_t count = 0;
+    for (; count < n && head != nullptr; head = head->next_free_obj) {
+      out[count++] = head;
+    }
+    if (head != nullptr) {
+      obj* tail = head;
+      while (tail->next_free_obj != nullptr) {
+        tail = tail->next_free_obj;
+      }
+      tail->next_free_obj = cache->free_lists_[index];
+      cache->free_lists_[index] = head;
+      cache->lengths_[index] += nobjs - static_cast<int>(count);
+    }
+    return count;
+  }
+
+  nobjs = wanted;
+  char* start = AllocChunk(cache, bytes, nobjs);  // nobjs may change
+  cache->pool_bytes_ = cache->end_free_ - cache->start_free_;
+  SGI_ALLOC_STAT(cache->stats_[index].refill_objects_ += nobjs);
+  for (int i = 0; i < nobjs; i++) {
+    out[i] = start + i * bytes;
+  }
+  return nobjs;
+}
+
+// Halves the batch of every size class that has not refilled since the last
+// call, and returns what its free list holds beyond one batch to the central
+// pool, so rarely used size classes do not pin memory in every thread cache.
+template <typename Config>
+void BasicDefaultAlloc<Config>::Scavenge(ThreadCache* cache) {
+  for (int i = 0; i < NUM_CLASSES; i++) {
+    if (cache->refilled_[i]) {
+      cache->refilled_[i] = false;
+      continue;
+    }
+    if (cache->batches_[i] > MIN_BATCH) {
+      cache->batches_[i] /= 2;
+    }
+    if (cache->lengths_[i] > cache->batches_[i]) {
+      ReleaseToCentral(cache, i, cache->lengths_[i] - cache->batches_[i]);
+    }
+  }
+}
+
+// Splits the first bytes of the memory pool into objects of the largest size
+// classes that fit and whose alignment they meet, and frees them.
+template <typename Config>
+void BasicDefaultAlloc<Config>::FreeLeftover(ThreadCache* cache,
+                                             size_t bytes) {
+  assert(bytes % ALIGN == 0);
+  while (bytes != 0) {
+    size_t index = FreeListsIndex(bytes);
+    if (size_classes_.sizes_[index] > bytes) {
+      index--;
+    }
+    // the smallest size class only needs ALIGN
+    while (reinterpret_cast<uintptr_t>(cache->start_free_) %
+               size_classes_.aligns_[index] !=
+           0) {
+      index--;
+    }
+    obj* curr = reinterpret_cast<obj*>(cache->start_free_);
+    curr->next_free_obj = cache->free_lists_[index];
+    cache->free_lists_[index] = curr;
+    cache->lengths_[index]++;
+    cache->start_free_ += size_classes_.sizes_[index];
+    bytes -= size_classes_.sizes_[index];
+  }
+}
+
+template <typename Config>
+char* BasicDefaultAlloc<Config>::Refill(ThreadCache* cache, size_t bytes) {
+  size_t index = FreeListsIndex(bytes);
+  SGI_ALLOC_STAT(cache->stats_[index].refills_++);
+
+#ifndef SGI_FIXED_REFILL_BATCH
+  if (++cache->refills_ % SCAVENGE_REFILLS == 0) {
+    Scavenge(cache);
+  }
+
+  // a size class that keeps missing takes twice as many objects next time
+  int batch = cache->batches_[index];
+  int max_batch = size_classes_.batches_[index];
+  cache->batches_[index] = 2 * batch > max_batch ? max_batch : 2 * batch;
+  cache->refilled_[index] = true;
+#else
+  int batch = cache->batches_[index];
+#endif  // SGI_FIXED_REFILL_BATCH
+  int nobjs = batch;
+
+  // objects freed by other threads come back first, then the ones other
+  // threads have returned to the central pool
+  obj* head = DrainRemote(cache, index, nobjs);
+  if (head == nullptr) {
+    nobjs = batch;
+    head = FetchFromCentral(index, nobjs);  // nobjs may change
+  }
+  if (head != nullptr) {
+    SGI_ALLOC_STAT(cache->stats_[index].refill_objects_ += nobjs);
+    cache->free_lists_[index] = head->next_free_obj;
+    cache->lengths_[index] = nobjs - 1;
+    head->next_free_obj = nullptr;
+    return reinterpret_cast<char*>(head);
+  }
+
+  nobjs = batch;
+  char* start = AllocChunk(cache, bytes, nobjs);  // nobjs may change
+  cache->pool_bytes_ = cache->end_free_ - cache->start_free_;
+  SGI_ALLOC_STAT(cache->stats_[index].refill_objects_ += nobjs);
 
   if (nobjs == 1) {
     return start;
@@ -165,11 +1226,14 @@ char* DefaultAlloc::Refill(size_t bytes) {
     prev = curr;
   }
 
-  int index = FreeListsIndex(bytes);
-  free_lists_[index] = reinterpret_cast<obj*>(start)->next_free_obj;
+  // AllocChunk may have put leftover pool bytes on this very list, so the
+  // new objects go in front of them
+  prev->next_free_obj = cache->free_lists_[index];
+  cache->free_lists_[index] = reinterpret_cast<obj*>(start)->next_free_obj;
+  cache->lengths_[index] += nobjs - 1;
   return start;
 }
 
 }  // namespace sgi
 
-#endif  // ALLOCATOR_DEFAULT_ALLOC_H_
\ No newline at end of file
+#endif  // ALLOCATOR_DEFAULT_ALLOC_H_
@@ -0,0 +1,111 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "default_alloc.h"
+#include "malloc_alloc.h"
+
+constexpr int kObjsPerIteration = 1 << 16;
+constexpr int kRingSize = 1024;
+constexpr size_t kBytes = 48;
+
+// single-producer single-consumer ring, so that the allocator is the only
+// shared state between the two threads of a pair
+class Ring {
+ public:
+  void Push(void* p) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail - head_.load(std::memory_order_acquire) == kRingSize) {
+      std::this_thread::yield();
+    }
+    slots_[tail % kRingSize] = p;
+    tail_.store(tail + 1, std::memory_order_release);
+  }
+
+  void* Pop() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    while (tail_.load(std::memory_order_acquire) == head) {
+      std::this_thread::yield();
+    }
+    void* p = slots_[head % kRingSize];
+    head_.store(head + 1, std::memory_order_release);
+    return p;
+  }
+
+ private:
+  void* slots_[kRingSize];
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// Each pair of threads moves kObjsPerIteration objects per iteration: the
+// producer allocates them and the consumer frees them.
+template <typename Alloc>
+static void BM_ProducerConsumer(benchmark::State& state) {
+  int pairs = state.range(0);
+  for (auto _ : state) {
+    std::vector<Ring> rings(pairs);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < pairs; p++) {
+      threads.emplace_back([&ring = rings[p]] {
+        for (int i = 0; i < kObjsPerIteration; i++) {
+          ring.Push(Alloc::Allocate(kBytes));
+        }
+      });
+      threads.emplace_back([&ring = rings[p]] {
+        for (int i = 0; i < kObjsPerIteration; i++) {
+          Alloc::Deallocate(ring.Pop(), kBytes);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * pairs * kObjsPerIteration);
+}
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, sgi::DefaultAlloc)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, sgi::MallocAlloc)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+
+// Every thread allocates and frees its own objects.
+template <typename Alloc>
+static void BM_ThreadLocal(benchmark::State& state) {
+  int nthreads = state.range(0);
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nthreads; t++) {
+      threads.emplace_back([] {
+        void* ptrs[64];
+        for (int i = 0; i < kObjsPerIteration; i += 64) {
+          for (int j = 0; j < 64; j++) {
+            ptrs[j] = Alloc::Allocate(kBytes);
+          }
+          for (int j = 0; j < 64; j++) {
+            Alloc::Deallocate(ptrs[j], kBytes);
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * nthreads * kObjsPerIteration);
+}
+BENCHMARK_TEMPLATE(BM_ThreadLocal, sgi::DefaultAlloc)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ThreadLocal, sgi::MallocAlloc)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
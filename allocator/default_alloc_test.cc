@@ -1,9 +1,32 @@
 #include "default_alloc.h"
 
+#include <unistd.h>
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 using alloc = sgi::DefaultAlloc;
 
+// classes fitted to a workload allocating 24, 40 and 72 byte objects
+struct ObjectSizeClasses {
+  static constexpr size_t sizes[] = {
+      8,    16,   24,   32,   40,    48,    64,    72,    96,    128,
+      192,  256,  384,  512,  768,   1024,  1536,  2048,  3072,  4096,
+      6144, 8192, 12288, 16384, 24576, 32768};
+};
+using object_alloc = sgi::BasicDefaultAlloc<ObjectSizeClasses>;
+
 #define SIKP_PRIVATE_MEMBER_CASE 0
 
 #ifndef SIKP_PRIVATE_MEMBER_CASE
@@ -44,61 +67,146 @@ TEST(DefaultAlloc, FreeListsIndex) {
   EXPECT_EQ(alloc::FreeListsIndex(8), 0);
 }
 
-TEST(DefaultAlloc, AllocChunk) {
-  int nobjs = 1;
-  char* ptr1 = alloc::AllocChunk(8, nobjs);
-  EXPECT_NE(ptr1, nullptr);
-  EXPECT_EQ(nobjs, 1);
-  EXPECT_EQ(alloc::end_free_ - alloc::start_free_, 8);
+TEST(DefaultAlloc, SizeClasses) {
+  const auto& classes = alloc::size_classes_;
+  EXPECT_EQ(classes.sizes_[sgi::NFREELISTS - 1], sgi::MAX_SLAB_BYTES);
+  EXPECT_EQ(alloc::FreeListsIndex(129), 16);
+  EXPECT_EQ(classes.sizes_[16], 160);
+  EXPECT_EQ(classes.sizes_[alloc::FreeListsIndex(1025)], 1280);
+  EXPECT_EQ(classes.sizes_[alloc::FreeListsIndex(32768)], 32768);
 
-  EXPECT_EQ(alloc::extend_heap_size_, 16);
+  for (size_t bytes = 1; bytes <= sgi::MAX_SLAB_BYTES; bytes++) {
+    size_t size = classes.sizes_[alloc::FreeListsIndex(bytes)];
+    ASSERT_GE(size, bytes);
+    if (bytes > sgi::MAX_BYTES) {
+      // bounded internal fragmentation
+      ASSERT_LT(size - bytes, size / (sgi::SLAB_STEPS + 1));
+    }
+  }
 
-  nobjs = 2;
-  char* ptr2 = alloc::AllocChunk(8, nobjs);
-  EXPECT_NE(ptr2, nullptr);
-  EXPECT_EQ(nobjs, 1);
-  EXPECT_EQ(alloc::end_free_ - alloc::start_free_, 0);
+  EXPECT_EQ(classes.aligns_[0], 8);
+  EXPECT_EQ(classes.aligns_[alloc::FreeListsIndex(48)], 16);
+  EXPECT_EQ(classes.aligns_[alloc::FreeListsIndex(64)], 64);
+  EXPECT_EQ(classes.aligns_[alloc::FreeListsIndex(160)], 32);
+  EXPECT_EQ(classes.aligns_[sgi::NFREELISTS - 1], sgi::CACHE_LINE_BYTES);
 
-  nobjs = 2;
-  char* ptr3 = alloc::AllocChunk(16, nobjs);
-  EXPECT_NE(ptr3, nullptr);
-  EXPECT_EQ(nobjs, 2);
-  EXPECT_EQ(alloc::end_free_ - alloc::start_free_, 40);
-  EXPECT_EQ(alloc::extend_heap_size_, 88);
+  EXPECT_EQ(classes.batches_[0], sgi::MAX_BATCH_OBJECTS);
+  EXPECT_EQ(classes.batches_[sgi::NFREELISTS - 1], 2);
+}
 
-  nobjs = 2;
-  char* ptr4 = alloc::AllocChunk(24, nobjs);
-  EXPECT_NE(ptr4, nullptr);
-  EXPECT_EQ(nobjs, 1);
-  EXPECT_EQ(alloc::end_free_ - alloc::start_free_, 16);
-  EXPECT_EQ(alloc::extend_heap_size_, 88);
+TEST(DefaultAlloc, CustomSizeClassesLookup) {
+  const auto& classes = object_alloc::size_classes_;
+  EXPECT_EQ(object_alloc::NUM_CLASSES, 26);
+
+  // every request maps to the smallest class that holds it
+  for (size_t bytes = 1; bytes <= sgi::MAX_SLAB_BYTES; bytes++) {
+    size_t index = object_alloc::FreeListsIndex(bytes);
+    ASSERT_GE(classes.sizes_[index], bytes);
+    ASSERT_TRUE(index == 0 || classes.sizes_[index - 1] < bytes);
+  }
+  EXPECT_EQ(classes.sizes_[object_alloc::FreeListsIndex(17)], 24);
+  EXPECT_EQ(classes.sizes_[object_alloc::FreeListsIndex(65)], 72);
+  EXPECT_EQ(classes.aligns_[object_alloc::FreeListsIndex(72)], 8);
+}
+
+TEST(DefaultAlloc, AllocChunk) {
+  // Run on a fresh thread so that the thread cache starts out empty
+  std::thread([] {
+    alloc::ThreadCache* cache = alloc::GetThreadCache();
+    size_t payload = sgi::SPAN_BYTES - sgi::SPAN_HEADER_BYTES;
+    int nobjs = 1;
+    char* ptr1 = alloc::AllocChunk(cache, 8, nobjs);
+    EXPECT_NE(ptr1, nullptr);
+    EXPECT_EQ(nobjs, 1);
+    EXPECT_EQ(alloc::SpanOf(ptr1)->owner_, cache);
+    EXPECT_EQ(ptr1 - reinterpret_cast<char*>(alloc::SpanOf(ptr1)),
+              sgi::SPAN_HEADER_BYTES);
+    EXPECT_EQ(cache->end_free_ - cache->start_free_, payload - 8);
+    EXPECT_EQ(alloc::extend_heap_size_, sgi::SPAN_BYTES);
+
+    // 16 byte objects are aligned to 16 bytes, the gap is freed
+    nobjs = 2;
+    char* ptr2 = alloc::AllocChunk(cache, 16, nobjs);
+    EXPECT_EQ(ptr2, ptr1 + 16);
+    EXPECT_EQ(nobjs, 2);
+    EXPECT_EQ(cache->end_free_ - cache->start_free_, payload - 48);
+    EXPECT_EQ(cache->free_lists_[0], reinterpret_cast<void*>(ptr1 + 8));
 
-  nobjs = 2;
-  char* ptr5 = alloc::AllocChunk(24, nobjs);
-  EXPECT_NE(ptr5, nullptr);
-  EXPECT_EQ(nobjs, 2);
-  EXPECT_EQ(alloc::end_free_ - alloc::start_free_, 56);
+    // leave 40 bytes in the span
+    cache->start_free_ = cache->end_free_ - 40;
+    nobjs = 2;
+    char* ptr3 = alloc::AllocChunk(cache, 24, nobjs);
+    EXPECT_NE(ptr3, nullptr);
+    EXPECT_EQ(nobjs, 1);
+    EXPECT_EQ(cache->end_free_ - cache->start_free_, 16);
+    EXPECT_EQ(alloc::extend_heap_size_, sgi::SPAN_BYTES);
 
-  int index = alloc::FreeListsIndex(16);
-  EXPECT_NE(alloc::free_lists_[index], nullptr);
-  EXPECT_EQ(alloc::free_lists_[index]->next_free_obj, nullptr);
+    // the remaining 16 bytes go to the free list and a new span is used
+    nobjs = 2;
+    char* ptr4 = alloc::AllocChunk(cache, 24, nobjs);
+    EXPECT_NE(alloc::SpanOf(ptr4), alloc::SpanOf(ptr1));
+    EXPECT_EQ(nobjs, 2);
+    EXPECT_EQ(cache->end_free_ - cache->start_free_, payload - 48);
+    EXPECT_EQ(alloc::extend_heap_size_, 2 * sgi::SPAN_BYTES);
 
-  size_t bytes = 100000000000;
-  nobjs = 2;
-  EXPECT_THROW(alloc::AllocChunk(bytes, nobjs), std::bad_alloc);
+    int index = alloc::FreeListsIndex(16);
+    EXPECT_NE(cache->free_lists_[index], nullptr);
+    EXPECT_EQ(cache->free_lists_[index]->next_free_obj, nullptr);
+    EXPECT_EQ(cache->lengths_[index], 1);
+  }).join();
 }
 
 TEST(DefaultAlloc, Refill) {
-  int bytes = 16;
-  char* ptr1 = alloc::Refill(bytes);
-  EXPECT_NE(ptr1, nullptr);
-  int index = alloc::FreeListsIndex(bytes);
-  EXPECT_NE(alloc::free_lists_[index], nullptr);
-  EXPECT_EQ(Count(alloc::free_lists_[index]), sgi::DEFAULT_CHUNKS - 1);
+  std::thread([] {
+    // a size class that no other case has touched, so that the central
+    // pool has nothing to hand back
+    alloc::ThreadCache* cache = alloc::GetThreadCache();
+    int bytes = 40;
+    char* ptr1 = alloc::Refill(cache, bytes);
+    EXPECT_NE(ptr1, nullptr);
+    int index = alloc::FreeListsIndex(bytes);
+    EXPECT_NE(cache->free_lists_[index], nullptr);
+    EXPECT_EQ(Count(cache->free_lists_[index]), sgi::MIN_BATCH - 1);
+    EXPECT_EQ(cache->lengths_[index], sgi::MIN_BATCH - 1);
 
-  char* ptr2 = alloc::Refill(2 * bytes);
-  EXPECT_NE(ptr2, nullptr);
-  EXPECT_EQ(Count(alloc::free_lists_[index]), sgi::DEFAULT_CHUNKS - 1);
+    char* ptr2 = alloc::Refill(cache, 2 * bytes);
+    EXPECT_NE(ptr2, nullptr);
+    EXPECT_EQ(Count(cache->free_lists_[index]), sgi::MIN_BATCH - 1);
+
+    // every refill doubles the batch
+    cache->free_lists_[index] = nullptr;
+    cache->lengths_[index] = 0;
+    alloc::Refill(cache, bytes);
+    EXPECT_EQ(cache->lengths_[index], 2 * sgi::MIN_BATCH - 1);
+    cache->free_lists_[index] = nullptr;
+    cache->lengths_[index] = 0;
+    alloc::Refill(cache, bytes);
+    EXPECT_EQ(cache->lengths_[index], 4 * sgi::MIN_BATCH - 1);
+  }).join();
+}
+
+TEST(DefaultAlloc, Scavenge) {
+  std::thread([] {
+    alloc::ThreadCache* cache = alloc::GetThreadCache();
+    int bytes = 48;
+    int index = alloc::FreeListsIndex(bytes);
+    std::vector<void*> ptrs(1000);
+    for (auto& ptr : ptrs) {
+      ptr = alloc::Allocate(bytes);
+    }
+    int batch = cache->batches_[index];
+    EXPECT_EQ(batch, sgi::MAX_BATCH_OBJECTS);
+    for (auto& ptr : ptrs) {
+      alloc::Deallocate(ptr, bytes);
+    }
+    EXPECT_GT(cache->lengths_[index], batch);
+
+    // an idle size class shrinks once other classes keep refilling
+    alloc::Scavenge(cache);
+    alloc::Scavenge(cache);
+    EXPECT_EQ(cache->batches_[index], batch / 2);
+    EXPECT_EQ(cache->lengths_[index], batch / 2);
+  }).join();
 }
 
 #endif
@@ -144,6 +252,348 @@ TEST(DefaultAlloc, Reallocate) {
   alloc::Deallocate(ptr4_new, 30);
 }
 
+TEST(DefaultAlloc, SlabTier) {
+  std::vector<std::pair<char*, size_t>> blocks;
+  for (size_t bytes = 100; bytes <= sgi::MAX_SLAB_BYTES + 1000; bytes += 97) {
+    char* ptr = static_cast<char*>(alloc::Allocate(bytes));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % sgi::ALIGN, 0);
+    memset(ptr, static_cast<char>(bytes), bytes);
+    blocks.emplace_back(ptr, bytes);
+  }
+
+  for (auto& block : blocks) {
+    for (size_t i = 0; i < block.second; i++) {
+      ASSERT_EQ(block.first[i], static_cast<char>(block.second));
+    }
+    alloc::Deallocate(block.first, block.second);
+  }
+
+  // freed slab objects are handed out again
+  void* ptr1 = alloc::Allocate(3000);
+  alloc::Deallocate(ptr1, 3000);
+  void* ptr2 = alloc::Allocate(2900);
+  EXPECT_EQ(ptr1, ptr2);
+  alloc::Deallocate(ptr2, 2900);
+}
+
+TEST(DefaultAlloc, Aligned) {
+  std::vector<std::pair<char*, size_t>> blocks;
+  for (size_t align = 16; align <= 4096; align *= 2) {
+    for (size_t bytes = 1; bytes <= sgi::MAX_SLAB_BYTES + 1000; bytes += 61) {
+      char* ptr = static_cast<char*>(alloc::Allocate(bytes, align));
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % align, 0);
+      memset(ptr, static_cast<char>(bytes), bytes);
+      blocks.emplace_back(ptr, bytes);
+    }
+    for (auto& block : blocks) {
+      ASSERT_EQ(block.first[block.second - 1], static_cast<char>(block.second));
+      alloc::Deallocate(block.first, block.second, align);
+    }
+    blocks.clear();
+  }
+
+  // objects are aligned to their size class
+  for (int i = 0; i < 1000; i++) {
+    void* ptr = alloc::Allocate(64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0);
+    blocks.emplace_back(static_cast<char*>(alloc::Allocate(24)), 24);
+    blocks.emplace_back(static_cast<char*>(ptr), 64);
+  }
+  for (auto& block : blocks) {
+    alloc::Deallocate(block.first, block.second);
+  }
+}
+
+TEST(DefaultAlloc, CustomSizeClasses) {
+  static_assert(!sgi::ValidSizeClasses(std::array<size_t, 2>{16, 32768}));
+  static_assert(!sgi::ValidSizeClasses(std::array<size_t, 3>{8, 1100, 32768}));
+  static_assert(sgi::ValidSizeClasses(ObjectSizeClasses::sizes));
+
+  std::thread([] {
+    std::vector<void*> objs;
+    for (int i = 0; i < 100; i++) {
+      objs.push_back(object_alloc::Allocate(40));
+    }
+    std::set<uintptr_t> addrs;
+    for (void* p : objs) {
+      addrs.insert(reinterpret_cast<uintptr_t>(p));
+      memset(p, 0xab, 40);
+    }
+    // a single refill carves consecutive 40 byte objects
+    EXPECT_EQ(addrs.size(), objs.size());
+    EXPECT_EQ(*std::next(addrs.begin()) - *addrs.begin(), 40);
+
+    // 33 to 40 bytes share the 40 byte class, sized by the config
+    object_alloc::Stats stats = object_alloc::GetStats();
+    EXPECT_EQ(std::size(stats.size_classes), 26u);
+    EXPECT_EQ(stats.size_classes[4].size, 40);
+#ifndef SGI_NO_ALLOC_STATS
+    EXPECT_EQ(stats.size_classes[4].allocations, objs.size());
+#endif  // SGI_NO_ALLOC_STATS
+    for (void* p : objs) {
+      object_alloc::Deallocate(p, 33);
+    }
+
+    // a separate pool from DefaultAlloc's
+    EXPECT_EQ(std::size(alloc::GetStats().size_classes), sgi::NFREELISTS);
+  }).join();
+}
+
+TEST(DefaultAlloc, RefillBatch) {
+  constexpr size_t kBytes = 56;
+  constexpr int kCount = 100000;
+  auto refills = [] {
+    for (const auto& size_class : alloc::GetStats().size_classes) {
+      if (size_class.size == kBytes) {
+        return size_class.refills;
+      }
+    }
+    return uint64_t{0};
+  };
+
+  std::thread([&] {
+    uint64_t refills_before = refills();
+    std::vector<void*> ptrs(kCount);
+    for (auto& ptr : ptrs) {
+      ptr = alloc::Allocate(kBytes);
+    }
+    // the batch of a hot size class grows to MAX_BATCH_OBJECTS
+    EXPECT_LT(refills() - refills_before,
+              2 * kCount / sgi::MAX_BATCH_OBJECTS);
+    for (auto& ptr : ptrs) {
+      alloc::Deallocate(ptr, kBytes);
+    }
+  }).join();
+}
+
+TEST(DefaultAlloc, AllocateBatch) {
+  constexpr size_t kBytes = 40;
+  constexpr size_t kCount = 10000;
+  auto refills = [] {
+    for (const auto& size_class : alloc::GetStats().size_classes) {
+      if (size_class.size == kBytes) {
+        return size_class.refills;
+      }
+    }
+    return uint64_t{0};
+  };
+
+  std::thread([&] {
+    uint64_t refills_before = refills();
+    std::vector<void*> ptrs(kCount);
+    alloc::AllocateBatch(kBytes, kCount, ptrs.data());
+    // runs are carved a span at a time
+    EXPECT_LE(refills() - refills_before,
+              kCount * kBytes / (sgi::SPAN_BYTES - sgi::SPAN_HEADER_BYTES) + 2);
+
+    std::set<void*> distinct(ptrs.begin(), ptrs.end());
+    EXPECT_EQ(distinct.size(), kCount);
+    for (size_t i = 0; i < kCount; i++) {
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(ptrs[i]) % 8, 0);
+      memset(ptrs[i], static_cast<int>(i), kBytes);
+    }
+    alloc::DeallocateBatch(ptrs.data(), kCount, kBytes);
+
+    // the freed objects come back first
+    std::vector<void*> again(100);
+    alloc::AllocateBatch(kBytes, again.size(), again.data());
+    for (void* ptr : again) {
+      EXPECT_EQ(distinct.count(ptr), 1);
+    }
+    alloc::DeallocateBatch(again.data(), again.size(), kBytes);
+
+    // large objects go through MallocAlloc
+    void* large[2];
+    alloc::AllocateBatch(64 * 1024, 2, large);
+    memset(large[0], 0, 64 * 1024);
+    memset(large[1], 0, 64 * 1024);
+    alloc::DeallocateBatch(large, 2, 64 * 1024);
+  }).join();
+}
+
+TEST(DefaultAlloc, DeallocateBatchCrossThread) {
+  constexpr size_t kBytes = 24;
+  constexpr size_t kCount = 1000;
+  std::vector<void*> ptrs(kCount);
+  alloc::AllocateBatch(kBytes, kCount, ptrs.data());
+  std::thread(
+      [&] { alloc::DeallocateBatch(ptrs.data(), kCount, kBytes); })
+      .join();
+
+  // the owner gets its objects back through its remote list
+  std::vector<void*> again(kCount);
+  alloc::AllocateBatch(kBytes, kCount, again.data());
+  std::set<void*> distinct(again.begin(), again.end());
+  EXPECT_EQ(distinct.size(), kCount);
+  alloc::DeallocateBatch(again.data(), kCount, kBytes);
+}
+
+TEST(DefaultAlloc, MultiThread) {
+  constexpr int kThreads = 4;
+  constexpr int kRounds = 100;
+  constexpr int kObjs = 1000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([t] {
+      std::vector<char*> ptrs(kObjs);
+      for (int round = 0; round < kRounds; round++) {
+        for (int i = 0; i < kObjs; i++) {
+          size_t bytes = (i + t) % sgi::MAX_BYTES + 1;
+          ptrs[i] = static_cast<char*>(alloc::Allocate(bytes));
+          memset(ptrs[i], t, bytes);
+        }
+        for (int i = 0; i < kObjs; i++) {
+          size_t bytes = (i + t) % sgi::MAX_BYTES + 1;
+          for (size_t j = 0; j < bytes; j++) {
+            ASSERT_EQ(ptrs[i][j], t);
+          }
+          alloc::Deallocate(ptrs[i], bytes);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(DefaultAlloc, CrossThreadDeallocate) {
+  constexpr int kObjs = 10000;
+  constexpr size_t kBytes = 24;
+
+  // objects released by one thread flow back to another through the
+  // central pool
+  std::vector<void*> ptrs(kObjs);
+  std::thread([&] {
+    for (int i = 0; i < kObjs; i++) {
+      ptrs[i] = alloc::Allocate(kBytes);
+    }
+  }).join();
+
+  std::thread([&] {
+    for (int i = 0; i < kObjs; i++) {
+      alloc::Deallocate(ptrs[i], kBytes);
+    }
+  }).join();
+
+  for (int i = 0; i < kObjs; i++) {
+    ptrs[i] = alloc::Allocate(kBytes);
+    EXPECT_NE(ptrs[i], nullptr);
+  }
+  for (int i = 0; i < kObjs; i++) {
+    alloc::Deallocate(ptrs[i], kBytes);
+  }
+}
+
+TEST(DefaultAlloc, ProducerConsumer) {
+  constexpr int kPairs = 4;
+  constexpr int kBatches = 200;
+  constexpr int kBatchSize = 500;
+
+  struct Channel {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::vector<char*>> batches;
+  };
+
+  // every object is allocated by a producer and freed by its consumer, so
+  // all of them go back through the remote free path
+  auto produce = [](Channel* channel, int seed) {
+    for (int b = 0; b < kBatches; b++) {
+      std::vector<char*> batch(kBatchSize);
+      for (int i = 0; i < kBatchSize; i++) {
+        size_t bytes = (seed + b + i) % sgi::MAX_BYTES + 1;
+        batch[i] = static_cast<char*>(alloc::Allocate(bytes));
+        memset(batch[i], static_cast<char>(bytes), bytes);
+      }
+      std::lock_guard<std::mutex> lock(channel->mutex);
+      channel->batches.push_back(std::move(batch));
+      channel->cv.notify_one();
+    }
+  };
+
+  auto consume = [](Channel* channel, int seed) {
+    for (int b = 0; b < kBatches; b++) {
+      std::vector<char*> batch;
+      {
+        std::unique_lock<std::mutex> lock(channel->mutex);
+        channel->cv.wait(lock, [&] { return !channel->batches.empty(); });
+        batch = std::move(channel->batches.front());
+        channel->batches.pop_front();
+      }
+      for (int i = 0; i < kBatchSize; i++) {
+        size_t bytes = (seed + b + i) % sgi::MAX_BYTES + 1;
+        for (size_t j = 0; j < bytes; j++) {
+          ASSERT_EQ(batch[i][j], static_cast<char>(bytes));
+        }
+        alloc::Deallocate(batch[i], bytes);
+      }
+    }
+  };
+
+  std::vector<Channel> channels(kPairs);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kPairs; p++) {
+    threads.emplace_back(produce, &channels[p], p);
+    threads.emplace_back(consume, &channels[p], p);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+size_t ResidentBytes() {
+  size_t pages = 0, resident = 0;
+  FILE* file = fopen("/proc/self/statm", "r");
+  EXPECT_EQ(fscanf(file, "%zu %zu", &pages, &resident), 2);
+  fclose(file);
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+void AllocateAndFree(size_t total_bytes, size_t bytes) {
+  std::vector<void*> ptrs(total_bytes / bytes);
+  for (auto& ptr : ptrs) {
+    ptr = alloc::Allocate(bytes);
+    memset(ptr, 1, bytes);
+  }
+  for (auto& ptr : ptrs) {
+    alloc::Deallocate(ptr, bytes);
+  }
+}
+
+TEST(DefaultAlloc, Trim) {
+  constexpr size_t kTotalBytes = 8 << 20;
+  std::thread([] {
+    AllocateAndFree(kTotalBytes, 64);
+    EXPECT_GE(alloc::Trim(), kTotalBytes / 2);
+    EXPECT_EQ(alloc::Trim(), 0);
+
+    // trimmed spans are reused
+    AllocateAndFree(kTotalBytes, 64);
+  }).join();
+}
+
+TEST(DefaultAlloc, ReleaseFreeMemory) {
+  constexpr size_t kTotalBytes = 64 << 20;
+
+  // the spans of an exited thread are released too
+  std::thread(AllocateAndFree, kTotalBytes, 1024).join();
+  size_t resident = ResidentBytes();
+  EXPECT_GE(alloc::ReleaseFreeMemory(), kTotalBytes / 2);
+  EXPECT_LT(ResidentBytes() + kTotalBytes / 2, resident);
+  EXPECT_EQ(alloc::ReleaseFreeMemory(), 0);
+}
+
+TEST(DefaultAlloc, ReleaseThreshold) {
+  constexpr size_t kTotalBytes = 64 << 20;
+  alloc::SetReleaseThreshold(1 << 20);
+  size_t resident = ResidentBytes();
+  std::thread(AllocateAndFree, kTotalBytes, 512).join();
+  EXPECT_LT(ResidentBytes(), resident + kTotalBytes / 4);
+  alloc::SetReleaseThreshold(0);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,344 @@
+#ifndef ALLOCATOR_HEAP_PROFILER_H_
+#define ALLOCATOR_HEAP_PROFILER_H_
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "malloc_alloc.h"
+
+namespace sgi {
+using size_t = std::size_t;
+
+inline constexpr int MAX_STACK_DEPTH = 32;
+inline constexpr size_t DEFAULT_SAMPLE_INTERVAL = 512 * 1024;
+
+// Live-heap profile of sampled allocations. An allocator samples one
+// allocation every sample_interval() bytes on average: each thread counts
+// down a distance drawn by NextSampleDistance, so that the gaps between
+// samples are geometrically distributed and every byte is equally likely to
+// be sampled. A sampled allocation is recorded with its stack trace by
+// RecordAllocation and dropped by RecordDeallocation once freed.
+//
+// DefaultAlloc samples all its allocations once enabled with
+// DefaultAlloc::SetProfileSampleInterval. Its fast paths then only pay for a
+// subtraction on allocation and a load from the span header on deallocation.
+//
+// The samples are written either in the legacy heap profile format of
+// gperftools, which pprof reads together with the binary:
+//
+//   pprof --text ./app heap.prof
+//
+// or as collapsed stacks for flamegraph.pl, weighted with the estimated live
+// bytes each sample stands for.
+class HeapProfiler {
+ public:
+  // 0 means sampling is off
+  static size_t sample_interval() {
+    return interval_.load(std::memory_order_relaxed);
+  }
+
+  static void SetSampleInterval(size_t bytes) {
+    interval_.store(bytes, std::memory_order_relaxed);
+  }
+
+  // Bytes to allocate before the next sample, for a thread whose random
+  // state is rng.
+  static int64_t NextSampleDistance(uint64_t& rng);
+
+  // Both return false when called from within the profiler, whose own
+  // allocations are never sampled. RecordDeallocation also returns false if
+  // p is not sampled.
+  static bool RecordAllocation(void* p, size_t bytes);
+  static bool RecordDeallocation(void* p);
+
+  // number of sampled allocations not freed yet
+  static size_t live_samples() {
+    return live_samples_.load(std::memory_order_relaxed);
+  }
+
+  static void WritePprofProfile(std::FILE* out);
+  static void WriteCollapsedProfile(std::FILE* out);
+
+ private:
+  struct Sample {
+    Sample* next_;
+    void* ptr_;
+    size_t bytes_;
+    size_t interval_;  // in effect when sampled
+    int depth_;
+    void* stack_[MAX_STACK_DEPTH];
+  };
+
+  // frames of RecordAllocation and of the allocator's sampling function
+  static constexpr int SKIPPED_FRAMES = 2;
+
+  // The probability for an allocation of bytes to be sampled is
+  // 1 - exp(-bytes / interval), each sample stands for its inverse.
+  static double Weight(const Sample& sample) {
+    return 1 / (1 - std::exp(-static_cast<double>(sample.bytes_) /
+                             sample.interval_));
+  }
+
+  static size_t Bucket(void* p) {
+    return (reinterpret_cast<uintptr_t>(p) >> 4) * 0x9E3779B97F4A7C15 >>
+           (64 - bucket_bits_);
+  }
+
+  static bool SameStack(const Sample* lhs, const Sample* rhs) {
+    return lhs->depth_ == rhs->depth_ &&
+           memcmp(lhs->stack_, rhs->stack_, lhs->depth_ * sizeof(void*)) == 0;
+  }
+
+  // the following require mutex_ to be held
+  static void Grow();
+  static Sample** SortedSamples();  // by stack, freed with FreeSorted
+  static void FreeSorted(Sample** samples);
+
+  static inline std::atomic<size_t> interval_{0};
+  static inline std::atomic<size_t> live_samples_{0};
+  static inline thread_local bool busy_ = false;
+
+  static inline std::mutex mutex_;
+  static inline Sample** buckets_ = nullptr;
+  static inline int bucket_bits_ = 0;
+  static inline Sample* free_samples_ = nullptr;
+};
+
+inline int64_t HeapProfiler::NextSampleDistance(uint64_t& rng) {
+  size_t interval = sample_interval();
+  if (interval == 0) {
+    return INT64_MAX;
+  }
+
+  // xorshift64*, then a uniform double in (0, 1]
+  rng ^= rng >> 12;
+  rng ^= rng << 25;
+  rng ^= rng >> 27;
+  double u = ((rng * 0x2545F4914F6CDD1D >> 11) + 1) * 0x1.0p-53;
+  return static_cast<int64_t>(-std::log(u) * interval) + 1;
+}
+
+inline bool HeapProfiler::RecordAllocation(void* p, size_t bytes) {
+  if (busy_) {
+    return false;
+  }
+  busy_ = true;
+
+  // unwind before taking the lock, backtrace may allocate the first time
+  void* stack[MAX_STACK_DEPTH + SKIPPED_FRAMES];
+  int depth = backtrace(stack, MAX_STACK_DEPTH + SKIPPED_FRAMES);
+  depth = depth > SKIPPED_FRAMES ? depth - SKIPPED_FRAMES : 0;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buckets_ == nullptr || live_samples() >= (size_t{1} << bucket_bits_)) {
+      Grow();
+    }
+    Sample* sample = free_samples_;
+    if (sample != nullptr) {
+      free_samples_ = sample->next_;
+    } else {
+      sample = static_cast<Sample*>(MallocAlloc::Allocate(sizeof(Sample)));
+    }
+    sample->ptr_ = p;
+    sample->bytes_ = bytes;
+    sample->interval_ = sample_interval();
+    if (sample->interval_ == 0) {
+      sample->interval_ = DEFAULT_SAMPLE_INTERVAL;
+    }
+    sample->depth_ = depth;
+    memcpy(sample->stack_, stack + SKIPPED_FRAMES, depth * sizeof(void*));
+
+    size_t bucket = Bucket(p);
+    sample->next_ = buckets_[bucket];
+    buckets_[bucket] = sample;
+    live_samples_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  busy_ = false;
+  return true;
+}
+
+inline bool HeapProfiler::RecordDeallocation(void* p) {
+  if (busy_) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (buckets_ == nullptr) {
+    return false;
+  }
+  for (Sample** link = &buckets_[Bucket(p)]; *link != nullptr;
+       link = &(*link)->next_) {
+    if ((*link)->ptr_ == p) {
+      Sample* sample = *link;
+      *link = sample->next_;
+      sample->next_ = free_samples_;
+      free_samples_ = sample;
+      live_samples_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Doubles the number of buckets, starting at 1024.
+inline void HeapProfiler::Grow() {
+  int old_bits = bucket_bits_;
+  Sample** old_buckets = buckets_;
+  bucket_bits_ = old_bits == 0 ? 10 : old_bits + 1;
+  size_t num_buckets = size_t{1} << bucket_bits_;
+  buckets_ = static_cast<Sample**>(
+      MallocAlloc::Allocate(num_buckets * sizeof(Sample*)));
+  memset(buckets_, 0, num_buckets * sizeof(Sample*));
+  if (old_buckets == nullptr) {
+    return;
+  }
+
+  size_t old_num_buckets = size_t{1} << old_bits;
+  for (size_t i = 0; i < old_num_buckets; i++) {
+    Sample* sample = old_buckets[i];
+    while (sample != nullptr) {
+      Sample* next = sample->next_;
+      size_t bucket = Bucket(sample->ptr_);
+      sample->next_ = buckets_[bucket];
+      buckets_[bucket] = sample;
+      sample = next;
+    }
+  }
+  MallocAlloc::Deallocate(old_buckets, old_num_buckets * sizeof(Sample*));
+}
+
+inline HeapProfiler::Sample** HeapProfiler::SortedSamples() {
+  size_t count = live_samples();
+  Sample** samples = static_cast<Sample**>(
+      MallocAlloc::Allocate((count + 1) * sizeof(Sample*)));
+  size_t n = 0;
+  for (size_t i = 0; buckets_ != nullptr && i < (size_t{1} << bucket_bits_);
+       i++) {
+    for (Sample* sample = buckets_[i]; sample != nullptr;
+         sample = sample->next_) {
+      samples[n++] = sample;
+    }
+  }
+  samples[n] = nullptr;
+  std::sort(samples, samples + n, [](const Sample* lhs, const Sample* rhs) {
+    if (lhs->depth_ != rhs->depth_) {
+      return lhs->depth_ < rhs->depth_;
+    }
+    return memcmp(lhs->stack_, rhs->stack_, lhs->depth_ * sizeof(void*)) < 0;
+  });
+  return samples;
+}
+
+inline void HeapProfiler::FreeSorted(Sample** samples) {
+  size_t n = 0;
+  while (samples[n] != nullptr) {
+    n++;
+  }
+  MallocAlloc::Deallocate(samples, (n + 1) * sizeof(Sample*));
+}
+
+// One line per stack with the sampled objects and bytes, which pprof scales
+// up with the sampling interval of the header.
+inline void HeapProfiler::WritePprofProfile(std::FILE* out) {
+  busy_ = true;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Sample** samples = SortedSamples();
+    uint64_t total_objects = 0;
+    uint64_t total_bytes = 0;
+    for (Sample** sample = samples; *sample != nullptr; sample++) {
+      total_objects++;
+      total_bytes += (*sample)->bytes_;
+    }
+    size_t interval = sample_interval();
+    fprintf(out,
+            "heap profile: %6" PRIu64 ": %8" PRIu64 " [%6" PRIu64
+            ": %8" PRIu64 "] @ heap_v2/%zu\n",
+            total_objects, total_bytes, total_objects, total_bytes,
+            interval != 0 ? interval : DEFAULT_SAMPLE_INTERVAL);
+
+    for (Sample** first = samples; *first != nullptr;) {
+      Sample** last = first;
+      uint64_t objects = 0;
+      uint64_t bytes = 0;
+      for (; *last != nullptr && SameStack(*first, *last); last++) {
+        objects++;
+        bytes += (*last)->bytes_;
+      }
+      fprintf(out, "%6" PRIu64 ": %8" PRIu64 " [%6" PRIu64 ": %8" PRIu64 "] @",
+              objects, bytes, objects, bytes);
+      for (int i = 0; i < (*first)->depth_; i++) {
+        fprintf(out, " %p", (*first)->stack_[i]);
+      }
+      fprintf(out, "\n");
+      first = last;
+    }
+    FreeSorted(samples);
+  }
+
+  // lets pprof map the addresses to the binary and its libraries
+  fprintf(out, "\nMAPPED_LIBRARIES:\n");
+  std::FILE* maps = fopen("/proc/self/maps", "r");
+  if (maps != nullptr) {
+    char buf[4096];
+    size_t n = 0;
+    while ((n = fread(buf, 1, sizeof(buf), maps)) > 0) {
+      fwrite(buf, 1, n, out);
+    }
+    fclose(maps);
+  }
+  busy_ = false;
+}
+
+// One line per stack, "root;...;leaf bytes", with the function names of the
+// frames, or their addresses when the names are not exported.
+inline void HeapProfiler::WriteCollapsedProfile(std::FILE* out) {
+  busy_ = true;
+  std::lock_guard<std::mutex> lock(mutex_);
+  Sample** samples = SortedSamples();
+  for (Sample** first = samples; *first != nullptr;) {
+    Sample** last = first;
+    double bytes = 0;
+    for (; *last != nullptr && SameStack(*first, *last); last++) {
+      bytes += (*last)->bytes_ * Weight(**last);
+    }
+
+    for (int i = (*first)->depth_ - 1; i >= 0; i--) {
+      Dl_info info;
+      void* addr = (*first)->stack_[i];
+      if (dladdr(addr, &info) != 0 && info.dli_sname != nullptr) {
+        int status = 0;
+        char* name =
+            abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        fprintf(out, "%s", status == 0 ? name : info.dli_sname);
+        free(name);
+      } else {
+        fprintf(out, "%p", addr);
+      }
+      if (i != 0) {
+        fputc(';', out);
+      }
+    }
+    fprintf(out, " %.0f\n", bytes);
+    first = last;
+  }
+  FreeSorted(samples);
+  busy_ = false;
+}
+
+}  // namespace sgi
+
+#endif  // ALLOCATOR_HEAP_PROFILER_H_
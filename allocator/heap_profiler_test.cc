@@ -0,0 +1,120 @@
+#include "heap_profiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "default_alloc.h"
+#include "gtest/gtest.h"
+
+using alloc = sgi::DefaultAlloc;
+
+std::string WriteProfile(void (*write)(std::FILE*)) {
+  static char buf[1 << 20];
+  memset(buf, 0, sizeof(buf));
+  std::FILE* out = fmemopen(buf, sizeof(buf) - 1, "w");
+  write(out);
+  fclose(out);
+  return buf;
+}
+
+// exported, so that the collapsed profile can name it
+__attribute__((noinline)) std::vector<void*> AllocateObjects(int count,
+                                                              size_t bytes) {
+  std::vector<void*> ptrs(count);
+  for (auto& ptr : ptrs) {
+    ptr = alloc::Allocate(bytes);
+  }
+  return ptrs;
+}
+
+TEST(HeapProfiler, NextSampleDistance) {
+  sgi::HeapProfiler::SetSampleInterval(0);
+  uint64_t rng = 12345;
+  EXPECT_EQ(sgi::HeapProfiler::NextSampleDistance(rng), INT64_MAX);
+
+  sgi::HeapProfiler::SetSampleInterval(1000);
+  constexpr int kCount = 100000;
+  double sum = 0;
+  for (int i = 0; i < kCount; i++) {
+    int64_t distance = sgi::HeapProfiler::NextSampleDistance(rng);
+    EXPECT_GT(distance, 0);
+    sum += distance;
+  }
+  // geometric with a mean of the interval
+  EXPECT_NEAR(sum / kCount, 1000, 20);
+  sgi::HeapProfiler::SetSampleInterval(0);
+}
+
+TEST(HeapProfiler, Off) {
+  auto ptrs = AllocateObjects(10000, 64);
+  EXPECT_EQ(sgi::HeapProfiler::live_samples(), 0);
+  for (void* ptr : ptrs) {
+    alloc::Deallocate(ptr, 64);
+  }
+}
+
+TEST(HeapProfiler, LiveHeap) {
+  constexpr int kCount = 10000;
+  constexpr size_t kBytes = 100;
+  alloc::SetProfileSampleInterval(4096);
+  std::thread([&] {
+    auto ptrs = AllocateObjects(kCount, kBytes);
+    void* large = alloc::Allocate(1 << 20);
+
+    // about kCount * kBytes / 4096 small samples, and the large block
+    size_t samples = sgi::HeapProfiler::live_samples();
+    EXPECT_GT(samples, 150);
+    EXPECT_LT(samples, 400);
+
+    std::string collapsed =
+        WriteProfile(sgi::HeapProfiler::WriteCollapsedProfile);
+    EXPECT_NE(collapsed.find("AllocateObjects"), std::string::npos);
+    // the weights add up to about the live bytes
+    double bytes = 0;
+    for (size_t pos = 0; (pos = collapsed.find(' ', pos)) != std::string::npos;
+         pos++) {
+      size_t end = collapsed.find('\n', pos);
+      if (end != std::string::npos &&
+          collapsed.find(' ', pos + 1) > end) {
+        bytes += std::stod(collapsed.substr(pos + 1, end - pos - 1));
+      }
+    }
+    EXPECT_GT(bytes, 0.7 * (kCount * kBytes + (1 << 20)));
+    EXPECT_LT(bytes, 1.3 * (kCount * kBytes + (1 << 20)));
+
+    std::string pprof = WriteProfile(sgi::HeapProfiler::WritePprofProfile);
+    EXPECT_EQ(pprof.find("heap profile: "), 0);
+    EXPECT_NE(pprof.find("@ heap_v2/4096"), std::string::npos);
+    EXPECT_NE(pprof.find("MAPPED_LIBRARIES:"), std::string::npos);
+
+    alloc::Deallocate(large, 1 << 20);
+    for (void* ptr : ptrs) {
+      alloc::Deallocate(ptr, kBytes);
+    }
+    EXPECT_EQ(sgi::HeapProfiler::live_samples(), 0);
+  }).join();
+  alloc::SetProfileSampleInterval(0);
+}
+
+TEST(HeapProfiler, Batch) {
+  constexpr size_t kCount = 10000;
+  constexpr size_t kBytes = 48;
+  alloc::SetProfileSampleInterval(4096);
+  std::vector<void*> ptrs(kCount);
+  alloc::AllocateBatch(kBytes, kCount, ptrs.data());
+  EXPECT_GT(sgi::HeapProfiler::live_samples(), 50);
+  // freed by another thread
+  std::thread(
+      [&] { alloc::DeallocateBatch(ptrs.data(), kCount, kBytes); })
+      .join();
+  EXPECT_EQ(sgi::HeapProfiler::live_samples(), 0);
+  alloc::SetProfileSampleInterval(0);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
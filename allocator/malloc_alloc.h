@@ -1,38 +1,105 @@
 #ifndef ALLOCATOR_MALLOC_ALLOC_H_
 #define ALLOCATOR_MALLOC_ALLOC_H_
 
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include <cassert>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <new>
 
+#include "memory_pressure.h"
+
 namespace sgi {
 using size_t = std::size_t;
 
+// Blocks of at least MMAP_THRESHOLD bytes are mapped on their own, so that
+// Reallocate can grow them with mremap without copying a byte, and
+// Deallocate gives them back to the operating system at once.
+inline constexpr size_t MMAP_THRESHOLD = 1024 * 1024;
+
 // first level memory allocator
+//
+// Deallocate and Reallocate must be given the size the block was allocated
+// with, which tells mapped blocks from malloc'ed ones.
+//
+// Blocks are charged to MemoryPressure. When the system is out of memory,
+// the memory pressure callbacks run before the handler installed with
+// SetNewHandler.
 class MallocAlloc {
   using Func = void (*)();
 
  public:
   static void* Allocate(size_t n) {
-    void* ptr = malloc(n);
-    if (ptr == NULL) {
-      ptr = OomMalloc(n);
+    void* ptr = NULL;
+    if (n >= MMAP_THRESHOLD) {
+      ptr = Map(n);
+    } else {
+      ptr = malloc(n);
+      if (ptr == NULL) {
+        ptr = OomMalloc(n);
+      }
     }
+    MemoryPressure::Charge(n);
     return ptr;
   }
 
-  static void Deallocate(void* p, size_t n) { std::free(p); }
-
-  static void* Reallocate(void* p, size_t new_sz) {
-    void* ptr = realloc(p, new_sz);
-    if (ptr == NULL) {
-      ptr = OomRealloc(p, new_sz);
+  // align must be a power of two multiple of sizeof(void*)
+  static void* Allocate(size_t n, size_t align) {
+    void* ptr = NULL;
+    if (n >= MMAP_THRESHOLD && align <= PageSize()) {
+      ptr = Map(n);
+    } else if (posix_memalign(&ptr, align, n) != 0) {
+      ptr = OomMemalign(n, align);
     }
+    MemoryPressure::Charge(n);
     return ptr;
   }
 
+  static void Deallocate(void* p, size_t n) {
+    MemoryPressure::Uncharge(n);
+    if (n >= MMAP_THRESHOLD) {
+      munmap(p, RoundUpToPage(n));
+      return;
+    }
+    std::free(p);
+  }
+
+  static void Deallocate(void* p, size_t n, size_t align) {
+    MemoryPressure::Uncharge(n);
+    if (n >= MMAP_THRESHOLD && align <= PageSize()) {
+      munmap(p, RoundUpToPage(n));
+      return;
+    }
+    std::free(p);
+  }
+
+  // p must come from Allocate(old_sz). Mapped blocks grow and shrink with
+  // mremap, which moves page table entries instead of bytes.
+  static void* Reallocate(void* p, size_t old_sz, size_t new_sz) {
+    if (old_sz >= MMAP_THRESHOLD && new_sz >= MMAP_THRESHOLD) {
+      void* ptr = Remap(p, old_sz, new_sz);
+      Recharge(old_sz, new_sz);
+      return ptr;
+    }
+
+    if (old_sz < MMAP_THRESHOLD && new_sz < MMAP_THRESHOLD) {
+      void* ptr = realloc(p, new_sz);
+      if (ptr == NULL) {
+        ptr = OomRealloc(p, new_sz);
+      }
+      Recharge(old_sz, new_sz);
+      return ptr;
+    }
+
+    void* new_p = Allocate(new_sz);
+    memcpy(new_p, p, old_sz < new_sz ? old_sz : new_sz);
+    Deallocate(p, old_sz);
+    return new_p;
+  }
+
   static Func SetNewHandler(Func func) {
     Func old_handler = oom_handler_;
     oom_handler_ = func;
@@ -40,40 +107,113 @@ class MallocAlloc {
   }
 
  private:
+  static size_t PageSize() {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    return page_size;
+  }
+
+  static size_t RoundUpToPage(size_t n) {
+    return (n + PageSize() - 1) & ~(PageSize() - 1);
+  }
+
+  static void* Map(size_t n) {
+    void* ptr = mmap(nullptr, RoundUpToPage(n), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+      ptr = OomMap(n);
+    }
+    return ptr;
+  }
+
+  static void* Remap(void* p, size_t old_sz, size_t new_sz) {
+    void* ptr = mremap(p, RoundUpToPage(old_sz), RoundUpToPage(new_sz),
+                       MREMAP_MAYMOVE);
+    if (ptr == MAP_FAILED) {
+      ptr = OomRemap(p, old_sz, new_sz);
+    }
+    return ptr;
+  }
+
+  static void Recharge(size_t old_sz, size_t new_sz) {
+    if (new_sz > old_sz) {
+      MemoryPressure::Charge(new_sz - old_sz);
+    } else {
+      MemoryPressure::Uncharge(old_sz - new_sz);
+    }
+  }
+
+  // Frees memory for a failed allocation to be retried: the memory pressure
+  // callbacks first, then the OOM handler if they could not release anything.
+  // Throws std::bad_alloc without a handler.
+  static void HandleOom() {
+    if (MemoryPressure::Relieve() != 0) {
+      return;
+    }
+    if (oom_handler_ == NULL) {
+      throw std::bad_alloc();
+    }
+    (*oom_handler_)();
+  }
+
   static void* OomMalloc(size_t n);
   static void* OomRealloc(void* p, size_t n);
-  static void (*oom_handler_)();
+  static void* OomMemalign(size_t n, size_t align);
+  static void* OomMap(size_t n);
+  static void* OomRemap(void* p, size_t old_sz, size_t new_sz);
+  static inline void (*oom_handler_)() = nullptr;
 };
 
-void (*MallocAlloc::oom_handler_)() = nullptr;
-
-void* MallocAlloc::OomMalloc(size_t n) {
+inline void* MallocAlloc::OomMalloc(size_t n) {
   void* res = NULL;
   for (;;) {
-    if (oom_handler_ == NULL) {
-      throw std::bad_alloc();
-      exit(1);
+    HandleOom();
+    res = std::malloc(n);
+    if (res != NULL) {
+      return res;
     }
+  }
+}
 
-    (*oom_handler_)();
-    res = std::malloc(n);
+inline void* MallocAlloc::OomRealloc(void* p, size_t n) {
+  void* res = NULL;
+  for (;;) {
+    HandleOom();
+    res = std::realloc(p, n);
     if (res != NULL) {
       return res;
     }
   }
 }
 
-void* MallocAlloc::OomRealloc(void* p, size_t n) {
+inline void* MallocAlloc::OomMemalign(size_t n, size_t align) {
   void* res = NULL;
   for (;;) {
-    if (oom_handler_ == NULL) {
-      throw std::bad_alloc();
-      exit(1);
+    HandleOom();
+    if (posix_memalign(&res, align, n) == 0) {
+      return res;
     }
+  }
+}
 
-    (*oom_handler_)();
-    res = std::realloc(p, n);
-    if (res != NULL) {
+inline void* MallocAlloc::OomMap(size_t n) {
+  void* res = NULL;
+  for (;;) {
+    HandleOom();
+    res = mmap(nullptr, RoundUpToPage(n), PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (res != MAP_FAILED) {
+      return res;
+    }
+  }
+}
+
+inline void* MallocAlloc::OomRemap(void* p, size_t old_sz, size_t new_sz) {
+  void* res = NULL;
+  for (;;) {
+    HandleOom();
+    res = mremap(p, RoundUpToPage(old_sz), RoundUpToPage(new_sz),
+                 MREMAP_MAYMOVE);
+    if (res != MAP_FAILED) {
       return res;
     }
   }
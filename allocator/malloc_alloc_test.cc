@@ -27,6 +27,37 @@ TEST(MallocAlloc, malloc_alloc) {
   alloc.deallocate(p, NUM);
 }
 
+TEST(MallocAlloc, aligned) {
+  for (size_t align = sizeof(void*); align <= 4096; align *= 2) {
+    void* p = sgi::MallocAlloc::Allocate(100, align);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % align, 0);
+    sgi::MallocAlloc::Deallocate(p, 100, align);
+  }
+}
+
+TEST(MallocAlloc, large_blocks) {
+  constexpr size_t kBytes = 8 * sgi::MMAP_THRESHOLD;
+  char* p = static_cast<char*>(sgi::MallocAlloc::Allocate(kBytes));
+  for (size_t i = 0; i < kBytes; i += 4096) {
+    p[i] = static_cast<char>(i / 4096);
+  }
+
+  // grow and shrink with mremap
+  p = static_cast<char*>(sgi::MallocAlloc::Reallocate(p, kBytes, 4 * kBytes));
+  p[4 * kBytes - 1] = 1;
+  p = static_cast<char*>(sgi::MallocAlloc::Reallocate(p, 4 * kBytes, kBytes));
+  for (size_t i = 0; i < kBytes; i += 4096) {
+    ASSERT_EQ(p[i], static_cast<char>(i / 4096));
+  }
+
+  // between mapped and malloc'ed blocks
+  p = static_cast<char*>(sgi::MallocAlloc::Reallocate(p, kBytes, 100));
+  EXPECT_EQ(p[0], 0);
+  p = static_cast<char*>(sgi::MallocAlloc::Reallocate(p, 100, kBytes));
+  EXPECT_EQ(p[0], 0);
+  sgi::MallocAlloc::Deallocate(p, kBytes);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
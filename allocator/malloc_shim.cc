@@ -0,0 +1,239 @@
+// malloc replacement on top of DefaultAlloc, built as libsgi_malloc.so:
+//
+//   LD_PRELOAD=libsgi_malloc.so ./app
+//   SGI_MALLOC_STATS=1 LD_PRELOAD=libsgi_malloc.so ./app  # stats at exit
+//
+// SGI_HEAP_PROFILE=heap.prof samples the heap, one allocation every
+// SGI_HEAP_PROFILE_INTERVAL bytes (DEFAULT_SAMPLE_INTERVAL by default), and
+// writes the live heap for pprof to heap.prof at exit.
+//
+// free has no size argument, so every block starts with a BlockHeader right
+// before the pointer handed out, which records how the block was allocated.
+// Blocks up to MAX_SLAB_BYTES, header included, come from DefaultAlloc's size
+// classes. Larger ones and the ones DefaultAlloc itself asks for come from
+// glibc's own malloc. DefaultAlloc's statics are constant initialized, see
+// default_alloc.h, so it serves the mallocs of constructors that run before
+// this library's own.
+
+#include <errno.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "default_alloc.h"
+
+#define SGI_EXPORT extern "C" __attribute__((visibility("default")))
+
+// glibc's malloc, under the names it exports besides malloc and friends
+extern "C" {
+void* __libc_memalign(size_t align, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void __libc_free(void* p);
+}
+
+namespace {
+
+using sgi::DefaultAlloc;
+
+struct BlockHeader {
+  uint32_t offset;     // from the start of the block to the pointer
+  uint32_t from_pool;  // allocated by DefaultAlloc, else by glibc
+  size_t bytes;        // of the whole block
+};
+
+// malloc returns 16 byte aligned memory, as glibc does on 64 bit systems
+constexpr size_t HEADER_BYTES = 16;
+static_assert(sizeof(BlockHeader) == HEADER_BYTES);
+
+// Set while this thread runs DefaultAlloc, which may call malloc itself, for
+// instance to create its thread cache.
+thread_local bool in_pool = false;
+
+BlockHeader* HeaderOf(void* p) {
+  return reinterpret_cast<BlockHeader*>(static_cast<char*>(p) - HEADER_BYTES);
+}
+
+// align is a power of two of at least HEADER_BYTES
+void* AllocateBlock(size_t size, size_t align) {
+  size_t extra = align > HEADER_BYTES ? align : HEADER_BYTES;
+  if (size > SIZE_MAX - extra || extra > UINT32_MAX) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  size_t bytes = size + extra;
+
+  char* block = nullptr;
+  bool from_pool = !in_pool && bytes <= sgi::MAX_SLAB_BYTES;
+  if (from_pool) {
+    in_pool = true;
+    try {
+      block = static_cast<char*>(DefaultAlloc::Allocate(bytes, HEADER_BYTES));
+    } catch (const std::bad_alloc&) {
+    }
+    in_pool = false;
+  } else {
+    block = static_cast<char*>(__libc_memalign(HEADER_BYTES, bytes));
+  }
+  if (block == nullptr) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+
+  char* res = reinterpret_cast<char*>(
+      (reinterpret_cast<uintptr_t>(block) + HEADER_BYTES + align - 1) &
+      ~(align - 1));
+  BlockHeader* header = HeaderOf(res);
+  header->offset = static_cast<uint32_t>(res - block);
+  header->from_pool = from_pool;
+  header->bytes = bytes;
+  return res;
+}
+
+size_t UsableSize(void* p) {
+  BlockHeader* header = HeaderOf(p);
+  return header->bytes - header->offset;
+}
+
+// Sets up the heap profile at load, and writes it and the stats at exit.
+struct Reports {
+  Reports() {
+    if (getenv("SGI_HEAP_PROFILE") != nullptr) {
+      const char* interval = getenv("SGI_HEAP_PROFILE_INTERVAL");
+      DefaultAlloc::SetProfileSampleInterval(
+          interval != nullptr ? strtoull(interval, nullptr, 10)
+                              : sgi::DEFAULT_SAMPLE_INTERVAL);
+    }
+  }
+
+  ~Reports() {
+    const char* path = getenv("SGI_HEAP_PROFILE");
+    if (path != nullptr) {
+      FILE* out = fopen(path, "w");
+      if (out != nullptr) {
+        sgi::HeapProfiler::WritePprofProfile(out);
+        fclose(out);
+      }
+    }
+    if (getenv("SGI_MALLOC_STATS") != nullptr) {
+      DefaultAlloc::DumpStats(stderr);
+    }
+  }
+} reports;
+
+}  // namespace
+
+SGI_EXPORT void* malloc(size_t size) noexcept {
+  return AllocateBlock(size, HEADER_BYTES);
+}
+
+SGI_EXPORT void free(void* p) noexcept {
+  if (p == nullptr) {
+    return;
+  }
+  BlockHeader* header = HeaderOf(p);
+  char* block = static_cast<char*>(p) - header->offset;
+  if (!header->from_pool) {
+    __libc_free(block);
+    return;
+  }
+  bool nested = in_pool;
+  in_pool = true;
+  DefaultAlloc::Deallocate(block, header->bytes, HEADER_BYTES);
+  in_pool = nested;
+}
+
+SGI_EXPORT void* calloc(size_t n, size_t size) noexcept {
+  size_t bytes = 0;
+  if (__builtin_mul_overflow(n, size, &bytes)) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  void* p = malloc(bytes);
+  if (p != nullptr) {
+    memset(p, 0, bytes);  // free lists hand out used memory
+  }
+  return p;
+}
+
+SGI_EXPORT void* realloc(void* p, size_t size) noexcept {
+  if (p == nullptr) {
+    return malloc(size);
+  }
+  if (size == 0) {
+    free(p);
+    return nullptr;
+  }
+
+  BlockHeader* header = HeaderOf(p);
+  if (!header->from_pool && header->offset == HEADER_BYTES &&
+      size > sgi::MAX_SLAB_BYTES && size <= SIZE_MAX - HEADER_BYTES) {
+    // glibc grows large blocks in place or with mremap
+    char* block = static_cast<char*>(__libc_realloc(
+        static_cast<char*>(p) - HEADER_BYTES, size + HEADER_BYTES));
+    if (block == nullptr) {
+      errno = ENOMEM;
+      return nullptr;
+    }
+    header = reinterpret_cast<BlockHeader*>(block);
+    header->bytes = size + HEADER_BYTES;
+    return block + HEADER_BYTES;
+  }
+
+  // shrinking by up to half keeps the block
+  size_t usable = UsableSize(p);
+  if (size <= usable && size >= usable / 2) {
+    return p;
+  }
+  void* new_p = malloc(size);
+  if (new_p != nullptr) {
+    memcpy(new_p, p, size < usable ? size : usable);
+    free(p);
+  }
+  return new_p;
+}
+
+SGI_EXPORT int posix_memalign(void** out, size_t align, size_t size) noexcept {
+  if (align < sizeof(void*) || (align & (align - 1)) != 0) {
+    return EINVAL;
+  }
+  void* p = AllocateBlock(size, align > HEADER_BYTES ? align : HEADER_BYTES);
+  if (p == nullptr) {
+    return ENOMEM;
+  }
+  *out = p;
+  return 0;
+}
+
+SGI_EXPORT void* memalign(size_t align, size_t size) noexcept {
+  if (align == 0 || (align & (align - 1)) != 0) {
+    errno = EINVAL;
+    return nullptr;
+  }
+  return AllocateBlock(size, align > HEADER_BYTES ? align : HEADER_BYTES);
+}
+
+SGI_EXPORT void* aligned_alloc(size_t align, size_t size) noexcept {
+  return memalign(align, size);
+}
+
+SGI_EXPORT void* valloc(size_t size) noexcept {
+  return memalign(sysconf(_SC_PAGESIZE), size);
+}
+
+SGI_EXPORT void* pvalloc(size_t size) noexcept {
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  return memalign(page_size, (size + page_size - 1) & ~(page_size - 1));
+}
+
+SGI_EXPORT size_t malloc_usable_size(void* p) noexcept {
+  return p == nullptr ? 0 : UsableSize(p);
+}
+
+// Writes DefaultAlloc's stats to out.
+SGI_EXPORT void sgi_malloc_stats(FILE* out) { DefaultAlloc::DumpStats(out); }
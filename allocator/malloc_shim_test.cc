@@ -0,0 +1,120 @@
+#include <malloc.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+// defined by the shim this test is linked against, which replaces malloc
+// for the whole process, gtest included
+extern "C" void sgi_malloc_stats(FILE* out);
+
+TEST(malloc_shim, malloc_free) {
+  for (size_t size : {0, 1, 8, 24, 100, 1000, 32 * 1024, 100 * 1024}) {
+    char* p = static_cast<char*>(malloc(size));
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 16, 0);
+    EXPECT_GE(malloc_usable_size(p), size);
+    memset(p, 0xff, size);
+    free(p);
+  }
+  free(nullptr);
+  EXPECT_EQ(malloc_usable_size(nullptr), 0);
+}
+
+TEST(malloc_shim, calloc) {
+  for (int i = 0; i < 100; i++) {
+    int* p = static_cast<int*>(malloc(100 * sizeof(int)));
+    memset(p, 0xff, 100 * sizeof(int));
+    free(p);
+    // likely the block just freed
+    p = static_cast<int*>(calloc(100, sizeof(int)));
+    for (int j = 0; j < 100; j++) {
+      ASSERT_EQ(p[j], 0);
+    }
+    free(p);
+  }
+  volatile size_t huge = SIZE_MAX / 2;
+  EXPECT_EQ(calloc(huge, 4), nullptr);
+}
+
+TEST(malloc_shim, realloc) {
+  char* p = static_cast<char*>(realloc(nullptr, 10));
+  strcpy(p, "123456789");
+  for (size_t size = 16; size <= 4 * 1024 * 1024; size *= 2) {
+    p = static_cast<char*>(realloc(p, size));
+    ASSERT_NE(p, nullptr);
+    EXPECT_STREQ(p, "123456789");
+    memset(p + 10, 0, size - 10);
+  }
+  p = static_cast<char*>(realloc(p, 10));
+  EXPECT_STREQ(p, "123456789");
+  EXPECT_EQ(realloc(p, 0), nullptr);
+}
+
+TEST(malloc_shim, aligned) {
+  for (size_t align : {8, 16, 32, 64, 4096}) {
+    void* p = nullptr;
+    ASSERT_EQ(posix_memalign(&p, align, 100), 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % align, 0);
+    EXPECT_GE(malloc_usable_size(p), 100);
+    free(p);
+
+    p = aligned_alloc(align, 1000);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % align, 0);
+    free(p);
+  }
+  void* p = nullptr;
+  EXPECT_EQ(posix_memalign(&p, 24, 100), EINVAL);
+  p = valloc(10);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % sysconf(_SC_PAGESIZE), 0);
+  free(p);
+}
+
+TEST(malloc_shim, threads) {
+  // blocks are freed by other threads than the ones allocating them
+  constexpr int kThreads = 4;
+  constexpr int kCount = 10000;
+  std::vector<std::vector<void*>> blocks(kThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; i++) {
+    threads.emplace_back([&blocks, i] {
+      for (int j = 0; j < kCount; j++) {
+        size_t size = (j * 37) % 2000 + 1;
+        blocks[i].push_back(malloc(size));
+        memset(blocks[i].back(), j, size);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+  for (int i = 0; i < kThreads; i++) {
+    threads.emplace_back([&blocks, i] {
+      for (void* p : blocks[(i + 1) % kThreads]) {
+        free(p);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(malloc_shim, stats) {
+  char buf[4096] = {0};
+  FILE* out = fmemopen(buf, sizeof(buf), "w");
+  sgi_malloc_stats(out);
+  fclose(out);
+  EXPECT_NE(strstr(buf, "thread caches"), nullptr);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,149 @@
+#ifndef ALLOCATOR_MEMORY_PRESSURE_H_
+#define ALLOCATOR_MEMORY_PRESSURE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace sgi {
+using size_t = std::size_t;
+
+inline constexpr int MAX_PRESSURE_CALLBACKS = 16;
+
+// Registry of callbacks that give memory back to the system, for instance
+// DefaultAlloc's, which releases its free spans, or an application cache
+// dropping entries. Relieve runs all of them. It is called by MallocAlloc
+// before its OOM handler when the system runs out of memory, and when the
+// memory the allocators hold from the system grows over the soft limit.
+//
+// The allocators Charge the bytes they take from the system and Uncharge
+// the bytes they give back: MallocAlloc every block, DefaultAlloc its spans
+// while their pages are not released. With a soft limit a little below a
+// cgroup's memory limit, cached memory is given back before the kernel's OOM
+// killer steps in.
+class MemoryPressure {
+ public:
+  // Returns the number of bytes released. Callbacks may run on any thread,
+  // concurrently, and must not call Relieve.
+  using Callback = size_t (*)(void* arg);
+
+  // Returns a handle for RemoveCallback, or -1 if the registry is full.
+  static int AddCallback(Callback callback, void* arg) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < MAX_PRESSURE_CALLBACKS; i++) {
+      if (callbacks_[i].callback_ == nullptr) {
+        callbacks_[i] = {callback, arg};
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  static void RemoveCallback(int handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callbacks_[handle] = {nullptr, nullptr};
+  }
+
+  // Runs every callback and returns the bytes they released. Does nothing
+  // when called from a callback.
+  static size_t Relieve();
+
+  // Relieve runs whenever the charged bytes grow over bytes, and at most once
+  // per bytes / 16 of further growth while they stay over. 0, the default,
+  // turns the soft limit off.
+  static void SetSoftLimit(size_t bytes) {
+    soft_limit_.store(bytes, std::memory_order_relaxed);
+    trigger_.store(bytes != 0 ? bytes : SIZE_MAX, std::memory_order_relaxed);
+  }
+
+  static size_t soft_limit() {
+    return soft_limit_.load(std::memory_order_relaxed);
+  }
+
+  static void Charge(size_t bytes) {
+    size_t charged =
+        charged_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    if (charged > trigger_.load(std::memory_order_relaxed)) {
+      OverSoftLimit();
+    }
+  }
+
+  static void Uncharge(size_t bytes) {
+    size_t charged =
+        charged_.fetch_sub(bytes, std::memory_order_relaxed) - bytes;
+    size_t limit = soft_limit();
+    if (charged < limit && trigger_.load(std::memory_order_relaxed) != limit) {
+      trigger_.store(limit, std::memory_order_relaxed);
+    }
+  }
+
+  // bytes the allocators hold from the system
+  static size_t charged_bytes() {
+    return charged_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Entry {
+    Callback callback_;
+    void* arg_;
+  };
+
+  static void OverSoftLimit();
+
+  static inline std::mutex mutex_;
+  static inline Entry callbacks_[MAX_PRESSURE_CALLBACKS] = {};
+  static inline std::atomic<size_t> charged_{0};
+  static inline std::atomic<size_t> soft_limit_{0};
+  // SIZE_MAX when there is no limit
+  static inline std::atomic<size_t> trigger_{SIZE_MAX};
+  static inline std::atomic<bool> relieving_{false};  // by OverSoftLimit
+  static inline thread_local bool in_relieve_ = false;
+};
+
+inline size_t MemoryPressure::Relieve() {
+  if (in_relieve_) {
+    return 0;
+  }
+  in_relieve_ = true;
+
+  // callbacks run without the lock, they may allocate
+  Entry callbacks[MAX_PRESSURE_CALLBACKS];
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < MAX_PRESSURE_CALLBACKS; i++) {
+      callbacks[i] = callbacks_[i];
+    }
+  }
+  size_t released = 0;
+  for (const Entry& entry : callbacks) {
+    if (entry.callback_ != nullptr) {
+      released += entry.callback_(entry.arg_);
+    }
+  }
+
+  in_relieve_ = false;
+  return released;
+}
+
+// One thread relieves at a time, the others go on allocating.
+inline void MemoryPressure::OverSoftLimit() {
+  if (relieving_.exchange(true, std::memory_order_acquire)) {
+    return;
+  }
+  Relieve();
+
+  // Memory in use cannot be released, so the next relief waits until the
+  // charged bytes have grown some more, or have gone under the limit again.
+  size_t limit = soft_limit();
+  size_t charged = charged_bytes();
+  if (limit != 0) {
+    trigger_.store(charged > limit ? charged + limit / 16 : limit,
+                   std::memory_order_relaxed);
+  }
+  relieving_.store(false, std::memory_order_release);
+}
+
+}  // namespace sgi
+
+#endif  // ALLOCATOR_MEMORY_PRESSURE_H_
@@ -0,0 +1,108 @@
+#include "memory_pressure.h"
+
+#include <thread>
+#include <vector>
+
+#include "default_alloc.h"
+#include "gtest/gtest.h"
+#include "malloc_alloc.h"
+
+size_t CountCalls(void* arg) {
+  ++*static_cast<int*>(arg);
+  return 100;
+}
+
+TEST(MemoryPressure, Callbacks) {
+  int calls1 = 0;
+  int calls2 = 0;
+  int handle1 = sgi::MemoryPressure::AddCallback(CountCalls, &calls1);
+  int handle2 = sgi::MemoryPressure::AddCallback(CountCalls, &calls2);
+  ASSERT_NE(handle1, -1);
+  ASSERT_NE(handle2, -1);
+
+  EXPECT_GE(sgi::MemoryPressure::Relieve(), 200);
+  EXPECT_EQ(calls1, 1);
+  EXPECT_EQ(calls2, 1);
+  sgi::MemoryPressure::RemoveCallback(handle1);
+  sgi::MemoryPressure::Relieve();
+  EXPECT_EQ(calls1, 1);
+  EXPECT_EQ(calls2, 2);
+  sgi::MemoryPressure::RemoveCallback(handle2);
+
+  // the registry is bounded, and holds DefaultAlloc's callback once it has
+  // created a thread cache
+  sgi::DefaultAlloc::Deallocate(sgi::DefaultAlloc::Allocate(8), 8);
+  std::vector<int> handles;
+  int handle = 0;
+  while ((handle = sgi::MemoryPressure::AddCallback(CountCalls, &calls1)) !=
+         -1) {
+    handles.push_back(handle);
+  }
+  EXPECT_LT(handles.size(), sgi::MAX_PRESSURE_CALLBACKS);
+  for (int h : handles) {
+    sgi::MemoryPressure::RemoveCallback(h);
+  }
+}
+
+TEST(MemoryPressure, SoftLimit) {
+  constexpr size_t kBlock = 1024 * 1024;
+  int calls = 0;
+  int handle = sgi::MemoryPressure::AddCallback(CountCalls, &calls);
+  sgi::MemoryPressure::SetSoftLimit(sgi::MemoryPressure::charged_bytes() +
+                                    16 * kBlock);
+
+  std::vector<void*> blocks;
+  for (int i = 0; i < 15; i++) {
+    blocks.push_back(sgi::MallocAlloc::Allocate(kBlock));
+  }
+  EXPECT_EQ(calls, 0);
+  for (int i = 0; i < 16; i++) {
+    blocks.push_back(sgi::MallocAlloc::Allocate(kBlock));
+  }
+  // once over the limit, then once per limit / 16 of growth
+  EXPECT_GE(calls, 1);
+  EXPECT_LE(calls, 16);
+
+  // under the limit again, the next crossing relieves at once
+  for (void* block : blocks) {
+    sgi::MallocAlloc::Deallocate(block, kBlock);
+  }
+  blocks.clear();
+  calls = 0;
+  for (int i = 0; i < 17; i++) {
+    blocks.push_back(sgi::MallocAlloc::Allocate(kBlock));
+  }
+  EXPECT_EQ(calls, 1);
+  for (void* block : blocks) {
+    sgi::MallocAlloc::Deallocate(block, kBlock);
+  }
+
+  sgi::MemoryPressure::SetSoftLimit(0);
+  sgi::MemoryPressure::RemoveCallback(handle);
+}
+
+TEST(MemoryPressure, DefaultAllocReleases) {
+  constexpr size_t kBytes = 256;
+  constexpr int kCount = 40000;  // about 40 spans
+
+  // the objects end up in the idle cache of the exited thread
+  std::thread([] {
+    std::vector<void*> ptrs(kCount);
+    for (auto& ptr : ptrs) {
+      ptr = sgi::DefaultAlloc::Allocate(kBytes);
+    }
+    for (auto& ptr : ptrs) {
+      sgi::DefaultAlloc::Deallocate(ptr, kBytes);
+    }
+  }).join();
+
+  size_t charged = sgi::MemoryPressure::charged_bytes();
+  size_t released = sgi::MemoryPressure::Relieve();
+  EXPECT_GT(released, kCount * kBytes / 2);
+  EXPECT_EQ(sgi::MemoryPressure::charged_bytes(), charged - released);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,336 @@
+#ifndef ALLOCATOR_PERSISTENT_POOL_H_
+#define ALLOCATOR_PERSISTENT_POOL_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#include "default_alloc.h"
+
+// older headers lack it, older kernels take the address as a hint, which Open
+// checks
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif  // MAP_FIXED_NOREPLACE
+
+namespace sgi {
+
+// Default address of a pool's mapping, far from where the heap, the stack,
+// shared libraries and mmap usually land on x86-64 Linux.
+inline constexpr uintptr_t PERSISTENT_BASE = 0x200000000000;
+inline constexpr size_t PERSISTENT_PAGE_BYTES = 4096;
+inline constexpr size_t PERSISTENT_HEADER_BYTES = PERSISTENT_PAGE_BYTES;
+inline constexpr uint64_t PERSISTENT_MAGIC = 0x6c6f6f705f696773;  // "sgi_pool"
+
+// Memory pool in a file, for data that should survive a restart without being
+// rebuilt. The file is mapped shared at the same address in every run, so the
+// pointers stored in the pool, such as those inside the containers built on
+// it, stay valid when the next run opens the file again. Pages are read back
+// lazily, so reopening costs page faults rather than reconstruction:
+//
+//   sgi::PersistentPool* pool = sgi::PersistentPool::Open("index.pool", kGB);
+//   using Index = sgi::vector<Entry, sgi::PersistentAlloc>;
+//   if (pool->created()) {
+//     Index* index = new (pool->Allocate(sizeof(Index)))
+//         Index(Index::allocator_type(sgi::PersistentAlloc(pool)));
+//     ...  // build the index
+//     pool->set_root(index);
+//   }
+//   Index* index = static_cast<Index*>(pool->root());
+//   ...
+//   sgi::PersistentPool::Close(pool);
+//
+// Only data that holds no pointers out of the pool survives: containers of the
+// pool and trivially copyable elements, but no std::string nor vtable.
+//
+// The pool object itself is the first page of the mapping. Objects up to
+// MAX_SLAB_BYTES come from DefaultSizeClasses with a free list per class,
+// larger ones are whole pages kept on a first-fit list, never coalesced.
+// All of them are carved from the file in order and never given back to it.
+class PersistentPool {
+ public:
+  // Maps the pool in the file at path at base, creating the file with bytes
+  // of capacity if it is empty. A pool that was not closed, because its
+  // process crashed, starts over empty, see created. Returns nullptr and sets
+  // errno if the file cannot be mapped at base, if it is not a pool of that
+  // base, or if another process has it open.
+  static PersistentPool* Open(
+      const char* path, size_t bytes,
+      void* base = reinterpret_cast<void*>(PERSISTENT_BASE));
+
+  // Writes the pool back to its file and unmaps it. Nothing in the pool may be
+  // touched afterwards, so its containers are left as they are rather than
+  // destroyed.
+  static void Close(PersistentPool* pool);
+
+  // Throws std::bad_alloc once the file is full.
+  void* Allocate(size_t bytes) {
+    assert(bytes > 0);
+    if (bytes > MAX_SLAB_BYTES) {
+      return AllocateLarge(bytes);
+    }
+    size_t index = size_classes_.Index(bytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    void* res = free_lists_[index];
+    if (res != nullptr) {
+      free_lists_[index] = free_lists_[index]->next_free_obj;
+    } else {
+      res = Carve(size_classes_.sizes_[index], size_classes_.aligns_[index]);
+    }
+    allocated_bytes_ += size_classes_.sizes_[index];
+    return res;
+  }
+
+  // align must be a power of two, up to PERSISTENT_PAGE_BYTES
+  void* Allocate(size_t bytes, size_t align) {
+    assert(align <= PERSISTENT_PAGE_BYTES);
+    if (align <= ALIGN) {
+      return Allocate(bytes);
+    }
+    size_t index = size_classes_.AlignedIndex(bytes, align);
+    if (index == static_cast<size_t>(NFREELISTS)) {
+      return AllocateLarge(bytes);
+    }
+    return Allocate(size_classes_.sizes_[index]);
+  }
+
+  void Deallocate(void* p, size_t bytes) {
+    if (bytes > MAX_SLAB_BYTES) {
+      return DeallocateLarge(p, bytes);
+    }
+    size_t index = size_classes_.Index(bytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    allocated_bytes_ -= size_classes_.sizes_[index];
+    static_cast<obj*>(p)->next_free_obj = free_lists_[index];
+    free_lists_[index] = static_cast<obj*>(p);
+  }
+
+  // p must come from Allocate(bytes, align)
+  void Deallocate(void* p, size_t bytes, size_t align) {
+    if (align <= ALIGN) {
+      return Deallocate(p, bytes);
+    }
+    size_t index = size_classes_.AlignedIndex(bytes, align);
+    if (index == static_cast<size_t>(NFREELISTS)) {
+      return DeallocateLarge(p, bytes);
+    }
+    Deallocate(p, size_classes_.sizes_[index]);
+  }
+
+  // The object the next run starts from, nullptr in a new pool.
+  void* root() const { return root_; }
+  void set_root(void* root) { root_ = root; }
+
+  // Whether Open started a new, empty pool rather than reopening one.
+  bool created() const { return created_; }
+
+  size_t capacity() const { return capacity_; }
+
+  // bytes handed out and not freed
+  size_t allocated_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocated_bytes_;
+  }
+
+  // Writes the pool back to its file, as Close does, but keeps it open.
+  void Sync() { msync(this, capacity_, MS_SYNC); }
+
+ private:
+  union obj {
+    obj* next_free_obj;
+    char data[1];
+  };
+
+  struct LargeBlock {
+    LargeBlock* next_;
+    size_t bytes_;
+  };
+
+  PersistentPool(void* base, size_t capacity)
+      : base_(reinterpret_cast<uintptr_t>(base)), capacity_(capacity) {}
+
+  static size_t RoundUp(size_t bytes, size_t align) {
+    return (bytes + align - 1) & ~(align - 1);
+  }
+
+  // Takes bytes aligned to align from the end of the carved part of the file.
+  // Requires mutex_ to be held.
+  void* Carve(size_t bytes, size_t align) {
+    size_t start = RoundUp(top_, align);
+    if (start > capacity_ || bytes > capacity_ - start) {
+      throw std::bad_alloc();
+    }
+    top_ = start + bytes;
+    return reinterpret_cast<char*>(this) + start;
+  }
+
+  void* AllocateLarge(size_t bytes);
+  void DeallocateLarge(void* p, size_t bytes);
+
+  static constexpr SizeClasses<DefaultSizeClasses> size_classes_{};
+
+  // kept in the file
+  uint64_t magic_ = PERSISTENT_MAGIC;
+  uintptr_t base_;
+  size_t capacity_;
+  size_t top_ = PERSISTENT_HEADER_BYTES;  // offset of the first free byte
+  size_t allocated_bytes_ = 0;
+  bool open_ = false;  // left set by a crash
+  void* root_ = nullptr;
+  obj* free_lists_[NFREELISTS] = {};
+  LargeBlock* large_blocks_ = nullptr;
+
+  // valid while open
+  bool created_ = false;
+  int fd_ = -1;
+  mutable std::mutex mutex_;
+};
+static_assert(sizeof(PersistentPool) <= PERSISTENT_HEADER_BYTES);
+
+inline PersistentPool* PersistentPool::Open(const char* path, size_t bytes,
+                                     void* base) {
+  int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    return nullptr;
+  }
+  // the lock goes away with the process, so a pool still marked open
+  // while nobody holds it was left by a crash
+  struct stat st;
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0 || fstat(fd, &st) != 0) {
+    int error = errno == EWOULDBLOCK ? EBUSY : errno;
+    close(fd);
+    errno = error;
+    return nullptr;
+  }
+
+  bool empty = st.st_size == 0;
+  size_t capacity = empty ? RoundUp(bytes, PERSISTENT_PAGE_BYTES)
+                          : static_cast<size_t>(st.st_size);
+  if (capacity < PERSISTENT_HEADER_BYTES ||
+      (empty && ftruncate(fd, capacity) != 0)) {
+    int error = capacity < PERSISTENT_HEADER_BYTES ? EINVAL : errno;
+    close(fd);
+    errno = error;
+    return nullptr;
+  }
+
+  void* p = mmap(base, capacity, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+  if (p == MAP_FAILED || p != base) {
+    if (p != MAP_FAILED) {
+      munmap(p, capacity);
+    }
+    close(fd);
+    errno = EEXIST;
+    return nullptr;
+  }
+
+  PersistentPool* pool = static_cast<PersistentPool*>(p);
+  if (!empty && (pool->magic_ != PERSISTENT_MAGIC ||
+                 pool->base_ != reinterpret_cast<uintptr_t>(base) ||
+                 pool->capacity_ != capacity)) {
+    munmap(p, capacity);
+    close(fd);
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  bool created = empty || pool->open_;
+  if (created) {
+    new (pool) PersistentPool(base, capacity);
+  } else {
+    new (&pool->mutex_) std::mutex();
+  }
+  pool->created_ = created;
+  pool->fd_ = fd;
+  pool->open_ = true;
+  return pool;
+}
+
+inline void PersistentPool::Close(PersistentPool* pool) {
+  int fd = pool->fd_;
+  size_t capacity = pool->capacity_;
+  pool->open_ = false;
+  pool->Sync();
+  munmap(pool, capacity);
+  close(fd);  // and drop the lock
+}
+
+inline void* PersistentPool::AllocateLarge(size_t bytes) {
+  bytes = RoundUp(bytes, PERSISTENT_PAGE_BYTES);
+  std::lock_guard<std::mutex> lock(mutex_);
+  void* res = nullptr;
+  for (LargeBlock** link = &large_blocks_; *link != nullptr;
+       link = &(*link)->next_) {
+    LargeBlock* block = *link;
+    if (block->bytes_ == bytes) {
+      *link = block->next_;
+      res = block;
+      break;
+    }
+    if (block->bytes_ > bytes) {
+      // hand out the tail, the head keeps the list link
+      block->bytes_ -= bytes;
+      res = reinterpret_cast<char*>(block) + block->bytes_;
+      break;
+    }
+  }
+  if (res == nullptr) {
+    res = Carve(bytes, PERSISTENT_PAGE_BYTES);
+  }
+  allocated_bytes_ += bytes;
+  return res;
+}
+
+inline void PersistentPool::DeallocateLarge(void* p, size_t bytes) {
+  bytes = RoundUp(bytes, PERSISTENT_PAGE_BYTES);
+  std::lock_guard<std::mutex> lock(mutex_);
+  allocated_bytes_ -= bytes;
+  LargeBlock* block = static_cast<LargeBlock*>(p);
+  block->bytes_ = bytes;
+  block->next_ = large_blocks_;
+  large_blocks_ = block;
+}
+
+// Stateful policy allocating from a PersistentPool, for containers that
+// outlive the process, as in sgi::vector<Entry, PersistentAlloc>. It only
+// holds the pool's address, which is the same in every run.
+class PersistentAlloc {
+ public:
+  using propagate_on_container_swap = std::true_type;
+
+  explicit PersistentAlloc(PersistentPool* pool) : pool_(pool) {}
+
+  void* Allocate(size_t bytes) { return pool_->Allocate(bytes); }
+  void* Allocate(size_t bytes, size_t align) {
+    return pool_->Allocate(bytes, align);
+  }
+
+  void Deallocate(void* p, size_t bytes) { pool_->Deallocate(p, bytes); }
+  void Deallocate(void* p, size_t bytes, size_t align) {
+    pool_->Deallocate(p, bytes, align);
+  }
+
+  PersistentPool* pool() const { return pool_; }
+
+  bool operator==(const PersistentAlloc& other) const {
+    return pool_ == other.pool_;
+  }
+
+ private:
+  PersistentPool* pool_;
+};
+
+}  // namespace sgi
+
+#endif  // ALLOCATOR_PERSISTENT_POOL_H_
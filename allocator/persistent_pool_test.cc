@@ -0,0 +1,219 @@
+#include "persistent_pool.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "list.h"
+#include "vector.h"
+
+struct Point {
+  int x;
+  int y;
+};
+
+// what a service would rebuild on every start without the pool
+struct Index {
+  using Values = sgi::vector<int64_t, sgi::PersistentAlloc>;
+  using Points = sgi::list<Point, sgi::PersistentAlloc>;
+
+  explicit Index(sgi::PersistentPool* pool)
+      : values(Values::allocator_type(sgi::PersistentAlloc(pool))),
+        points(Points::allocator_type(sgi::PersistentAlloc(pool))) {}
+
+  Values values;
+  Points points;
+};
+
+std::string PoolPath(const char* name) {
+  return testing::TempDir() + "sgi_" + name + "_" + std::to_string(getpid());
+}
+
+void Build(sgi::PersistentPool* pool, int n) {
+  Index* index = new (pool->Allocate(sizeof(Index))) Index(pool);
+  for (int i = 0; i < n; i++) {
+    index->values.push_back(i * 3);
+    index->points.push_back({i, -i});
+  }
+  pool->set_root(index);
+}
+
+void Check(sgi::PersistentPool* pool, int n) {
+  Index* index = static_cast<Index*>(pool->root());
+  ASSERT_NE(index, nullptr);
+  ASSERT_EQ(index->values.size(), n);
+  ASSERT_EQ(index->points.size(), n);
+  int i = 0;
+  for (const Point& point : index->points) {
+    ASSERT_EQ(index->values[i], i * 3);
+    ASSERT_EQ(point.x, i);
+    ASSERT_EQ(point.y, -i);
+    i++;
+  }
+}
+
+TEST(PersistentPool, Reopen) {
+  std::string path = PoolPath("reopen");
+  unlink(path.c_str());
+  sgi::PersistentPool* pool =
+      sgi::PersistentPool::Open(path.c_str(), 64 << 20);
+  ASSERT_NE(pool, nullptr);
+  EXPECT_TRUE(pool->created());
+  EXPECT_EQ(pool->root(), nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(pool), sgi::PERSISTENT_BASE);
+  Build(pool, 10000);
+  size_t allocated = pool->allocated_bytes();
+  sgi::PersistentPool::Close(pool);
+
+  // the containers come back as they were, and keep growing in the pool
+  pool = sgi::PersistentPool::Open(path.c_str(), 0);
+  ASSERT_NE(pool, nullptr);
+  EXPECT_FALSE(pool->created());
+  EXPECT_EQ(pool->capacity(), 64 << 20);
+  EXPECT_EQ(pool->allocated_bytes(), allocated);
+  Check(pool, 10000);
+  Index* index = static_cast<Index*>(pool->root());
+  for (int i = 10000; i < 20000; i++) {
+    index->values.push_back(i * 3);
+    index->points.push_back({i, -i});
+  }
+  sgi::PersistentPool::Close(pool);
+
+  pool = sgi::PersistentPool::Open(path.c_str(), 0);
+  ASSERT_NE(pool, nullptr);
+  Check(pool, 20000);
+  sgi::PersistentPool::Close(pool);
+  unlink(path.c_str());
+}
+
+TEST(PersistentPool, Restart) {
+  std::string path = PoolPath("restart");
+  unlink(path.c_str());
+
+  // a first run builds the index and exits
+  pid_t pid = fork();
+  if (pid == 0) {
+    sgi::PersistentPool* pool =
+        sgi::PersistentPool::Open(path.c_str(), 16 << 20);
+    if (pool == nullptr || !pool->created()) {
+      _exit(1);
+    }
+    Build(pool, 5000);
+    sgi::PersistentPool::Close(pool);
+    _exit(0);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_EQ(status, 0);
+
+  // the next one finds it
+  sgi::PersistentPool* pool = sgi::PersistentPool::Open(path.c_str(), 0);
+  ASSERT_NE(pool, nullptr);
+  EXPECT_FALSE(pool->created());
+  Check(pool, 5000);
+  sgi::PersistentPool::Close(pool);
+  unlink(path.c_str());
+}
+
+TEST(PersistentPool, Crash) {
+  std::string path = PoolPath("crash");
+  unlink(path.c_str());
+
+  // a run that never closes its pool
+  pid_t pid = fork();
+  if (pid == 0) {
+    sgi::PersistentPool* pool =
+        sgi::PersistentPool::Open(path.c_str(), 16 << 20);
+    if (pool == nullptr) {
+      _exit(1);
+    }
+    Build(pool, 100);
+    pool->Sync();
+    _exit(0);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_EQ(status, 0);
+
+  // the index may be half written, the pool starts over
+  sgi::PersistentPool* pool = sgi::PersistentPool::Open(path.c_str(), 0);
+  ASSERT_NE(pool, nullptr);
+  EXPECT_TRUE(pool->created());
+  EXPECT_EQ(pool->root(), nullptr);
+  EXPECT_EQ(pool->allocated_bytes(), 0);
+  sgi::PersistentPool::Close(pool);
+  unlink(path.c_str());
+}
+
+TEST(PersistentPool, Allocate) {
+  std::string path = PoolPath("allocate");
+  unlink(path.c_str());
+  sgi::PersistentPool* pool = sgi::PersistentPool::Open(path.c_str(), 1 << 20);
+  ASSERT_NE(pool, nullptr);
+
+  // freed objects are reused by their size class
+  void* p1 = pool->Allocate(20);
+  void* p2 = pool->Allocate(24);
+  EXPECT_EQ(static_cast<char*>(p2) - static_cast<char*>(p1), 24);
+  EXPECT_EQ(pool->allocated_bytes(), 48);
+  pool->Deallocate(p1, 20);
+  EXPECT_EQ(pool->Allocate(17), p1);
+
+  void* aligned = pool->Allocate(40, 64);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0);
+  pool->Deallocate(aligned, 40, 64);
+
+  // large blocks are pages, split on reuse
+  char* large = static_cast<char*>(pool->Allocate(3 * 64 * 1024));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % sgi::PERSISTENT_PAGE_BYTES,
+            0);
+  memset(large, 1, 3 * 64 * 1024);
+  pool->Deallocate(large, 3 * 64 * 1024);
+  EXPECT_EQ(pool->Allocate(64 * 1024), large + 2 * 64 * 1024);
+  EXPECT_EQ(pool->Allocate(2 * 64 * 1024), large);
+
+  // the file does not grow
+  EXPECT_THROW(pool->Allocate(2 << 20), std::bad_alloc);
+  size_t allocated = pool->allocated_bytes();
+  EXPECT_THROW(
+      while (true) { pool->Allocate(32 * 1024); }, std::bad_alloc);
+  EXPECT_GT(pool->allocated_bytes(), allocated);
+  EXPECT_LE(pool->allocated_bytes(), pool->capacity());
+  sgi::PersistentPool::Close(pool);
+  unlink(path.c_str());
+}
+
+TEST(PersistentPool, OpenErrors) {
+  std::string path = PoolPath("errors");
+  std::string other_path = PoolPath("errors_other");
+  unlink(path.c_str());
+  unlink(other_path.c_str());
+  sgi::PersistentPool* pool = sgi::PersistentPool::Open(path.c_str(), 1 << 20);
+  ASSERT_NE(pool, nullptr);
+
+  // one process at a time
+  errno = 0;
+  EXPECT_EQ(sgi::PersistentPool::Open(path.c_str(), 0), nullptr);
+  EXPECT_EQ(errno, EBUSY);
+
+  // the address is taken
+  errno = 0;
+  EXPECT_EQ(sgi::PersistentPool::Open(other_path.c_str(), 1 << 20), nullptr);
+  EXPECT_EQ(errno, EEXIST);
+  sgi::PersistentPool::Close(pool);
+
+  // a pool only maps at its own base
+  void* base = reinterpret_cast<void*>(sgi::PERSISTENT_BASE + (1 << 30));
+  errno = 0;
+  EXPECT_EQ(sgi::PersistentPool::Open(path.c_str(), 0, base), nullptr);
+  EXPECT_EQ(errno, EINVAL);
+
+  unlink(path.c_str());
+  unlink(other_path.c_str());
+}
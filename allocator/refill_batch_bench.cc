@@ -0,0 +1,100 @@
+// Built twice: refill_batch_bench with the slow start refill batch, and
+// refill_batch_fixed_bench with SGI_FIXED_REFILL_BATCH.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "default_alloc.h"
+
+using alloc = sgi::DefaultAlloc;
+
+constexpr int kLiveObjects = 4096;
+constexpr int kOpsPerThread = 1 << 16;
+
+// 90% of the requests are 16 or 24 bytes, the rest are spread log-uniformly
+// up to MAX_SLAB_BYTES, so most size classes are touched only now and then.
+class SkewedSizes {
+ public:
+  explicit SkewedSizes(unsigned seed) : rng_(seed) {}
+
+  size_t Next() {
+    if (coin_(rng_) < 0.9) {
+      return coin_(rng_) < 0.5 ? 16 : 24;
+    }
+    return static_cast<size_t>(std::exp(log_size_(rng_)));
+  }
+
+ private:
+  std::mt19937 rng_;
+  std::uniform_real_distribution<double> coin_{0.0, 1.0};
+  std::uniform_real_distribution<double> log_size_{
+      std::log(8.0), std::log(static_cast<double>(sgi::MAX_SLAB_BYTES))};
+};
+
+uint64_t TotalRefills() {
+  uint64_t refills = 0;
+  for (const auto& size_class : alloc::GetStats().size_classes) {
+    refills += size_class.refills;
+  }
+  return refills;
+}
+
+// Each thread keeps kLiveObjects objects alive and replaces a random one
+// kOpsPerThread times. Reports refills per allocation, and the peak of the
+// memory held by free lists and memory pools, sampled by every thread before
+// it frees its objects.
+static void BM_SkewedMix(benchmark::State& state) {
+  int nthreads = state.range(0);
+  uint64_t refills = TotalRefills();
+  std::atomic<size_t> peak_cached_bytes{0};
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nthreads; t++) {
+      threads.emplace_back([t, &peak_cached_bytes] {
+        SkewedSizes sizes(t);
+        std::mt19937 rng(t);
+        std::vector<std::pair<void*, size_t>> live(kLiveObjects);
+        for (auto& object : live) {
+          object.second = sizes.Next();
+          object.first = alloc::Allocate(object.second);
+        }
+        for (int i = 0; i < kOpsPerThread; i++) {
+          auto& object = live[rng() % kLiveObjects];
+          alloc::Deallocate(object.first, object.second);
+          object.second = sizes.Next();
+          object.first = alloc::Allocate(object.second);
+        }
+
+        alloc::Stats stats = alloc::GetStats();
+        size_t cached_bytes = stats.free_list_bytes + stats.pool_bytes;
+        size_t peak = peak_cached_bytes.load();
+        while (peak < cached_bytes &&
+               !peak_cached_bytes.compare_exchange_weak(peak, cached_bytes)) {
+        }
+        for (auto& object : live) {
+          alloc::Deallocate(object.first, object.second);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  uint64_t allocations =
+      state.iterations() * nthreads * (kLiveObjects + kOpsPerThread);
+  state.counters["refills/alloc"] =
+      static_cast<double>(TotalRefills() - refills) / allocations;
+  state.counters["peak_cached_KiB"] = peak_cached_bytes.load() / 1024.0;
+  state.counters["heap_KiB"] = alloc::GetStats().extend_heap_size / 1024.0;
+  state.SetItemsProcessed(allocations);
+}
+BENCHMARK(BM_SkewedMix)->Arg(1)->Arg(4)->Arg(8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,139 @@
+#ifndef ALLOCATOR_SIZE_CLASS_OPTIMIZER_H_
+#define ALLOCATOR_SIZE_CLASS_OPTIMIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "default_alloc.h"
+
+namespace sgi {
+
+// Number of requests of one size in a workload's allocation histogram.
+struct SizeCount {
+  size_t size;
+  uint64_t count;
+};
+
+// Sizes a size class table may hold, see ValidSizeClasses.
+inline std::vector<size_t> LegalClassSizes() {
+  std::vector<size_t> sizes;
+  for (size_t size = ALIGN; size <= 1024; size += ALIGN) {
+    sizes.push_back(size);
+  }
+  for (size_t size = 1024 + 128; size <= MAX_SLAB_BYTES; size += 128) {
+    sizes.push_back(size);
+  }
+  return sizes;
+}
+
+// Bytes lost to internal fragmentation when the requests of histogram are
+// rounded up to sizes, an increasing table ending at MAX_SLAB_BYTES. Larger
+// requests do not go to the size classes and are ignored.
+inline uint64_t SizeClassWaste(const std::vector<SizeCount>& histogram,
+                               const std::vector<size_t>& sizes) {
+  uint64_t waste = 0;
+  for (const SizeCount& bucket : histogram) {
+    if (bucket.size == 0 || bucket.size > MAX_SLAB_BYTES) {
+      continue;
+    }
+    size_t index = 0;
+    while (sizes[index] < bucket.size) {
+      index++;
+    }
+    waste += (sizes[index] - bucket.size) * bucket.count;
+  }
+  return waste;
+}
+
+// Returns the table of at most max_classes size classes that wastes the least
+// bytes on histogram, and that BasicDefaultAlloc accepts as its Config::sizes.
+//
+// Sizes missing from the histogram still have to be served, so every class
+// is at most max_ratio times the class below it, or the next legal size
+// above it. With the default 1.25, no request wastes more than a fifth of
+// its class, as with DefaultSizeClasses. Returns an empty table if
+// max_classes are too few to cover MAX_SLAB_BYTES that way.
+//
+// Dynamic programming over the legal sizes: the cheapest table with k classes
+// ending at size j extends the cheapest one with k - 1 classes ending below
+// j, in O(max_classes * LegalClassSizes().size()^2).
+inline std::vector<size_t> OptimalSizeClasses(
+    const std::vector<SizeCount>& histogram, int max_classes = NFREELISTS,
+    double max_ratio = 1.25) {
+  const std::vector<size_t> candidates = LegalClassSizes();
+  const size_t n = candidates.size();
+
+  // requests and requested bytes up to each candidate, so that rounding the
+  // requests between two candidates up to the larger one costs O(1)
+  std::vector<uint64_t> counts(n, 0);
+  std::vector<uint64_t> bytes(n, 0);
+  for (const SizeCount& bucket : histogram) {
+    if (bucket.size == 0 || bucket.size > MAX_SLAB_BYTES) {
+      continue;
+    }
+    size_t j = 0;
+    while (candidates[j] < bucket.size) {
+      j++;
+    }
+    counts[j] += bucket.count;
+    bytes[j] += bucket.size * bucket.count;
+  }
+  for (size_t j = 1; j < n; j++) {
+    counts[j] += counts[j - 1];
+    bytes[j] += bytes[j - 1];
+  }
+
+  // waste of the requests in (candidates[i], candidates[j]]
+  auto cost = [&](size_t i, size_t j) {
+    return candidates[j] * (counts[j] - counts[i]) - (bytes[j] - bytes[i]);
+  };
+
+  if (max_classes < 2) {
+    return {};
+  }
+  const uint64_t INF = UINT64_MAX;
+  const size_t k_max = max_classes;
+  std::vector<std::vector<uint64_t>> best(
+      k_max + 1, std::vector<uint64_t>(n, INF));
+  std::vector<std::vector<size_t>> prev(k_max + 1, std::vector<size_t>(n, 0));
+  best[1][0] = candidates[0] * counts[0] - bytes[0];  // the first is ALIGN
+
+  size_t best_k = 0;
+  for (size_t k = 2; k <= k_max; k++) {
+    for (size_t j = 1; j < n; j++) {
+      for (size_t i = j; i-- > 0;) {
+        if (i + 1 != j && candidates[j] > candidates[i] * max_ratio) {
+          break;  // so is every smaller i
+        }
+        if (best[k - 1][i] == INF) {
+          continue;
+        }
+        uint64_t total = best[k - 1][i] + cost(i, j);
+        if (total < best[k][j]) {
+          best[k][j] = total;
+          prev[k][j] = i;
+        }
+      }
+    }
+    if (best[k][n - 1] != INF &&
+        (best_k == 0 || best[k][n - 1] < best[best_k][n - 1])) {
+      best_k = k;
+    }
+  }
+  if (best_k == 0) {
+    return {};
+  }
+
+  std::vector<size_t> sizes(best_k);
+  size_t j = n - 1;
+  for (size_t k = best_k; k > 0; k--) {
+    sizes[k - 1] = candidates[j];
+    j = prev[k][j];
+  }
+  return sizes;
+}
+
+}  // namespace sgi
+
+#endif  // ALLOCATOR_SIZE_CLASS_OPTIMIZER_H_
@@ -0,0 +1,64 @@
+#include "size_class_optimizer.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(SizeClassOptimizer, Waste) {
+  std::vector<sgi::SizeCount> histogram = {{20, 10}, {40, 5}, {100000, 3}};
+  std::vector<size_t> sizes = {8, 24, 48, 32768};
+  // 4 bytes for each 20, 8 for each 40, large requests do not count
+  EXPECT_EQ(sgi::SizeClassWaste(histogram, sizes), 10 * 4 + 5 * 8);
+}
+
+TEST(SizeClassOptimizer, FitsHistogram) {
+  std::vector<sgi::SizeCount> histogram = {
+      {24, 1000}, {40, 800}, {72, 500}, {1000, 3}, {5120, 2}};
+  std::vector<size_t> sizes = sgi::OptimalSizeClasses(histogram);
+  ASSERT_FALSE(sizes.empty());
+  EXPECT_LE(sizes.size(), sgi::NFREELISTS);
+  EXPECT_TRUE(sgi::ValidSizeClasses(sizes));
+
+  // every requested size gets a class of its own
+  EXPECT_EQ(sgi::SizeClassWaste(histogram, sizes), 0);
+
+  // and no class grows by more than the ratio, or one legal step
+  for (size_t i = 1; i < sizes.size(); i++) {
+    size_t step = sizes[i - 1] < 1024 ? sgi::ALIGN : 128;
+    EXPECT_TRUE(sizes[i] <= sizes[i - 1] * 1.25 ||
+                sizes[i] == sizes[i - 1] + step);
+  }
+}
+
+TEST(SizeClassOptimizer, Optimal) {
+  // with three classes, the middle one is the only choice; compare it with
+  // every legal size
+  std::vector<sgi::SizeCount> histogram = {
+      {24, 7}, {32, 5}, {96, 3}, {704, 2}, {3072, 1}};
+  std::vector<size_t> sizes = sgi::OptimalSizeClasses(histogram, 3, 1e9);
+  ASSERT_EQ(sizes.size(), 3);
+  uint64_t waste = sgi::SizeClassWaste(histogram, sizes);
+  for (size_t size : sgi::LegalClassSizes()) {
+    if (size > sgi::ALIGN && size < sgi::MAX_SLAB_BYTES) {
+      std::vector<size_t> other = {sgi::ALIGN, size, sgi::MAX_SLAB_BYTES};
+      EXPECT_LE(waste, sgi::SizeClassWaste(histogram, other));
+    }
+  }
+
+  // more classes never waste more
+  uint64_t prev_waste = waste;
+  for (int max_classes = 4; max_classes <= 8; max_classes++) {
+    sizes = sgi::OptimalSizeClasses(histogram, max_classes, 1e9);
+    uint64_t waste = sgi::SizeClassWaste(histogram, sizes);
+    EXPECT_LE(waste, prev_waste);
+    prev_waste = waste;
+  }
+  EXPECT_EQ(prev_waste, 0);
+}
+
+TEST(SizeClassOptimizer, TooFewClasses) {
+  std::vector<sgi::SizeCount> histogram = {{24, 1}};
+  EXPECT_TRUE(sgi::OptimalSizeClasses(histogram, 1).empty());
+  EXPECT_TRUE(sgi::OptimalSizeClasses(histogram, 10, 1.25).empty());
+  EXPECT_EQ(sgi::OptimalSizeClasses(histogram, 2, 1e9).size(), 2);
+}
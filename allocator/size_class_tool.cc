@@ -0,0 +1,99 @@
+// Fits a size class table to an allocation size histogram:
+//
+//   size_class_tool [-n max_classes] [-r max_ratio] [-s struct] [histogram]
+//
+// The histogram, read from the file or from stdin, has one size per line,
+// optionally followed by the number of requests of that size. Lines starting
+// with '#' are skipped. The table is printed as a Config for
+// BasicDefaultAlloc, see size_class_optimizer.h for the options.
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "size_class_optimizer.h"
+
+namespace {
+
+int Usage() {
+  fprintf(stderr,
+          "usage: size_class_tool [-n max_classes] [-r max_ratio] "
+          "[-s struct] [histogram]\n");
+  return 2;
+}
+
+double Percent(uint64_t part, uint64_t total) {
+  return total == 0 ? 0 : 100.0 * part / total;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int max_classes = sgi::NFREELISTS;
+  double max_ratio = 1.25;
+  const char* name = "ProfiledSizeClasses";
+  const char* path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      max_classes = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      max_ratio = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      name = argv[++i];
+    } else if (argv[i][0] != '-' && path == nullptr) {
+      path = argv[i];
+    } else {
+      return Usage();
+    }
+  }
+
+  FILE* in = path != nullptr ? fopen(path, "r") : stdin;
+  if (in == nullptr) {
+    perror(path);
+    return 1;
+  }
+  std::vector<sgi::SizeCount> histogram;
+  uint64_t requested = 0;
+  char line[256];
+  while (fgets(line, sizeof(line), in) != nullptr) {
+    unsigned long long size = 0;
+    unsigned long long count = 1;
+    if (line[0] == '#' || sscanf(line, "%llu %llu", &size, &count) < 1) {
+      continue;
+    }
+    histogram.push_back({size, count});
+    if (size <= sgi::MAX_SLAB_BYTES) {
+      requested += size * count;
+    }
+  }
+  if (in != stdin) {
+    fclose(in);
+  }
+
+  std::vector<size_t> sizes =
+      sgi::OptimalSizeClasses(histogram, max_classes, max_ratio);
+  if (sizes.empty()) {
+    fprintf(stderr, "%d classes cannot cover %d bytes with a ratio of %g\n",
+            max_classes, sgi::MAX_SLAB_BYTES, max_ratio);
+    return 1;
+  }
+  const auto& default_sizes = sgi::DefaultSizeClasses::sizes;
+  uint64_t waste = sgi::SizeClassWaste(histogram, sizes);
+  uint64_t default_waste = sgi::SizeClassWaste(
+      histogram,
+      std::vector<size_t>(default_sizes.begin(), default_sizes.end()));
+
+  printf("// %zu size classes, wasting %.2f%% of %" PRIu64
+         " requested bytes\n"
+         "// (DefaultSizeClasses: %.2f%%)\n",
+         sizes.size(), Percent(waste, requested), requested,
+         Percent(default_waste, requested));
+  printf("struct %s {\n  static constexpr size_t sizes[] = {", name);
+  for (size_t i = 0; i < sizes.size(); i++) {
+    printf(i % 8 == 0 ? "\n      %zu," : " %zu,", sizes[i]);
+  }
+  printf("\n  };\n};\n");
+  return 0;
+}
@@ -2,19 +2,49 @@
 #define ALLOCATOR_UNINITIALIZED_H_
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "algobase.h"
 #include "construct.h"
+#include "thread_pool.h"
 
 namespace sgi {
 
+// Whether a T may be relocated, that is moved to new storage with the
+// original destroyed, by copying its bytes. True for trivially copyable types,
+// and specialized to true for types that hold no pointer to themselves and
+// whose moved-from state owns nothing, such as
+//
+//   template <>
+//   struct sgi::is_trivially_relocatable<Handle> : std::true_type {};
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type {};
+
+template <typename T>
+struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {};
+
+template <typename T>
+struct is_trivially_relocatable<std::weak_ptr<T>> : std::true_type {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
 template <typename InputIter, typename ForwardIter>
 inline ForwardIter uninitialized_copy_aux(InputIter first, InputIter last,
                                           ForwardIter result, std::true_type) {
-  // TODO(leisy): use sgi::copy instead of std::copy
-  ForwardIter it = std::copy(first, last, result);
-  return it;
+  return sgi::copy(first, last, result);
 }
 
 template <typename InputIter, typename ForwardIter>
@@ -28,7 +58,7 @@ inline ForwardIter uninitialized_copy_aux(InputIter first, InputIter last,
     }
   } catch (...) {
     sgi::destroy(result_bk, result);  // commit or rollback
-    result = result_bk;
+    throw;
   }
   return result;
 }
@@ -37,34 +67,89 @@ template <typename InputIter, typename ForwardIter>
 inline ForwardIter uninitialized_copy(InputIter first, InputIter last,
                                       ForwardIter result) {
   using type = typename std::iterator_traits<ForwardIter>::value_type;
-  uninitialized_copy_aux(first, last, result,
-                         std::is_trivially_copyable<type>());
+  return uninitialized_copy_aux(first, last, result,
+                                std::is_trivially_copyable<type>());
 }
 
-inline char* uninitialized_copy(const char* first, const char* last,
-                                char* result) {
-  memmove(result, first, last - first);
-  return result + (last - first);
+template <typename InputIter, typename Size, typename ForwardIter>
+inline ForwardIter uninitialized_copy_n(InputIter first, Size count,
+                                        ForwardIter result) { /*TODO*/
 }
 
-#ifdef __STDC_ISO_10646__
-inline wchar_t* uninitialized_copy(const wchar_t* first, const wchar_t* last,
-                                   wchar_t* result) {
-  memmove(result, first, sizeof(wchar_t) * (last - first));
-  return result + (last - first);
+template <typename InputIter, typename ForwardIter>
+inline ForwardIter uninitialized_move_aux(InputIter first, InputIter last,
+                                          ForwardIter result, std::true_type) {
+  return sgi::copy(first, last, result);
 }
-#endif  // __STDC_ISO_10646__
 
-template <typename InputIter, typename Size, typename ForwardIter>
-inline ForwardIter uninitialized_copy_n(InputIter first, Size count,
-                                        ForwardIter result) { /*TODO*/
+template <typename InputIter, typename ForwardIter>
+inline ForwardIter uninitialized_move_aux(InputIter first, InputIter last,
+                                          ForwardIter result, std::false_type) {
+  auto result_bk = result;
+  try {
+    for (; first != last; first++) {
+      sgi::construct(&*result, std::move(*first));
+      result++;
+    }
+  } catch (...) {
+    sgi::destroy(result_bk, result);  // commit or rollback
+    throw;
+  }
+  return result;
+}
+
+// Like uninitialized_copy, but move constructs the new objects, leaving
+// [first, last) in their moved-from state.
+template <typename InputIter, typename ForwardIter>
+inline ForwardIter uninitialized_move(InputIter first, InputIter last,
+                                      ForwardIter result) {
+  using type = typename std::iterator_traits<ForwardIter>::value_type;
+  return uninitialized_move_aux(first, last, result,
+                                std::is_trivially_copyable<type>());
+}
+
+// Moves when the move constructor cannot throw or when there is no copy
+// constructor, and copies otherwise, so that if it throws, [first, last) is
+// still intact. This is what growing a container needs for the strong
+// exception guarantee.
+template <typename InputIter, typename ForwardIter>
+inline ForwardIter uninitialized_move_if_noexcept(InputIter first,
+                                                  InputIter last,
+                                                  ForwardIter result) {
+  using type = typename std::iterator_traits<InputIter>::value_type;
+  if constexpr (std::is_nothrow_move_constructible_v<type> ||
+                !std::is_copy_constructible_v<type>) {
+    return sgi::uninitialized_move(first, last, result);
+  } else {
+    return sgi::uninitialized_copy(first, last, result);
+  }
+}
+
+// Relocates [first, last) to the uninitialized storage at result: the objects
+// are moved there and the originals destroyed. Trivially relocatable objects
+// are copied with memmove, and the ranges may then overlap. Otherwise result
+// must not be in [first, last), and if a move throws, the objects relocated
+// so far stay at result while the others stay in place.
+template <typename T>
+inline T* uninitialized_relocate(T* first, T* last, T* result) {
+  if constexpr (is_trivially_relocatable_v<T>) {
+    memmove(static_cast<void*>(result), static_cast<const void*>(first),
+            sizeof(T) * (last - first));
+    return result + (last - first);
+  } else {
+    for (; first != last; first++) {
+      sgi::construct(result, std::move(*first));
+      sgi::destroy(first);
+      result++;
+    }
+    return result;
+  }
 }
 
 template <typename ForwardIter, typename T>
 inline void uninitialized_fill_aux(ForwardIter first, ForwardIter last,
                                    const T& value, std::true_type) {
-  // TODO(leisy): use sgi::fill instead of std::file
-  std::fill(first, last, value);
+  sgi::fill(first, last, value);
 }
 
 template <typename ForwardIter, typename T>
@@ -77,6 +162,7 @@ inline void uninitialized_fill_aux(ForwardIter first, ForwardIter last,
     }
   } catch (...) {
     sgi::destroy(first_bk, first);  // commit or rollback
+    throw;
   }
 }
 
@@ -91,8 +177,7 @@ inline void uninitialized_fill(ForwardIter first, ForwardIter last,
 template <typename ForwardIter, typename Size, typename T>
 inline ForwardIter uninitialized_fill_n_aux(ForwardIter first, Size count,
                                             const T& value, std::true_type) {
-  // TODO(leisy): use sgi::fill_n instead of std::fill_n
-  return std::fill_n(first, count, value);
+  return sgi::fill_n(first, count, value);
 }
 
 template <typename ForwardIter, typename Size, typename T>
@@ -106,7 +191,7 @@ inline ForwardIter uninitialized_fill_n_aux(ForwardIter first, Size count,
     }
   } catch (...) {
     sgi::destroy(first_bk, first);  // commit or rollback
-    first = first_bk;
+    throw;
   }
   return first;
 }
@@ -119,6 +204,154 @@ inline ForwardIter uninitialized_fill_n(ForwardIter first, Size count,
                                   std::is_trivially_copyable<type>());
 }
 
+template <typename ForwardIter>
+inline void uninitialized_default_construct_aux(ForwardIter, ForwardIter,
+                                                std::true_type) {
+  // default-initialized trivial objects are left as they are
+}
+
+template <typename ForwardIter>
+inline void uninitialized_default_construct_aux(ForwardIter first,
+                                                ForwardIter last,
+                                                std::false_type) {
+  using type = typename std::iterator_traits<ForwardIter>::value_type;
+  auto first_bk = first;
+  try {
+    for (; first != last; first++) {
+      new (static_cast<void*>(&*first)) type;
+    }
+  } catch (...) {
+    sgi::destroy(first_bk, first);  // commit or rollback
+    throw;
+  }
+}
+
+// Default-initializes objects in [first, last): unlike construct without
+// arguments, which value-initializes them, trivial types are not zeroed.
+template <typename ForwardIter>
+inline void uninitialized_default_construct(ForwardIter first,
+                                            ForwardIter last) {
+  using type = typename std::iterator_traits<ForwardIter>::value_type;
+  uninitialized_default_construct_aux(
+      first, last, std::is_trivially_default_constructible<type>());
+}
+
+// Ranges of fewer bytes are not worth splitting across threads, see
+// parallel_uninitialized_fill.
+inline constexpr size_t PARALLEL_MIN_BYTES = 4 << 20;
+inline constexpr size_t PARALLEL_CHUNK_BYTES = 1 << 20;
+inline constexpr size_t PARALLEL_PAGE_BYTES = 4096;
+
+// Runs construct_chunk(begin, end) on chunks of the n uninitialized objects
+// at first, on the threads of pool. Each call must leave its chunk either
+// fully constructed or as it was and rethrow. If one throws, the chunks
+// constructed by the others are destroyed and its exception is rethrown.
+template <typename RandomIter, typename ConstructChunk>
+inline void parallel_construct(RandomIter first, size_t n, ThreadPool& pool,
+                               ConstructChunk construct_chunk) {
+  using type = typename std::iterator_traits<RandomIter>::value_type;
+  size_t ntasks = std::min(pool.concurrency() * 4,
+                           n * sizeof(type) / PARALLEL_CHUNK_BYTES + 1);
+  // boundaries of contiguous ranges on pages, so that each page is first
+  // touched, and placed, by the thread filling it
+  std::vector<size_t> bounds(ntasks + 1, n);
+  for (size_t k = 0; k < ntasks; k++) {
+    size_t index = n / ntasks * k;
+    if constexpr (is_contiguous_iterator_v<RandomIter>) {
+      uintptr_t base = reinterpret_cast<uintptr_t>(sgi::to_address(first));
+      uintptr_t address = base + index * sizeof(type);
+      address = (address + PARALLEL_PAGE_BYTES - 1) &
+                ~(PARALLEL_PAGE_BYTES - 1);
+      index = std::min(n, (address - base + sizeof(type) - 1) / sizeof(type));
+    }
+    bounds[k] = k == 0 ? 0 : index;
+  }
+
+  std::unique_ptr<bool[]> done(new bool[ntasks]());
+  try {
+    pool.Run(ntasks, [&](size_t k) {
+      construct_chunk(bounds[k], bounds[k + 1]);
+      done[k] = true;
+    });
+  } catch (...) {
+    for (size_t k = 0; k < ntasks; k++) {
+      if (done[k]) {
+        sgi::destroy(first + bounds[k], first + bounds[k + 1]);
+      }
+    }
+    throw;
+  }
+}
+
+template <typename Iter>
+inline constexpr bool is_random_access_v = std::is_base_of_v<
+    std::random_access_iterator_tag,
+    typename std::iterator_traits<Iter>::iterator_category>;
+
+// Like uninitialized_fill, but ranges of PARALLEL_MIN_BYTES or more are split
+// across the threads of pool, ThreadPool::Default() if null, value being
+// copied by all of them at once. This spreads the page faults of fresh
+// memory, and its pages, across the cores. Commit or rollback: if a copy
+// throws, nothing is left constructed.
+template <typename ForwardIter, typename T>
+inline void parallel_uninitialized_fill(ForwardIter first, ForwardIter last,
+                                        const T& value,
+                                        ThreadPool* pool = nullptr) {
+  using type = typename std::iterator_traits<ForwardIter>::value_type;
+  if constexpr (is_random_access_v<ForwardIter>) {
+    size_t n = static_cast<size_t>(last - first);
+    // the default pool is only started for ranges large enough to use it
+    if (n * sizeof(type) >= PARALLEL_MIN_BYTES) {
+      ThreadPool& threads = pool != nullptr ? *pool : ThreadPool::Default();
+      if (threads.concurrency() > 1) {
+        parallel_construct(first, n, threads, [&](size_t begin, size_t end) {
+          sgi::uninitialized_fill(first + begin, first + end, value);
+        });
+        return;
+      }
+    }
+  }
+  sgi::uninitialized_fill(first, last, value);
+}
+
+template <typename ForwardIter, typename Size, typename T>
+inline ForwardIter parallel_uninitialized_fill_n(ForwardIter first, Size count,
+                                                 const T& value,
+                                                 ThreadPool* pool = nullptr) {
+  if constexpr (is_random_access_v<ForwardIter>) {
+    if (count <= 0) {
+      return first;
+    }
+    sgi::parallel_uninitialized_fill(first, first + count, value, pool);
+    return first + count;
+  } else {
+    return sgi::uninitialized_fill_n(first, count, value);
+  }
+}
+
+// Like uninitialized_copy, split across the threads of pool as
+// parallel_uninitialized_fill.
+template <typename InputIter, typename ForwardIter>
+inline ForwardIter parallel_uninitialized_copy(InputIter first, InputIter last,
+                                               ForwardIter result,
+                                               ThreadPool* pool = nullptr) {
+  using type = typename std::iterator_traits<ForwardIter>::value_type;
+  if constexpr (is_random_access_v<InputIter> &&
+                is_random_access_v<ForwardIter>) {
+    size_t n = static_cast<size_t>(last - first);
+    if (n * sizeof(type) >= PARALLEL_MIN_BYTES) {
+      ThreadPool& threads = pool != nullptr ? *pool : ThreadPool::Default();
+      if (threads.concurrency() > 1) {
+        parallel_construct(result, n, threads, [&](size_t begin, size_t end) {
+          sgi::uninitialized_copy(first + begin, first + end, result + begin);
+        });
+        return result + n;
+      }
+    }
+  }
+  return sgi::uninitialized_copy(first, last, result);
+}
+
 }  // namespace sgi
 
 #endif  // ALLOCATOR_UNINITIALIZED_H_
\ No newline at end of file
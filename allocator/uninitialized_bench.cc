@@ -0,0 +1,59 @@
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include "benchmark/benchmark.h"
+#include "thread_pool.h"
+#include "uninitialized.h"
+
+constexpr size_t BYTES = 1 << 30;
+
+// fresh pages each time, so that their first touch is measured too
+int64_t* Map(size_t bytes) {
+  void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return static_cast<int64_t*>(p);
+}
+
+// Fills 1 GB of new memory with range(0) threads.
+static void BM_ParallelFill(benchmark::State& state) {
+  sgi::ThreadPool pool(state.range(0) - 1);
+  size_t n = BYTES / sizeof(int64_t);
+  for (auto _ : state) {
+    int64_t* p = Map(BYTES);
+    sgi::parallel_uninitialized_fill(p, p + n, int64_t{-1}, &pool);
+    benchmark::DoNotOptimize(p);
+    munmap(p, BYTES);
+  }
+  state.SetBytesProcessed(state.iterations() * BYTES);
+}
+BENCHMARK(BM_ParallelFill)
+    ->RangeMultiplier(2)
+    ->Range(1, std::thread::hardware_concurrency())
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Copies 1 GB into new memory with range(0) threads.
+static void BM_ParallelCopy(benchmark::State& state) {
+  sgi::ThreadPool pool(state.range(0) - 1);
+  size_t n = BYTES / sizeof(int64_t);
+  int64_t* src = Map(BYTES);
+  sgi::uninitialized_fill(src, src + n, int64_t{1});
+  for (auto _ : state) {
+    int64_t* p = Map(BYTES);
+    sgi::parallel_uninitialized_copy(src, src + n, p, &pool);
+    benchmark::DoNotOptimize(p);
+    munmap(p, BYTES);
+  }
+  munmap(src, BYTES);
+  state.SetBytesProcessed(state.iterations() * BYTES);
+}
+BENCHMARK(BM_ParallelCopy)
+    ->RangeMultiplier(2)
+    ->Range(1, std::thread::hardware_concurrency())
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
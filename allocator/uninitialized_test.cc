@@ -1,6 +1,10 @@
 #include "uninitialized.h"
 
+#include <atomic>
 #include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
 #include <vector>
 
@@ -99,6 +103,274 @@ TEST(Uninitialized, uninitialized_fill_n) {
   EXPECT_EQ(temp_it, temp_first + NUM);
 }
 
+TEST(Uninitialized, uninitialized_move) {
+  std::vector<std::string> strs;
+  std::vector<const char*> data;
+  for (int i = 0; i < NUM; i++) {
+    strs.push_back(std::string(100, 'a' + i));
+    data.push_back(strs.back().data());
+  }
+
+  sgi::allocator<std::string> alloc;
+  std::string* res = alloc.allocate(NUM);
+  EXPECT_EQ(sgi::uninitialized_move(strs.begin(), strs.end(), res), res + NUM);
+  for (int i = 0; i < NUM; i++) {
+    EXPECT_EQ(res[i].data(), data[i]);  // the buffers moved along
+    EXPECT_EQ(res[i], std::string(100, 'a' + i));
+  }
+  sgi::destroy(res, res + NUM);
+  alloc.deallocate(res, NUM);
+
+  // move-only types
+  std::unique_ptr<int> ptrs[2] = {std::make_unique<int>(1),
+                                  std::make_unique<int>(2)};
+  sgi::allocator<std::unique_ptr<int>> ptr_alloc;
+  std::unique_ptr<int>* ptr_res = ptr_alloc.allocate(2);
+  sgi::uninitialized_move_if_noexcept(ptrs, ptrs + 2, ptr_res);
+  EXPECT_EQ(ptrs[0], nullptr);
+  EXPECT_EQ(*ptr_res[1], 2);
+  sgi::destroy(ptr_res, ptr_res + 2);
+  ptr_alloc.deallocate(ptr_res, 2);
+}
+
+// copies count down to a throw, moves may throw
+struct Throwing {
+  static int copies_left;
+  static int live;
+
+  explicit Throwing(int value) : value(value) { live++; }
+  Throwing(const Throwing& other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy");
+    }
+    live++;
+  }
+  Throwing(Throwing&& other) : value(other.value) {
+    other.value = -1;
+    live++;
+  }
+  ~Throwing() { live--; }
+
+  int value;
+};
+int Throwing::copies_left = 0;
+int Throwing::live = 0;
+
+TEST(Uninitialized, uninitialized_move_if_noexcept) {
+  static_assert(!std::is_nothrow_move_constructible_v<Throwing>);
+  sgi::allocator<Throwing> alloc;
+  Throwing* src = alloc.allocate(NUM);
+  for (int i = 0; i < NUM; i++) {
+    sgi::construct(src + i, i);
+  }
+
+  // the move constructor may throw, so the objects are copied
+  Throwing* dst = alloc.allocate(NUM);
+  Throwing::copies_left = NUM;
+  sgi::uninitialized_move_if_noexcept(src, src + NUM, dst);
+  for (int i = 0; i < NUM; i++) {
+    EXPECT_EQ(src[i].value, i);
+    EXPECT_EQ(dst[i].value, i);
+  }
+  sgi::destroy(dst, dst + NUM);
+
+  // a throwing copy destroys the new objects, leaves the old ones intact and
+  // reaches the caller
+  Throwing::copies_left = 3;
+  EXPECT_THROW(sgi::uninitialized_move_if_noexcept(src, src + NUM, dst),
+               std::runtime_error);
+  EXPECT_EQ(Throwing::live, NUM);
+  for (int i = 0; i < NUM; i++) {
+    EXPECT_EQ(src[i].value, i);
+  }
+
+  sgi::destroy(src, src + NUM);
+  alloc.deallocate(src, NUM);
+  alloc.deallocate(dst, NUM);
+}
+
+struct Defaulted {
+  Defaulted() : value(7) {}
+  int value;
+};
+
+TEST(Uninitialized, uninitialized_default_construct) {
+  sgi::allocator<Defaulted> alloc;
+  Defaulted* ptr = alloc.allocate(NUM);
+  sgi::uninitialized_default_construct(ptr, ptr + NUM);
+  for (int i = 0; i < NUM; i++) {
+    EXPECT_EQ(ptr[i].value, 7);
+  }
+  alloc.deallocate(ptr, NUM);
+
+  // trivial objects keep what the memory held
+  int ints[NUM];
+  for (int i = 0; i < NUM; i++) {
+    ints[i] = i;
+  }
+  sgi::uninitialized_default_construct(ints, ints + NUM);
+  for (int i = 0; i < NUM; i++) {
+    EXPECT_EQ(ints[i], i);
+  }
+}
+
+// owns a counted resource, declared relocatable below
+struct Handle {
+  static int live;
+
+  explicit Handle(int id) : id(new int(id)) { live++; }
+  Handle(Handle&& other) noexcept : id(other.id) {
+    other.id = nullptr;
+    live++;
+  }
+  ~Handle() {
+    delete id;
+    live--;
+  }
+
+  int* id;
+};
+int Handle::live = 0;
+
+template <>
+struct sgi::is_trivially_relocatable<Handle> : std::true_type {};
+
+TEST(Uninitialized, is_trivially_relocatable) {
+  static_assert(sgi::is_trivially_relocatable_v<int>);
+  static_assert(sgi::is_trivially_relocatable_v<std::unique_ptr<Foo>>);
+  static_assert(sgi::is_trivially_relocatable_v<std::shared_ptr<Foo>>);
+  static_assert(sgi::is_trivially_relocatable_v<Handle>);
+  static_assert(!sgi::is_trivially_relocatable_v<Temp>);
+  static_assert(!sgi::is_trivially_relocatable_v<Throwing>);
+}
+
+TEST(Uninitialized, uninitialized_relocate) {
+  // the bytes move, no constructor nor destructor runs
+  sgi::allocator<Handle> alloc;
+  Handle* src = alloc.allocate(NUM);
+  for (int i = 0; i < NUM; i++) {
+    sgi::construct(src + i, i);
+  }
+  Handle* dst = alloc.allocate(NUM + 2);
+  EXPECT_EQ(sgi::uninitialized_relocate(src, src + NUM, dst), dst + NUM);
+  EXPECT_EQ(Handle::live, NUM);
+
+  // overlapping ranges, as when inserting in place
+  sgi::uninitialized_relocate(dst, dst + NUM, dst + 2);
+  for (int i = 0; i < NUM; i++) {
+    EXPECT_EQ(*dst[i + 2].id, i);
+  }
+  sgi::destroy(dst + 2, dst + NUM + 2);
+  EXPECT_EQ(Handle::live, 0);
+  alloc.deallocate(src, NUM);
+  alloc.deallocate(dst, NUM + 2);
+
+  // other types are moved, then the originals destroyed
+  sgi::allocator<Throwing> throwing_alloc;
+  Throwing* from = throwing_alloc.allocate(NUM);
+  Throwing* to = throwing_alloc.allocate(NUM);
+  for (int i = 0; i < NUM; i++) {
+    sgi::construct(from + i, i);
+  }
+  sgi::uninitialized_relocate(from, from + NUM, to);
+  EXPECT_EQ(Throwing::live, NUM);
+  for (int i = 0; i < NUM; i++) {
+    EXPECT_EQ(to[i].value, i);
+  }
+  sgi::destroy(to, to + NUM);
+  throwing_alloc.deallocate(from, NUM);
+  throwing_alloc.deallocate(to, NUM);
+}
+
+TEST(Uninitialized, parallel_uninitialized_fill) {
+  sgi::ThreadPool pool(3);
+  const size_t n = 10 * sgi::PARALLEL_MIN_BYTES / sizeof(int) + 123;
+  sgi::allocator<int> alloc;
+  int* ptr = alloc.allocate(n);
+  sgi::parallel_uninitialized_fill(ptr, ptr + n, 7, &pool);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(ptr[i], 7) << i;
+  }
+  EXPECT_EQ(sgi::parallel_uninitialized_fill_n(ptr + 1, n - 2, 8, &pool),
+            ptr + n - 1);
+  EXPECT_EQ(ptr[0], 7);
+  EXPECT_EQ(ptr[n / 2], 8);
+  EXPECT_EQ(ptr[n - 1], 7);
+
+  int* copy = alloc.allocate(n);
+  EXPECT_EQ(sgi::parallel_uninitialized_copy(ptr, ptr + n, copy, &pool),
+            copy + n);
+  EXPECT_EQ(memcmp(ptr, copy, n * sizeof(int)), 0);
+  alloc.deallocate(ptr, n);
+  alloc.deallocate(copy, n);
+
+  std::vector<std::string> strs(100000, "abc");
+  sgi::allocator<std::string> str_alloc;
+  std::string* str_copy = str_alloc.allocate(strs.size());
+  sgi::parallel_uninitialized_copy(strs.begin(), strs.end(), str_copy, &pool);
+  EXPECT_EQ(str_copy[99999], "abc");
+  sgi::destroy(str_copy, str_copy + strs.size());
+  str_alloc.deallocate(str_copy, strs.size());
+}
+
+TEST(Uninitialized, parallel_default_pool) {
+  // ranges too small to split never start the default pool
+  int small[4];
+  EXPECT_EQ(sgi::parallel_uninitialized_fill_n(small, 4, 0), small + 4);
+  sgi::parallel_uninitialized_fill(small, small + 4, 1);
+  int copy[4];
+  sgi::parallel_uninitialized_copy(small, small + 4, copy);
+  EXPECT_EQ(copy[3], 1);
+  EXPECT_FALSE(sgi::ThreadPool::DefaultStarted());
+
+  const size_t n = sgi::PARALLEL_MIN_BYTES / sizeof(int);
+  sgi::allocator<int> alloc;
+  int* ptr = alloc.allocate(n);
+  sgi::parallel_uninitialized_fill(ptr, ptr + n, 2);
+  EXPECT_EQ(ptr[n - 1], 2);
+  EXPECT_TRUE(sgi::ThreadPool::DefaultStarted());
+  alloc.deallocate(ptr, n);
+}
+
+// a page, whose copies throw from some count on
+struct Page {
+  static std::atomic<int> copies_left;
+  static std::atomic<int> live;
+
+  Page() { live++; }
+  Page(const Page&) {
+    if (copies_left-- <= 0) {
+      throw std::runtime_error("copy");
+    }
+    live++;
+  }
+  ~Page() { live--; }
+
+  char data[4096];
+};
+std::atomic<int> Page::copies_left{0};
+std::atomic<int> Page::live{0};
+
+TEST(Uninitialized, parallel_rollback) {
+  sgi::ThreadPool pool(3);
+  const size_t n = 4 * sgi::PARALLEL_MIN_BYTES / sizeof(Page);
+  sgi::allocator<Page> alloc;
+  Page* ptr = alloc.allocate(n);
+  Page value;
+
+  Page::copies_left = n;
+  sgi::parallel_uninitialized_fill(ptr, ptr + n, value, &pool);
+  EXPECT_EQ(Page::live, n + 1);
+  sgi::destroy(ptr, ptr + n);
+
+  // chunks that completed are destroyed too
+  Page::copies_left = n / 2;
+  EXPECT_THROW(sgi::parallel_uninitialized_fill(ptr, ptr + n, value, &pool),
+               std::runtime_error);
+  EXPECT_EQ(Page::live, 1);
+  alloc.deallocate(ptr, n);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -2,6 +2,8 @@
 #define ITERATOR_ITERATOR_H_
 
 #include <cstddef>
+#include <type_traits>
+#include <utility>
 
 namespace sgi {
 
@@ -10,6 +12,10 @@ struct output_iterator_tag {};
 struct forward_iterator_tag : public input_iterator_tag {};
 struct bidirectional_iterator_tag : public forward_iterator_tag {};
 struct random_access_iterator_tag : public bidirectional_iterator_tag {};
+// Elements at consecutive addresses, as in an array or a vector, so that
+// algorithms may work on the memory between to_address(first) and
+// to_address(last) directly.
+struct contiguous_iterator_tag : public random_access_iterator_tag {};
 
 template <typename IteratorCategory, typename T,
           typename Distance = std::ptrdiff_t, typename Pointer = T*,
@@ -33,7 +39,7 @@ struct iterator_traits {
 
 template <typename T>
 struct iterator_traits<T*> {
-  typedef random_access_iterator_tag iterator_category;
+  typedef contiguous_iterator_tag iterator_category;
   typedef T value_type;
   typedef std::ptrdiff_t difference_type;
   typedef T* pointer;
@@ -42,13 +48,44 @@ struct iterator_traits<T*> {
 
 template <typename T>
 struct iterator_traits<const T*> {
-  typedef random_access_iterator_tag iterator_category;
+  typedef contiguous_iterator_tag iterator_category;
   typedef T value_type;
   typedef std::ptrdiff_t difference_type;
   typedef const T* pointer;
   typedef const T& reference;
 };
 
+// Whether Iterator is a pointer, such as sgi::vector<T>::iterator, or a class
+// wrapping one that declares contiguous_iterator_tag as its category and has
+// operator->.
+template <typename Iterator, typename = void>
+struct is_contiguous_iterator : std::false_type {};
+
+template <typename T>
+struct is_contiguous_iterator<T*> : std::true_type {};
+
+template <typename Iterator>
+struct is_contiguous_iterator<Iterator,
+                              std::void_t<typename Iterator::iterator_category>>
+    : std::is_base_of<contiguous_iterator_tag,
+                      typename Iterator::iterator_category> {};
+
+template <typename Iterator>
+inline constexpr bool is_contiguous_iterator_v =
+    is_contiguous_iterator<Iterator>::value;
+
+// The address of the element a contiguous iterator refers to, which may be
+// past the end.
+template <typename T>
+constexpr T* to_address(T* pointer) noexcept {
+  return pointer;
+}
+
+template <typename Iterator>
+constexpr auto to_address(const Iterator& it) noexcept {
+  return sgi::to_address(it.operator->());
+}
+
 template <typename Iterator>
 inline typename iterator_traits<Iterator>::value_type* value_type(
     const Iterator&) {
@@ -70,17 +107,17 @@ inline iterator_traits<Iterator> iterator_category(const Iterator&) {
 }
 
 template <typename InputIterator>
-inline typename iterator_traits<InputIterator>::differece_type distance_aux(
-    const InputIterator& first, const InputIterator& last, input_iterator_tag) {
+inline typename iterator_traits<InputIterator>::difference_type distance_aux(
+    InputIterator first, const InputIterator& last, input_iterator_tag) {
   typename iterator_traits<InputIterator>::difference_type count = 0;
-  for (; first != last; first++) {
+  for (; first != last; ++first) {
     ++count;
   }
   return count;
 }
 
 template <typename RandomAccessIterator>
-inline typename iterator_traits<RandomAccessIterator>::differece_type
+inline typename iterator_traits<RandomAccessIterator>::difference_type
 distance_aux(const RandomAccessIterator& first,
              const RandomAccessIterator& last, random_access_iterator_tag) {
   return last - first;
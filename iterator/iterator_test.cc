@@ -1,7 +1,53 @@
 #include "iterator.h"
 
+#include <list>
+#include <type_traits>
+
 #include "gtest/gtest.h"
 
+// a pointer in a class, as the iterators of a string or an array often are
+struct WrappedPointer {
+  using iterator_category = sgi::contiguous_iterator_tag;
+  using value_type = int;
+  using difference_type = std::ptrdiff_t;
+  using pointer = int*;
+  using reference = int&;
+
+  int* operator->() const { return p; }
+
+  int* p;
+};
+
+struct ListIterator {
+  using iterator_category = sgi::bidirectional_iterator_tag;
+  using value_type = int;
+  using difference_type = std::ptrdiff_t;
+  using pointer = int*;
+  using reference = int&;
+};
+
+TEST(Iterator, contiguous) {
+  static_assert(std::is_base_of_v<sgi::random_access_iterator_tag,
+                                  sgi::contiguous_iterator_tag>);
+  static_assert(std::is_same_v<sgi::iterator_traits<int*>::iterator_category,
+                               sgi::contiguous_iterator_tag>);
+  static_assert(sgi::is_contiguous_iterator_v<int*>);
+  static_assert(sgi::is_contiguous_iterator_v<const char*>);
+  static_assert(sgi::is_contiguous_iterator_v<WrappedPointer>);
+  static_assert(!sgi::is_contiguous_iterator_v<ListIterator>);
+  static_assert(!sgi::is_contiguous_iterator_v<int>);
+  static_assert(!sgi::is_contiguous_iterator_v<std::list<int>::iterator>);
+
+  int values[4] = {1, 2, 3, 4};
+  EXPECT_EQ(sgi::to_address(values + 4), values + 4);
+  EXPECT_EQ(sgi::to_address(WrappedPointer{values + 2}), values + 2);
+
+  int* it = values;
+  sgi::advance(it, 3);
+  EXPECT_EQ(*it, 4);
+  EXPECT_EQ(sgi::distance(values + 0, it), 3);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
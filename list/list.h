@@ -1,6 +1,10 @@
 #ifndef LIST_LIST_H_
 #define LIST_LIST_H_
 
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
 #include "alloc.h"
 #include "construct.h"
 #include "iterator.h"
@@ -16,7 +20,7 @@ struct _list_node {
 
 template <typename T, typename Ref, typename Ptr>
 struct list_iterator {
-  using value = T;
+  using value_type = T;
   using pointer = Ptr;
   using reference = Ref;
   using iterator_category = bidirectional_iterator_tag;
@@ -31,6 +35,7 @@ struct list_iterator {
 
   list_iterator(link_type ptr = nullptr) : node_(ptr) {}
   list_iterator(const iterator& it) : node_(it.node_) {}
+  list_iterator& operator=(const list_iterator&) = default;
 
   bool operator==(const self& it) const { return node_ == it.node_; }
   bool operator!=(const self& it) const { return node_ != it.node_; }
@@ -61,17 +66,58 @@ struct list_iterator {
   }
 };
 
+// The node allocator is a private base, so that a stateless one takes no
+// space.
 template <typename T, typename Alloc = alloc>
-class list {
+class list : private sgi::allocator<_list_node<T>, Alloc> {
   using iterator = list_iterator<T, T&, T*>;
   using list_node = _list_node<T>;
   using link_type = _list_node<T>*;
   using size_type = std::size_t;
   using reference = T&;
+  using node_allocator = sgi::allocator<list_node, Alloc>;
 
  public:
+  using allocator_type = sgi::allocator<T, Alloc>;
+
   list() { init_empty_list(); }
-  ~list() {}
+  explicit list(const allocator_type& alloc) : node_allocator(alloc) {
+    init_empty_list();
+  }
+  list(size_type n, const T& val) {
+    init_empty_list();
+    try {
+      insert(end(), n, val);
+    } catch (...) {
+      deallocate_node(dummy_node_);
+      throw;
+    }
+  }
+  template <typename InputIter,
+            typename = std::enable_if_t<!std::is_integral_v<InputIter>>>
+  list(InputIter first, InputIter last) {
+    init_empty_list();
+    try {
+      insert(end(), first, last);
+    } catch (...) {
+      deallocate_node(dummy_node_);
+      throw;
+    }
+  }
+  list(const list& other);
+  list(list&& other);
+  ~list() {
+    clear();
+    deallocate_node(dummy_node_);
+  }
+
+  // Whether the allocator follows the elements is decided by the
+  // propagate_on_container_* members of the allocator, see alloc.h.
+  list& operator=(const list& other);
+  list& operator=(list&& other);
+  void swap(list& other) noexcept;
+
+  allocator_type get_allocator() const { return allocator_type(allocator()); }
 
   iterator begin() const { return iterator(dummy_node_->next); }
   iterator end() const { return iterator(dummy_node_); }
@@ -85,13 +131,44 @@ class list {
   reference front() { return *begin(); }   // empty list results in UB
   reference back() { return *(--end()); }  // empty list results in UB
 
-  void push_front(const T& val);
-  void push_back(const T& val);
+  void push_front(const T& val) { emplace(begin(), val); }
+  void push_front(T&& val) { emplace(begin(), std::move(val)); }
+  void push_back(const T& val) { emplace(end(), val); }
+  void push_back(T&& val) { emplace(end(), std::move(val)); }
   void pop_front();  // empty list results in UB
   void pop_back();   // empty list results in UB
 
-  iterator insert(iterator position, const T& val);
+  // Construct the new element in its node from args.
+  template <typename... Args>
+  reference emplace_front(Args&&... args) {
+    return *emplace(begin(), std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    return *emplace(end(), std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  iterator emplace(iterator position, Args&&... args);
+
+  iterator insert(iterator position, const T& val) {
+    return emplace(position, val);
+  }
+  iterator insert(iterator position, T&& val) {
+    return emplace(position, std::move(val));
+  }
+
+  // Bulk insertions take NODE_BATCH nodes at a time from the allocator's
+  // allocate_batch, and clear gives them back with deallocate_batch. Both
+  // return the first inserted element, or position if there is none, and
+  // insert nothing if constructing an element throws.
+  iterator insert(iterator position, size_type n, const T& val);
+  template <typename InputIter,
+            typename = std::enable_if_t<!std::is_integral_v<InputIter>>>
+  iterator insert(iterator position, InputIter first, InputIter last);
+
   iterator erase(iterator position);
+  // remove and unique unlink the nodes they drop in one pass, then free them
+  // in batches like clear, so value may be an element of the list.
   void remove(const T& value);
   void unique();  // need to ensure that the list is sorted
   void clear();
@@ -105,7 +182,8 @@ class list {
   void sort();
 
  private:
-  using node_allocator = sgi::allocator<list_node, Alloc>;
+  node_allocator& allocator() { return *this; }
+  const node_allocator& allocator() const { return *this; }
 
   link_type allocate_node() {
     return static_cast<link_type>(node_allocator::allocate());
@@ -113,9 +191,15 @@ class list {
 
   void deallocate_node(link_type p) { node_allocator::deallocate(p); }
 
-  link_type create_node(const T& val) {
+  template <typename... Args>
+  link_type create_node(Args&&... args) {
     link_type node = allocate_node();
-    sgi::construct(&(node->data), val);
+    try {
+      sgi::construct(&(node->data), std::forward<Args>(args)...);
+    } catch (...) {
+      deallocate_node(node);
+      throw;
+    }
     return node;
   }
 
@@ -124,6 +208,20 @@ class list {
     deallocate_node(node);
   }
 
+  // links nodes[0, n) in front of position
+  void link_nodes(iterator position, link_type* nodes, size_type n);
+  // When constructing a batch throws, destroy_batch destroys the elements of
+  // nodes[0, constructed) and frees nodes[0, n), and destroy_between the
+  // batches linked before it, so that the insertion has no effect.
+  void destroy_batch(link_type* nodes, size_type constructed, size_type n);
+  void destroy_between(link_type prev_node, link_type next_node);
+  // destroys the nodes from first on, chained by next, until last
+  void destroy_nodes(link_type first, link_type last);
+  // unlinks node, chaining it in front of *dropped to destroy later
+  void unlink_node(link_type node, link_type* dropped);
+
+  static constexpr size_type NODE_BATCH = 64;
+
   void init_empty_list();
   void transfer(iterator position, iterator first, iterator last);
 
@@ -138,23 +236,89 @@ inline void list<T, Alloc>::init_empty_list() {
 }
 
 template <typename T, typename Alloc>
-inline void list<T, Alloc>::push_front(const T& val) {
-  link_type node = create_node(val);
-  link_type head = dummy_node_->next;
-  node->next = head;
-  node->prev = dummy_node_;
-  head->prev = node;
-  dummy_node_->next = node;
+inline list<T, Alloc>::list(const list& other)
+    : node_allocator(other.allocator()) {
+  init_empty_list();
+  try {
+    insert(end(), other.begin(), other.end());
+  } catch (...) {
+    deallocate_node(dummy_node_);
+    throw;
+  }
 }
 
 template <typename T, typename Alloc>
-inline void list<T, Alloc>::push_back(const T& val) {
-  link_type tail = dummy_node_->prev;
-  link_type node = create_node(val);
-  node->prev = tail;
-  node->next = dummy_node_;
-  tail->next = node;
-  dummy_node_->prev = node;
+inline list<T, Alloc>::list(list&& other) : node_allocator(other.allocator()) {
+  init_empty_list();
+  splice(end(), other);
+}
+
+template <typename T, typename Alloc>
+inline list<T, Alloc>& list<T, Alloc>::operator=(const list& other) {
+  if (this == &other) {
+    return *this;
+  }
+
+  if constexpr (node_allocator::propagate_on_container_copy_assignment::value) {
+    if (allocator() != other.allocator()) {
+      // the nodes must be freed by the allocator that made them
+      clear();
+      deallocate_node(dummy_node_);
+      allocator() = other.allocator();
+      init_empty_list();
+    }
+  }
+
+  // reuse the nodes we have
+  iterator first1 = begin();
+  iterator first2 = other.begin();
+  while (first1 != end() && first2 != other.end()) {
+    *first1++ = *first2++;
+  }
+  while (first1 != end()) {
+    first1 = erase(first1);
+  }
+  insert(end(), first2, other.end());
+  return *this;
+}
+
+template <typename T, typename Alloc>
+inline list<T, Alloc>& list<T, Alloc>::operator=(list&& other) {
+  if (this == &other) {
+    return *this;
+  }
+
+  clear();
+  if constexpr (node_allocator::propagate_on_container_move_assignment::value) {
+    deallocate_node(dummy_node_);
+    allocator() = other.allocator();
+    init_empty_list();
+    splice(end(), other);
+  } else if constexpr (node_allocator::is_always_equal::value) {
+    splice(end(), other);
+  } else {
+    // nodes of another heap cannot be taken over, the elements are moved
+    if (allocator() == other.allocator()) {
+      splice(end(), other);
+    } else {
+      insert(end(), std::make_move_iterator(other.begin()),
+             std::make_move_iterator(other.end()));
+      other.clear();
+    }
+  }
+  return *this;
+}
+
+// Swapping lists with unequal allocators that do not propagate on swap is
+// undefined, as with the standard containers.
+template <typename T, typename Alloc>
+inline void list<T, Alloc>::swap(list& other) noexcept {
+  if constexpr (node_allocator::propagate_on_container_swap::value) {
+    std::swap(allocator(), other.allocator());
+  } else {
+    assert(allocator() == other.allocator());
+  }
+  std::swap(dummy_node_, other.dummy_node_);
 }
 
 template <typename T, typename Alloc>
@@ -176,9 +340,10 @@ inline void list<T, Alloc>::pop_back() {
 }
 
 template <typename T, typename Alloc>
-inline typename list<T, Alloc>::iterator list<T, Alloc>::insert(
-    iterator position, const T& val) {
-  link_type node = create_node(val);
+template <typename... Args>
+inline typename list<T, Alloc>::iterator list<T, Alloc>::emplace(
+    iterator position, Args&&... args) {
+  link_type node = create_node(std::forward<Args>(args)...);
   node->next = position.node_;
   node->prev = position.node_->prev;
   (position.node_->prev)->next = node;
@@ -186,6 +351,73 @@ inline typename list<T, Alloc>::iterator list<T, Alloc>::insert(
   return iterator(node);
 }
 
+template <typename T, typename Alloc>
+inline typename list<T, Alloc>::iterator list<T, Alloc>::insert(
+    iterator position, size_type n, const T& val) {
+  link_type prev_node = position.node_->prev;
+  link_type nodes[NODE_BATCH];
+  while (n > 0) {
+    size_type count = n < NODE_BATCH ? n : NODE_BATCH;
+    node_allocator::allocate_batch(count, nodes);
+    size_type i = 0;
+    try {
+      for (; i < count; i++) {
+        sgi::construct(&(nodes[i]->data), val);
+      }
+    } catch (...) {
+      destroy_batch(nodes, i, count);
+      destroy_between(prev_node, position.node_);
+      throw;
+    }
+    link_nodes(position, nodes, count);
+    n -= count;
+  }
+  return iterator(prev_node->next);
+}
+
+template <typename T, typename Alloc>
+template <typename InputIter, typename>
+inline typename list<T, Alloc>::iterator list<T, Alloc>::insert(
+    iterator position, InputIter first, InputIter last) {
+  // The length of the range is unknown, so the last batch may be too large.
+  // An allocator without batches gets one node at a time, not to waste
+  // memory it cannot take back, like an arena.
+  const size_type batch = node_allocator::can_batch ? NODE_BATCH : 1;
+  link_type prev_node = position.node_->prev;
+  link_type nodes[NODE_BATCH];
+  while (first != last) {
+    node_allocator::allocate_batch(batch, nodes);
+    size_type count = 0;
+    try {
+      for (; count < batch && first != last; ++first, ++count) {
+        sgi::construct(&(nodes[count]->data), *first);
+      }
+    } catch (...) {
+      destroy_batch(nodes, count, batch);
+      destroy_between(prev_node, position.node_);
+      throw;
+    }
+    if (count < batch) {
+      node_allocator::deallocate_batch(nodes + count, batch - count);
+    }
+    link_nodes(position, nodes, count);
+  }
+  return iterator(prev_node->next);
+}
+
+template <typename T, typename Alloc>
+inline void list<T, Alloc>::link_nodes(iterator position, link_type* nodes,
+                                       size_type n) {
+  link_type prev_node = position.node_->prev;
+  for (size_type i = 0; i < n; i++) {
+    nodes[i]->prev = prev_node;
+    prev_node->next = nodes[i];
+    prev_node = nodes[i];
+  }
+  prev_node->next = position.node_;
+  position.node_->prev = prev_node;
+}
+
 template <typename T, typename Alloc>
 inline typename list<T, Alloc>::iterator list<T, Alloc>::erase(
     iterator position) {
@@ -197,42 +429,89 @@ inline typename list<T, Alloc>::iterator list<T, Alloc>::erase(
   return iterator(next_node);
 }
 
+template <typename T, typename Alloc>
+inline void list<T, Alloc>::unlink_node(link_type node, link_type* dropped) {
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->next = *dropped;
+  *dropped = node;
+}
+
 template <typename T, typename Alloc>
 inline void list<T, Alloc>::remove(const T& value) {
-  auto it = begin();
-  while (it != end()) {
-    if ((*it) == value) {
-      it = erase(it);
-    } else {
-      ++it;
+  link_type dropped = nullptr;
+  link_type curr = dummy_node_->next;
+  while (curr != dummy_node_) {
+    link_type next = curr->next;
+    if (curr->data == value) {
+      unlink_node(curr, &dropped);
     }
+    curr = next;
   }
+  destroy_nodes(dropped, nullptr);
 }
 
 template <typename T, typename Alloc>
-inline void list<T, Alloc>::clear() {
-  auto it = begin();
-  while (it != end()) {
-    it = erase(it);
+inline void list<T, Alloc>::destroy_nodes(link_type first, link_type last) {
+  link_type nodes[NODE_BATCH];
+  size_type count = 0;
+  while (first != last) {
+    link_type next = first->next;
+    sgi::destroy(&(first->data));
+    nodes[count++] = first;
+    if (count == NODE_BATCH) {
+      node_allocator::deallocate_batch(nodes, count);
+      count = 0;
+    }
+    first = next;
+  }
+  if (count > 0) {
+    node_allocator::deallocate_batch(nodes, count);
   }
 }
 
+template <typename T, typename Alloc>
+inline void list<T, Alloc>::destroy_batch(link_type* nodes,
+                                          size_type constructed, size_type n) {
+  for (size_type i = 0; i < constructed; i++) {
+    sgi::destroy(&(nodes[i]->data));
+  }
+  node_allocator::deallocate_batch(nodes, n);
+}
+
+template <typename T, typename Alloc>
+inline void list<T, Alloc>::destroy_between(link_type prev_node,
+                                            link_type next_node) {
+  destroy_nodes(prev_node->next, next_node);
+  prev_node->next = next_node;
+  next_node->prev = prev_node;
+}
+
+template <typename T, typename Alloc>
+inline void list<T, Alloc>::clear() {
+  destroy_nodes(dummy_node_->next, dummy_node_);
+  dummy_node_->next = dummy_node_;
+  dummy_node_->prev = dummy_node_;
+}
+
 template <typename T, typename Alloc>
 inline void list<T, Alloc>::unique() {
-  if (empty() || size() == 1) {
+  link_type dropped = nullptr;
+  link_type prev = dummy_node_->next;
+  if (prev == dummy_node_) {
     return;
   }
-
-  auto prev_it = begin();
-  auto it = ++begin();
-  while (it != end()) {
-    if (*it == *prev_it) {
-      it = erase(it);
+  link_type curr = prev->next;
+  while (curr != dummy_node_) {
+    link_type next = curr->next;
+    if (curr->data == prev->data) {
+      unlink_node(curr, &dropped);
     } else {
-      ++prev_it;
-      ++it;
+      prev = curr;
     }
+    curr = next;
   }
+  destroy_nodes(dropped, nullptr);
 }
 
 template <typename T, typename Alloc>
@@ -326,5 +605,10 @@ inline void list<T, Alloc>::reverse() {
   }
 }
 
+template <typename T, typename Alloc>
+inline void swap(list<T, Alloc>& lhs, list<T, Alloc>& rhs) noexcept {
+  lhs.swap(rhs);
+}
+
 }  // namespace sgi
 #endif  // LIST_LIST_H_
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "list.h"
+
+// Builds a list of range(0) ints and clears it. push_back takes one node at a
+// time from the allocator, the range constructor and clear take and give
+// back NODE_BATCH nodes at a time.
+static void BM_PushBackClear(benchmark::State& state) {
+  size_t n = state.range(0);
+  for (auto _ : state) {
+    sgi::list<int> lst;
+    for (size_t i = 0; i < n; i++) {
+      lst.push_back(static_cast<int>(i));
+    }
+    benchmark::DoNotOptimize(&lst.front());
+    while (!lst.empty()) {
+      lst.pop_back();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void BM_RangeClear(benchmark::State& state) {
+  size_t n = state.range(0);
+  std::vector<int> values(n);
+  for (size_t i = 0; i < n; i++) {
+    values[i] = static_cast<int>(i);
+  }
+  for (auto _ : state) {
+    sgi::list<int> lst(values.begin(), values.end());
+    benchmark::DoNotOptimize(&lst.front());
+    lst.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(BM_PushBackClear)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_RangeClear)->Range(1 << 10, 1 << 20);
+
+BENCHMARK_MAIN();
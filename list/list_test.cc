@@ -1,7 +1,13 @@
 #include "list.h"
 
+#include <memory>
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "arena_alloc.h"
 #include "gtest/gtest.h"
 
 inline constexpr int DEFAULT_VAL = 101;
@@ -179,6 +185,24 @@ TEST(list, remove) {
   EXPECT_EQ(foo_list.size(), 20);
 }
 
+TEST(list, remove_element) {
+  sgi::list<int> int_list;
+  for (int i = 0; i < 300; i++) {
+    int_list.push_back(i % 3);
+  }
+  // value is the first element, destroyed only after the pass
+  int_list.remove(int_list.front());
+  EXPECT_EQ(int_list.size(), 200);
+  EXPECT_EQ(int_list.front(), 1);
+  EXPECT_EQ(int_list.back(), 2);
+
+  int_list.remove(5);
+  EXPECT_EQ(int_list.size(), 200);
+  int_list.remove(1);
+  int_list.remove(2);
+  EXPECT_TRUE(int_list.empty());
+}
+
 TEST(list, clear) {
   sgi::list<Foo> foo_list;
   for (int i = 0; i < 20; i++) {
@@ -214,6 +238,17 @@ TEST(list, unique) {
   for (auto it = foo_list.begin(); it != foo_list.end(); it++) {
     EXPECT_EQ(it->value_, value++);
   }
+
+  sgi::list<int> int_list;
+  int_list.unique();
+  EXPECT_TRUE(int_list.empty());
+  for (int i = 0; i < 200; i++) {
+    int_list.push_back(i / 100);
+  }
+  int_list.unique();
+  EXPECT_EQ(int_list.size(), 2);
+  EXPECT_EQ(int_list.front(), 0);
+  EXPECT_EQ(int_list.back(), 1);
 }
 
 TEST(list, splice_list) {
@@ -388,6 +423,240 @@ TEST(list, reverse) {
   }
 }
 
+TEST(list, arena_alloc) {
+  sgi::Arena arena;
+  sgi::Arena* old_arena = sgi::ArenaAlloc::SetArena(&arena);
+  {
+    sgi::list<Foo, sgi::ArenaAlloc> foo_list;
+    for (int i = 0; i < 1000; i++) {
+      foo_list.push_back(Foo(i));
+    }
+    foo_list.remove(Foo(10));
+    foo_list.pop_front();
+    EXPECT_EQ(foo_list.size(), 998);
+    EXPECT_EQ(foo_list.front().value_, 1);
+    EXPECT_EQ(foo_list.back().value_, 999);
+
+    // erased nodes are not reused
+    size_t allocated_bytes = arena.allocated_bytes();
+    foo_list.push_back(Foo(1000));
+    EXPECT_GT(arena.allocated_bytes(), allocated_bytes);
+  }
+  sgi::ArenaAlloc::Release();
+  EXPECT_EQ(arena.allocated_bytes(), 0);
+  sgi::ArenaAlloc::SetArena(old_arena);
+}
+
+TEST(list, stateful_allocator) {
+  using ArenaList = sgi::list<Foo, sgi::ArenaRef>;
+  static_assert(sizeof(sgi::list<Foo>) == sizeof(void*));
+  static_assert(sizeof(ArenaList) == 2 * sizeof(void*));
+
+  sgi::Arena arena1;
+  sgi::Arena arena2;
+  ArenaList list1{ArenaList::allocator_type(sgi::ArenaRef(&arena1))};
+  ArenaList list2{ArenaList::allocator_type(sgi::ArenaRef(&arena2))};
+  for (int i = 0; i < 100; i++) {
+    list1.push_back(Foo(i));
+  }
+  size_t arena2_bytes = arena2.allocated_bytes();
+
+  // a copy shares the allocator
+  ArenaList list3(list1);
+  EXPECT_EQ(list3.get_allocator(), list1.get_allocator());
+  EXPECT_EQ(list3.size(), 100);
+  EXPECT_EQ(list3.back().value_, 99);
+
+  // copy and move assignment keep the allocator of the target
+  list2 = list1;
+  EXPECT_EQ(list2.get_allocator().policy().arena(), &arena2);
+  EXPECT_GT(arena2.allocated_bytes(), arena2_bytes);
+  EXPECT_EQ(list2.size(), 100);
+  list2.push_back(Foo(100));
+  list2 = list1;
+  EXPECT_EQ(list2.size(), 100);
+  list2 = std::move(list3);
+  EXPECT_EQ(list2.get_allocator().policy().arena(), &arena2);
+  EXPECT_EQ(list2.size(), 100);
+  EXPECT_TRUE(list3.empty());
+
+  // a move from the same arena takes the nodes over
+  auto* first = &list1.front();
+  ArenaList list4(std::move(list1));
+  EXPECT_EQ(&list4.front(), first);
+  EXPECT_TRUE(list1.empty());
+  list1 = std::move(list4);
+  EXPECT_EQ(&list1.front(), first);
+
+  // swap exchanges the allocators
+  swap(list1, list2);
+  EXPECT_EQ(list1.get_allocator().policy().arena(), &arena2);
+  EXPECT_EQ(list2.get_allocator().policy().arena(), &arena1);
+  EXPECT_EQ(&list2.front(), first);
+}
+
+TEST(list, move_assign_move_only) {
+  sgi::list<std::unique_ptr<int>> list1;
+  sgi::list<std::unique_ptr<int>> list2;
+  list1.push_back(std::make_unique<int>(1));
+  list2 = std::move(list1);
+  EXPECT_EQ(*list2.front(), 1);
+  EXPECT_TRUE(list1.empty());
+
+  // moved one by one into the other arena
+  using ArenaList = sgi::list<std::unique_ptr<int>, sgi::ArenaRef>;
+  sgi::Arena arena1;
+  sgi::Arena arena2;
+  ArenaList list3{ArenaList::allocator_type(sgi::ArenaRef(&arena1))};
+  ArenaList list4{ArenaList::allocator_type(sgi::ArenaRef(&arena2))};
+  for (int i = 0; i < 10; i++) {
+    list3.push_back(std::make_unique<int>(i));
+  }
+  list4 = std::move(list3);
+  EXPECT_EQ(list4.get_allocator().policy().arena(), &arena2);
+  EXPECT_EQ(list4.size(), 10);
+  EXPECT_EQ(*list4.back(), 9);
+  EXPECT_TRUE(list3.empty());
+}
+
+// copies throw once copies_left runs out
+struct ThrowingCopy {
+  static int copies_left;
+  static int live;
+
+  explicit ThrowingCopy(int value) : value(value) { live++; }
+  ThrowingCopy(const ThrowingCopy& other) : value(other.value) {
+    if (copies_left-- <= 0) {
+      throw std::runtime_error("copy");
+    }
+    live++;
+  }
+  ~ThrowingCopy() { live--; }
+
+  int value;
+};
+int ThrowingCopy::copies_left = 0;
+int ThrowingCopy::live = 0;
+
+TEST(list, insert_throws) {
+  ThrowingCopy::copies_left = 1000;
+  ThrowingCopy value(1);
+  sgi::list<ThrowingCopy> throwing_list;
+  throwing_list.push_back(value);
+  throwing_list.push_back(value);
+
+  // in the second batch, after the first was linked
+  ThrowingCopy::copies_left = 100;
+  EXPECT_THROW(throwing_list.insert(++throwing_list.begin(), 150, value),
+               std::runtime_error);
+  EXPECT_EQ(throwing_list.size(), 2);
+  EXPECT_EQ(ThrowingCopy::live, 3);
+
+  ThrowingCopy::copies_left = 1000;
+  std::vector<ThrowingCopy> values(150, value);
+  ThrowingCopy::copies_left = 70;
+  EXPECT_THROW(throwing_list.insert(throwing_list.end(), values.begin(),
+                                    values.end()),
+               std::runtime_error);
+  EXPECT_EQ(throwing_list.size(), 2);
+  EXPECT_EQ(ThrowingCopy::live, 153);
+  values.clear();
+
+  // constructors
+  ThrowingCopy::copies_left = 5;
+  EXPECT_THROW(sgi::list<ThrowingCopy>(10, value), std::runtime_error);
+  EXPECT_EQ(ThrowingCopy::live, 3);
+  ThrowingCopy::copies_left = 1;
+  EXPECT_THROW(sgi::list<ThrowingCopy> copy(throwing_list),
+               std::runtime_error);
+  EXPECT_EQ(ThrowingCopy::live, 3);
+  ThrowingCopy::copies_left = 100;
+}
+
+TEST(list, copy_move) {
+  sgi::list<Foo> list1;
+  for (int i = 0; i < 10; i++) {
+    list1.push_back(Foo(i));
+  }
+  sgi::list<Foo> list2(list1);
+  list1.pop_front();
+  EXPECT_EQ(list2.size(), 10);
+  EXPECT_EQ(list2.front().value_, 0);
+
+  sgi::list<Foo> list3(std::move(list2));
+  EXPECT_TRUE(list2.empty());
+  EXPECT_EQ(list3.size(), 10);
+  list2 = list3;
+  list3 = std::move(list1);
+  EXPECT_EQ(list2.size(), 10);
+  EXPECT_EQ(list3.size(), 9);
+  EXPECT_EQ(list3.front().value_, 1);
+}
+
+TEST(list, bulk_insert) {
+  sgi::list<Foo> list1(200, Foo(7));
+  EXPECT_EQ(list1.size(), 200);
+  EXPECT_EQ(list1.back().value_, 7);
+
+  std::vector<int> values(1000);
+  for (int i = 0; i < 1000; i++) {
+    values[i] = i;
+  }
+  sgi::list<Foo> list2(values.begin(), values.end());
+  EXPECT_EQ(list2.size(), 1000);
+  int expected = 0;
+  for (auto it = list2.begin(); it != list2.end(); ++it) {
+    EXPECT_EQ(it->value_, expected++);
+  }
+
+  // insertions in the middle return the first inserted element
+  auto it = list2.insert(++list2.begin(), 3, Foo(-1));
+  EXPECT_EQ(it->value_, -1);
+  EXPECT_EQ((--it)->value_, 0);
+  it = list2.insert(list2.end(), values.begin(), values.begin() + 10);
+  EXPECT_EQ(it->value_, 0);
+  EXPECT_EQ(list2.back().value_, 9);
+  EXPECT_EQ(list2.size(), 1013);
+  it = list2.insert(list2.begin(), values.begin(), values.begin());
+  EXPECT_EQ(it, list2.begin());
+  EXPECT_EQ(list2.size(), 1013);
+
+  list2.clear();
+  EXPECT_TRUE(list2.empty());
+  list2.insert(list2.begin(), 5, Foo(1));
+  EXPECT_EQ(list2.size(), 5);
+
+  // without batches, a range takes no more nodes than it has elements
+  sgi::Arena arena;
+  using ArenaList = sgi::list<Foo, sgi::ArenaRef>;
+  ArenaList list3{ArenaList::allocator_type(sgi::ArenaRef(&arena))};
+  size_t node_bytes = (sizeof(sgi::_list_node<Foo>) + sgi::ARENA_ALIGN - 1) &
+                      ~(sgi::ARENA_ALIGN - 1);
+  size_t allocated_bytes = arena.allocated_bytes();
+  list3.insert(list3.end(), values.begin(), values.begin() + 2);
+  EXPECT_EQ(arena.allocated_bytes() - allocated_bytes, 2 * node_bytes);
+  EXPECT_EQ(list3.size(), 2);
+}
+
+TEST(list, emplace) {
+  sgi::list<std::pair<std::string, std::unique_ptr<int>>> lst;
+  lst.emplace_back("b", std::make_unique<int>(2));
+  lst.emplace_front("a", std::make_unique<int>(1));
+  auto it = lst.emplace(lst.end(), "c", new int(3));
+  EXPECT_EQ(it->first, "c");
+  std::string name(100, 'd');
+  const char* data = name.data();
+  lst.push_back({std::move(name), std::make_unique<int>(4)});
+  EXPECT_EQ(lst.back().first.data(), data);  // moved, not copied
+
+  int i = 1;
+  for (const auto& entry : lst) {
+    EXPECT_EQ(*entry.second, i++);
+  }
+  EXPECT_EQ(lst.size(), 4);
+  EXPECT_EQ(lst.front().first, "a");
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -1,6 +1,11 @@
 #ifndef VECTOR_VECTOR_H_
 #define VECTOR_VECTOR_H_
 
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "algobase.h"
 #include "alloc.h"
 #include "construct.h"
 #include "exception.h"
@@ -8,8 +13,11 @@
 
 namespace sgi {
 
+// The allocator is a private base, so that a stateless one takes no space.
 template <typename T, typename Alloc = sgi::alloc>
-class vector {
+class vector : private sgi::allocator<T, Alloc> {
+  using data_allocator = sgi::allocator<T, Alloc>;
+
  public:
   using value_type = T;
   using pointer = value_type*;
@@ -17,12 +25,26 @@ class vector {
   using iterator = value_type*;
   using size_type = std::size_t;
   using difference_type = std::ptrdiff_t;
+  using allocator_type = data_allocator;
 
   explicit vector() = default;
-  explicit vector(size_type n) : vector(n, T()){};
-  explicit vector(size_type n, const T& value);
+  explicit vector(const allocator_type& alloc) : data_allocator(alloc) {}
+  explicit vector(size_type n, const allocator_type& alloc = allocator_type())
+      : vector(n, T(), alloc){};
+  explicit vector(size_type n, const T& value,
+                  const allocator_type& alloc = allocator_type());
+  vector(const vector& other);
+  vector(vector&& other) noexcept;
   ~vector() { destroy_all(); }
 
+  // Whether the allocator follows the elements is decided by the
+  // propagate_on_container_* members of the allocator, see alloc.h.
+  vector& operator=(const vector& other);
+  vector& operator=(vector&& other);
+  void swap(vector& other) noexcept;
+
+  allocator_type get_allocator() const { return *this; }
+
   iterator begin() const { return start_; }
   iterator end() const { return finish_; }
   bool empty() const { return start_ == finish_; }
@@ -36,23 +58,56 @@ class vector {
   reference front() { return *start_; }
   reference back() { return *(finish_ - 1); }
 
-  void push_back(const T& value);
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
   void pop_back();
 
-  iterator insert(iterator position, const T& value);
+  // Construct the new element in place from args. Growing the storage moves
+  // the elements when their move constructor cannot throw, and copies them
+  // otherwise.
+  template <typename... Args>
+  reference emplace_back(Args&&... args);
+  template <typename... Args>
+  iterator emplace(iterator position, Args&&... args) {
+    return insert_aux(position, std::forward<Args>(args)...);
+  }
+
+  iterator insert(iterator position, const T& value) {
+    return insert_aux(position, value);
+  }
+  iterator insert(iterator position, T&& value) {
+    return insert_aux(position, std::move(value));
+  }
   iterator insert(iterator position, size_type n, const T& value);
   iterator erase(iterator position) { return erase(position, position + 1); }
   iterator erase(iterator first, iterator last);
   void resize(size_type n, const T& value);
   void resize(size_type n) { resize(n, value_type()); }
+  // Grows the storage to hold at least n elements, so that as many
+  // push_back calls do not reallocate. Never shrinks it.
+  void reserve(size_type n);
 
   void clear();
 
  private:
-  using data_allocator = sgi::allocator<value_type, Alloc>;
-
+  data_allocator& allocator() { return *this; }
+  const data_allocator& allocator() const { return *this; }
+  // Trivially relocatable elements are moved by copying their bytes, see
+  // uninitialized.h, so they also move together with their storage in
+  // data_allocator::reallocate, which grows large blocks without copying.
+  static constexpr bool relocatable = sgi::is_trivially_relocatable_v<T>;
+  static constexpr bool use_reallocate =
+      relocatable && data_allocator::can_reallocate;
+  void reallocate_storage(size_type new_size);
+
+  void copy_from(const vector& other);
+  void move_from(vector& other);
+  void steal(vector& other);
   void destroy_all();
-  iterator insert_aux(iterator position, const T& value);
+  template <typename... Args>
+  iterator insert_aux(iterator position, Args&&... args);
+  iterator relocate_around(iterator position, iterator new_start,
+                           size_type new_size, size_type n);
 
   iterator start_ = nullptr;
   iterator finish_ = nullptr;
@@ -60,7 +115,9 @@ class vector {
 };
 
 template <typename T, typename Alloc>
-inline vector<T, Alloc>::vector(size_type n, const T& value) {
+inline vector<T, Alloc>::vector(size_type n, const T& value,
+                                const allocator_type& alloc)
+    : data_allocator(alloc) {
   if (n < 0) {
     throw sgi::invalid_alloc("argument is invalid");
   }
@@ -69,21 +126,94 @@ inline vector<T, Alloc>::vector(size_type n, const T& value) {
     size_type size = 2 * n;
     start_ = static_cast<iterator>(data_allocator::allocate(size));
     end_of_storage_ = start_ + size;
-    for (size_type i = 0; i < n; i++) {
-      sgi::construct(start_ + i, value);
+    try {
+      // copies of other types may not be safe to make from several threads
+      if constexpr (std::is_trivially_copyable_v<T>) {
+        finish_ = sgi::parallel_uninitialized_fill_n(start_, n, value);
+      } else {
+        finish_ = sgi::uninitialized_fill_n(start_, n, value);
+      }
+    } catch (...) {
+      data_allocator::deallocate(start_, size);
+      start_ = end_of_storage_ = nullptr;
+      throw;
     }
-    finish_ = start_ + n;
   }
 }
 
 template <typename T, typename Alloc>
-inline void vector<T, Alloc>::push_back(const T& value) {
-  if (finish_ == end_of_storage_) {
-    insert_aux(end(), value);
+inline vector<T, Alloc>::vector(const vector& other)
+    : data_allocator(other.get_allocator()) {
+  copy_from(other);
+}
+
+template <typename T, typename Alloc>
+inline vector<T, Alloc>::vector(vector&& other) noexcept
+    : data_allocator(std::move(other.allocator())) {
+  steal(other);
+}
+
+template <typename T, typename Alloc>
+inline vector<T, Alloc>& vector<T, Alloc>::operator=(const vector& other) {
+  if (this == &other) {
+    return *this;
+  }
+
+  destroy_all();
+  if constexpr (data_allocator::propagate_on_container_copy_assignment::value) {
+    allocator() = other.allocator();
+  }
+  copy_from(other);
+  return *this;
+}
+
+template <typename T, typename Alloc>
+inline vector<T, Alloc>& vector<T, Alloc>::operator=(vector&& other) {
+  if (this == &other) {
+    return *this;
+  }
+
+  destroy_all();
+  if constexpr (data_allocator::propagate_on_container_move_assignment::value) {
+    allocator() = std::move(other.allocator());
+    steal(other);
+  } else if constexpr (data_allocator::is_always_equal::value) {
+    steal(other);
   } else {
-    *finish_ = value;
-    ++finish_;
+    // storage of another heap cannot be taken over, the elements are moved
+    if (allocator() == other.allocator()) {
+      steal(other);
+    } else {
+      move_from(other);
+      other.destroy_all();
+    }
+  }
+  return *this;
+}
+
+// Swapping vectors with unequal allocators that do not propagate on swap is
+// undefined, as with the standard containers.
+template <typename T, typename Alloc>
+inline void vector<T, Alloc>::swap(vector& other) noexcept {
+  if constexpr (data_allocator::propagate_on_container_swap::value) {
+    std::swap(allocator(), other.allocator());
+  } else {
+    assert(allocator() == other.allocator());
   }
+  std::swap(start_, other.start_);
+  std::swap(finish_, other.finish_);
+  std::swap(end_of_storage_, other.end_of_storage_);
+}
+
+template <typename T, typename Alloc>
+template <typename... Args>
+inline typename vector<T, Alloc>::reference vector<T, Alloc>::emplace_back(
+    Args&&... args) {
+  if (finish_ == end_of_storage_) {
+    return *insert_aux(end(), std::forward<Args>(args)...);
+  }
+  sgi::construct(finish_, std::forward<Args>(args)...);
+  return *finish_++;
 }
 
 // An error will result when pop_back is called on an empty vector.
@@ -94,12 +224,6 @@ inline void vector<T, Alloc>::pop_back() {
   --finish_;
 }
 
-template <typename T, typename Alloc>
-inline typename vector<T, Alloc>::iterator vector<T, Alloc>::insert(
-    iterator position, const T& value) {
-  return insert_aux(position, value);
-}
-
 template <typename T, typename Alloc>
 inline typename vector<T, Alloc>::iterator vector<T, Alloc>::insert(
     iterator position, size_type n, const T& value) {
@@ -108,28 +232,60 @@ inline typename vector<T, Alloc>::iterator vector<T, Alloc>::insert(
   // trigger expansion
   if (remaining_size < n) {
     size_type new_size = size() + std::max(size(), n);
-    iterator new_start_ =
+    if constexpr (use_reallocate) {
+      T copy = value;  // value may be an element of this vector
+      size_type offset = static_cast<size_type>(position - start_);
+      reallocate_storage(new_size);
+      return insert(start_ + offset, n, copy);
+    }
+
+    iterator new_start =
         static_cast<iterator>(data_allocator::allocate(new_size));
 
-    iterator pos = sgi::uninitialized_copy(start_, position, new_start_);
-    sgi::uninitialized_fill(pos, pos + n, value);
-    finish_ = sgi::uninitialized_copy(position, finish_, pos + n);
-    start_ = new_start_;
+    // fill first, value may be an element of this vector
+    iterator pos = new_start + (position - start_);
+    try {
+      sgi::uninitialized_fill(pos, pos + n, value);
+    } catch (...) {
+      data_allocator::deallocate(new_start, new_size);
+      throw;
+    }
+    iterator new_finish = relocate_around(position, new_start, new_size, n);
+
+    destroy_all();
+    start_ = new_start;
+    finish_ = new_finish;
     end_of_storage_ = start_ + new_size;
     return pos;
   }
 
   // no expansion
+  if constexpr (relocatable) {
+    const T* source = &value;
+    if (source >= position && source < finish_) {
+      source += n;  // value is an element, shifted with the others
+    }
+    sgi::uninitialized_relocate(position, finish_, position + n);
+    try {
+      sgi::uninitialized_fill(position, position + n, *source);
+    } catch (...) {
+      sgi::uninitialized_relocate(position + n, finish_ + n, position);
+      throw;
+    }
+    finish_ += n;
+    return position;
+  }
+
   size_type move_size = static_cast<size_type>(finish_ - position);
   if (n >= move_size) {
     sgi::uninitialized_copy(position, finish_, position + n);
-    uninitialized_fill(finish_, position + n, value);
-    std::fill(position, finish_, value);  // TODO(leisy): use sgi::fill
+    sgi::uninitialized_fill(finish_, position + n, value);
+    sgi::fill(position, finish_, value);
   } else {
     size_type left_size = move_size - n;
-    uninitialized_copy(position + left_size, finish_, finish_);
-    std::copy_backward(position, position + left_size, finish_);
-    std::fill(position, position + n, value);
+    sgi::uninitialized_copy(position + left_size, finish_, finish_);
+    sgi::copy_backward(position, position + left_size, finish_);
+    sgi::fill(position, position + n, value);
   }
   finish_ += n;
   return position;
@@ -144,9 +300,14 @@ inline void vector<T, Alloc>::clear() {
 template <typename T, typename Alloc>
 inline typename vector<T, Alloc>::iterator vector<T, Alloc>::erase(
     iterator first, iterator last) {
-  sgi::destroy(first, last);
-  std::copy(last, finish_, first);  // TODO(leisy): use sgi::copy
-  finish_ -= static_cast<size_type>(last - first);
+  if constexpr (relocatable) {
+    sgi::destroy(first, last);
+    finish_ = sgi::uninitialized_relocate(last, finish_, first);
+  } else {
+    iterator new_finish = sgi::move(last, finish_, first);
+    sgi::destroy(new_finish, finish_);
+    finish_ = new_finish;
+  }
   return first;
 }
 
@@ -161,32 +322,161 @@ inline void vector<T, Alloc>::resize(size_type n, const T& value) {
 }
 
 template <typename T, typename Alloc>
+inline void vector<T, Alloc>::reserve(size_type n) {
+  if (n <= capacity()) {
+    return;
+  }
+  if constexpr (use_reallocate) {
+    reallocate_storage(n);
+    return;
+  }
+  iterator new_start = static_cast<iterator>(data_allocator::allocate(n));
+  iterator new_finish = relocate_around(finish_, new_start, n, 0);
+  destroy_all();
+  start_ = new_start;
+  finish_ = new_finish;
+  end_of_storage_ = start_ + n;
+}
+
+template <typename T, typename Alloc>
+template <typename... Args>
 inline typename vector<T, Alloc>::iterator vector<T, Alloc>::insert_aux(
-    iterator position, const T& value) {
+    iterator position, Args&&... args) {
   if (finish_ != end_of_storage_) {
-    // TODO(leisy): use sgi::copy_backward
-    std::copy_backward(position, finish_, finish_ + 1);
+    if (position == finish_) {
+      sgi::construct(finish_, std::forward<Args>(args)...);
+      ++finish_;
+      return position;
+    }
+    if constexpr (relocatable) {
+      // built at the end before anything moves, as args may refer to an
+      // element, then its bytes are rotated into place
+      sgi::construct(finish_, std::forward<Args>(args)...);
+      alignas(T) unsigned char bytes[sizeof(T)];
+      memcpy(bytes, static_cast<void*>(finish_), sizeof(T));
+      sgi::uninitialized_relocate(position, finish_, position + 1);
+      memcpy(static_cast<void*>(position), bytes, sizeof(T));
+      ++finish_;
+      return position;
+    }
+    T value(std::forward<Args>(args)...);  // args may refer to an element
+    sgi::construct(finish_, std::move(*(finish_ - 1)));
     ++finish_;
-    *position = value;
+    sgi::move_backward(position, finish_ - 2, finish_ - 1);
+    *position = std::move(value);
     return position;
   }
 
   // expansion
   size_type new_size = (size() == 0) ? 1 : 2 * size();
-  iterator new_start_ =
+  if constexpr (use_reallocate) {
+    T copy(std::forward<Args>(args)...);  // args may refer to an element
+    size_type offset = static_cast<size_type>(position - start_);
+    reallocate_storage(new_size);
+    return insert_aux(start_ + offset, std::move(copy));
+  }
+
+  iterator new_start =
       static_cast<iterator>(data_allocator::allocate(new_size));
-  iterator new_pos = sgi::uninitialized_copy(start_, position, new_start_);
-  *new_pos = value;
-  iterator new_finish = sgi::uninitialized_copy(position, finish_, new_pos + 1);
+  iterator new_pos = new_start + (position - start_);
+  try {
+    sgi::construct(new_pos, std::forward<Args>(args)...);
+  } catch (...) {
+    data_allocator::deallocate(new_start, new_size);
+    throw;
+  }
+  iterator new_finish = relocate_around(position, new_start, new_size, 1);
 
   destroy_all();
-  start_ = new_start_;
+  start_ = new_start;
   finish_ = new_finish;
   end_of_storage_ = start_ + new_size;
-
   return new_pos;
 }
 
+// Moves, or copies if moving may throw, the elements to new storage of
+// new_size, around the n new elements already constructed where position
+// lands. Returns the new finish. If it throws, the new storage is freed and
+// this vector is left intact. Trivially relocatable elements are copied
+// bytewise instead, and no longer live in the old storage afterwards.
+template <typename T, typename Alloc>
+inline typename vector<T, Alloc>::iterator vector<T, Alloc>::relocate_around(
+    iterator position, iterator new_start, size_type new_size, size_type n) {
+  iterator gap = new_start + (position - start_);
+  if constexpr (relocatable) {
+    sgi::uninitialized_relocate(start_, position, new_start);
+    iterator new_finish =
+        sgi::uninitialized_relocate(position, finish_, gap + n);
+    finish_ = start_;  // so that destroy_all only frees the storage
+    return new_finish;
+  }
+  iterator prefix_end = new_start;
+  try {
+    prefix_end =
+        sgi::uninitialized_move_if_noexcept(start_, position, new_start);
+    return sgi::uninitialized_move_if_noexcept(position, finish_, gap + n);
+  } catch (...) {
+    sgi::destroy(new_start, prefix_end);
+    sgi::destroy(gap, gap + n);
+    data_allocator::deallocate(new_start, new_size);
+    throw;
+  }
+}
+
+template <typename T, typename Alloc>
+inline void vector<T, Alloc>::reallocate_storage(size_type new_size) {
+  size_type old_size = size();
+  start_ = data_allocator::reallocate(start_, capacity(), new_size);
+  finish_ = start_ + old_size;
+  end_of_storage_ = start_ + new_size;
+}
+
+// Requires an empty vector without storage, which it stays if a copy throws.
+template <typename T, typename Alloc>
+inline void vector<T, Alloc>::copy_from(const vector& other) {
+  if (other.empty()) {
+    return;
+  }
+  size_type n = other.size();
+  iterator new_start = data_allocator::allocate(n);
+  try {
+    sgi::uninitialized_copy(other.start_, other.finish_, new_start);
+  } catch (...) {
+    data_allocator::deallocate(new_start, n);
+    throw;
+  }
+  start_ = new_start;
+  finish_ = end_of_storage_ = new_start + n;
+}
+
+// as copy_from
+template <typename T, typename Alloc>
+inline void vector<T, Alloc>::move_from(vector& other) {
+  if (other.empty()) {
+    return;
+  }
+  size_type n = other.size();
+  iterator new_start = data_allocator::allocate(n);
+  try {
+    sgi::uninitialized_move_if_noexcept(other.start_, other.finish_,
+                                        new_start);
+  } catch (...) {
+    data_allocator::deallocate(new_start, n);
+    throw;
+  }
+  start_ = new_start;
+  finish_ = end_of_storage_ = new_start + n;
+}
+
+// requires an empty vector without storage
+template <typename T, typename Alloc>
+inline void vector<T, Alloc>::steal(vector& other) {
+  start_ = other.start_;
+  finish_ = other.finish_;
+  end_of_storage_ = other.end_of_storage_;
+  other.start_ = other.finish_ = other.end_of_storage_ = nullptr;
+}
+
 template <typename T, typename Alloc>
 inline void vector<T, Alloc>::destroy_all() {
   sgi::destroy(start_, finish_);
@@ -194,6 +484,11 @@ inline void vector<T, Alloc>::destroy_all() {
   start_ = finish_ = end_of_storage_ = nullptr;
 }
 
+template <typename T, typename Alloc>
+inline void swap(vector<T, Alloc>& lhs, vector<T, Alloc>& rhs) noexcept {
+  lhs.swap(rhs);
+}
+
 }  // namespace sgi
 
 #endif  // VECTOR_VECTOR_H_
\ No newline at end of file
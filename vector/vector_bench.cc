@@ -0,0 +1,92 @@
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "vector.h"
+
+// not trivially copyable, so growth allocates a new buffer and copies
+struct Int {
+  Int(int v = 0) : value(v) {}
+  Int(const Int& other) : value(other.value) {}
+  Int& operator=(const Int& other) {
+    value = other.value;
+    return *this;
+  }
+  int value;
+};
+
+// Grows a vector to range(0) elements one push_back at a time. For ints
+// sgi::vector grows through reallocate, which maps large buffers on their own
+// and extends them with mremap instead of copying.
+template <typename Vector>
+static void BM_PushBack(benchmark::State& state) {
+  size_t n = state.range(0);
+  for (auto _ : state) {
+    Vector vec;
+    for (size_t i = 0; i < n; i++) {
+      vec.push_back(static_cast<int>(i));
+    }
+    benchmark::DoNotOptimize(&*vec.begin());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetBytesProcessed(state.iterations() * n * sizeof(int));
+}
+BENCHMARK_TEMPLATE(BM_PushBack, sgi::vector<int>)
+    ->RangeMultiplier(16)
+    ->Range(1 << 16, 1 << 28)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PushBack, sgi::vector<Int>)
+    ->RangeMultiplier(16)
+    ->Range(1 << 16, 1 << 28)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PushBack, std::vector<int>)
+    ->RangeMultiplier(16)
+    ->Range(1 << 16, 1 << 28)
+    ->Unit(benchmark::kMillisecond);
+
+// 1e9 ints, 4 GB: with mremap the old and the new buffer never coexist, so
+// the peak stays at the final capacity instead of one and a half times it
+BENCHMARK_TEMPLATE(BM_PushBack, sgi::vector<int>)
+    ->Arg(1000000000)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+// a unique_ptr that sgi::vector does not know to be trivially relocatable, so
+// growth, insert and erase move and destroy it one element at a time
+struct Ptr {
+  Ptr(std::unique_ptr<int> p) : p(std::move(p)) {}
+  std::unique_ptr<int> p;
+};
+
+// Grows a vector of range(0) smart pointers, then inserts and erases at its
+// front, which shifts every element.
+template <typename Vector>
+static void BM_SmartPointers(benchmark::State& state) {
+  size_t n = state.range(0);
+  for (auto _ : state) {
+    Vector vec;
+    for (size_t i = 0; i < n; i++) {
+      vec.push_back(std::make_unique<int>(i));
+    }
+    for (int i = 0; i < 16; i++) {
+      vec.insert(vec.begin(), std::make_unique<int>(i));
+      vec.erase(vec.begin() + 1);
+    }
+    benchmark::DoNotOptimize(&*vec.begin());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(BM_SmartPointers, sgi::vector<std::unique_ptr<int>>)
+    ->RangeMultiplier(16)
+    ->Range(1 << 12, 1 << 20)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_SmartPointers, sgi::vector<Ptr>)
+    ->RangeMultiplier(16)
+    ->Range(1 << 12, 1 << 20)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_SmartPointers, std::vector<std::unique_ptr<int>>)
+    ->RangeMultiplier(16)
+    ->Range(1 << 12, 1 << 20)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -1,5 +1,12 @@
 #include "vector.h"
 
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "arena_alloc.h"
 #include "gtest/gtest.h"
 
 inline constexpr int DEFAULT_VALUE = 0;
@@ -231,6 +238,447 @@ TEST(vector, resize) {
   }
 }
 
+TEST(vector, reserve) {
+  sgi::vector<std::string> vec;
+  vec.reserve(100);
+  EXPECT_EQ(vec.capacity(), 100);
+  EXPECT_TRUE(vec.empty());
+  vec.push_back("first");
+  std::string* start = vec.begin();
+  for (int i = 1; i < 100; i++) {
+    vec.push_back(std::to_string(i));
+  }
+  EXPECT_EQ(vec.begin(), start);  // no reallocation
+
+  vec.reserve(10);  // never shrinks
+  EXPECT_EQ(vec.capacity(), 100);
+  vec.reserve(1000);
+  EXPECT_EQ(vec.capacity(), 1000);
+  EXPECT_EQ(vec.size(), 100);
+  EXPECT_EQ(vec[0], "first");
+  EXPECT_EQ(vec[99], "99");
+
+  sgi::vector<int> ints;
+  ints.reserve(50);
+  EXPECT_EQ(ints.capacity(), 50);
+  ints.push_back(7);
+  ints.reserve(5000);
+  EXPECT_EQ(ints.capacity(), 5000);
+  EXPECT_EQ(ints[0], 7);
+}
+
+TEST(vector, arena_alloc) {
+  sgi::Arena arena;
+  sgi::Arena* old_arena = sgi::ArenaAlloc::SetArena(&arena);
+  {
+    sgi::vector<Foo, sgi::ArenaAlloc> vec;
+    for (int i = 0; i < 1000; i++) {
+      vec.push_back(Foo(i));
+    }
+    EXPECT_EQ(vec.size(), 1000);
+    for (std::size_t i = 0; i < vec.size(); i++) {
+      EXPECT_EQ(vec[i].value_, i);
+    }
+    EXPECT_GE(arena.allocated_bytes(), 1000 * sizeof(Foo));
+  }
+  sgi::ArenaAlloc::Release();
+  EXPECT_EQ(arena.allocated_bytes(), 0);
+  sgi::ArenaAlloc::SetArena(old_arena);
+}
+
+// a policy whose containers take it along on copy and move assignment too
+struct PropagatingArenaRef : sgi::ArenaRef {
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using sgi::ArenaRef::ArenaRef;
+};
+
+TEST(vector, stateful_allocator) {
+  using ArenaVector = sgi::vector<int, sgi::ArenaRef>;
+  static_assert(sizeof(sgi::vector<int>) == 3 * sizeof(int*));
+  static_assert(sizeof(ArenaVector) == 4 * sizeof(int*));
+
+  sgi::Arena arena1;
+  sgi::Arena arena2;
+  ArenaVector vec1{ArenaVector::allocator_type(sgi::ArenaRef(&arena1))};
+  ArenaVector vec2{ArenaVector::allocator_type(sgi::ArenaRef(&arena2))};
+  for (int i = 0; i < 100; i++) {
+    vec1.push_back(i);
+  }
+  EXPECT_GT(arena1.allocated_bytes(), 0);
+  EXPECT_EQ(arena2.allocated_bytes(), 0);
+
+  // a copy shares the allocator
+  ArenaVector vec3(vec1);
+  EXPECT_EQ(vec3.get_allocator(), vec1.get_allocator());
+  EXPECT_EQ(vec3.size(), 100);
+  EXPECT_EQ(vec3[99], 99);
+
+  // copy and move assignment keep the allocator of the target
+  vec2 = vec1;
+  EXPECT_EQ(vec2.get_allocator().policy().arena(), &arena2);
+  EXPECT_GE(arena2.allocated_bytes(), 100 * sizeof(int));
+  EXPECT_EQ(vec2[50], 50);
+  vec2 = std::move(vec3);
+  EXPECT_EQ(vec2.get_allocator().policy().arena(), &arena2);
+  EXPECT_EQ(vec2.size(), 100);
+  EXPECT_TRUE(vec3.empty());
+
+  // a move from the same arena takes the storage over
+  int* data = vec1.begin();
+  ArenaVector vec4(std::move(vec1));
+  EXPECT_EQ(vec4.begin(), data);
+  EXPECT_TRUE(vec1.empty());
+  vec1 = std::move(vec4);
+  EXPECT_EQ(vec1.begin(), data);
+
+  // swap exchanges the allocators
+  swap(vec1, vec2);
+  EXPECT_EQ(vec1.get_allocator().policy().arena(), &arena2);
+  EXPECT_EQ(vec2.get_allocator().policy().arena(), &arena1);
+  EXPECT_EQ(vec2.begin(), data);
+}
+
+TEST(vector, move_assign_move_only) {
+  sgi::vector<std::unique_ptr<int>> vec1;
+  sgi::vector<std::unique_ptr<int>> vec2;
+  vec1.push_back(std::make_unique<int>(1));
+  vec2 = std::move(vec1);
+  EXPECT_EQ(*vec2[0], 1);
+  EXPECT_TRUE(vec1.empty());
+
+  // moved one by one into the other arena
+  using ArenaVector = sgi::vector<std::unique_ptr<int>, sgi::ArenaRef>;
+  sgi::Arena arena1;
+  sgi::Arena arena2;
+  ArenaVector vec3{ArenaVector::allocator_type(sgi::ArenaRef(&arena1))};
+  ArenaVector vec4{ArenaVector::allocator_type(sgi::ArenaRef(&arena2))};
+  for (int i = 0; i < 10; i++) {
+    vec3.push_back(std::make_unique<int>(i));
+  }
+  vec4 = std::move(vec3);
+  EXPECT_EQ(vec4.get_allocator().policy().arena(), &arena2);
+  EXPECT_EQ(vec4.size(), 10);
+  EXPECT_EQ(*vec4[9], 9);
+  EXPECT_TRUE(vec3.empty());
+}
+
+TEST(vector, propagating_allocator) {
+  using ArenaVector = sgi::vector<int, PropagatingArenaRef>;
+  sgi::Arena arena1;
+  sgi::Arena arena2;
+  ArenaVector vec1{ArenaVector::allocator_type(PropagatingArenaRef(&arena1))};
+  ArenaVector vec2{ArenaVector::allocator_type(PropagatingArenaRef(&arena2))};
+  vec1.push_back(1);
+  vec2 = vec1;
+  EXPECT_EQ(vec2.get_allocator().policy().arena(), &arena1);
+
+  ArenaVector vec3{ArenaVector::allocator_type(PropagatingArenaRef(&arena2))};
+  int* data = vec1.begin();
+  vec3 = std::move(vec1);
+  EXPECT_EQ(vec3.get_allocator().policy().arena(), &arena1);
+  EXPECT_EQ(vec3.begin(), data);
+}
+
+struct alignas(64) Counter {
+  long value = 0;
+};
+
+TEST(vector, aligned) {
+  sgi::vector<Counter> counters(10);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(counters.begin()) % 64, 0);
+
+  sgi::vector<int, sgi::AlignedAlloc<>> ints;
+  for (int i = 0; i < 100; i++) {
+    ints.push_back(i);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ints.begin()) % 64, 0);
+  }
+}
+
+TEST(vector, reallocate) {
+  // ints grow through data_allocator::reallocate, past the mmap threshold
+  constexpr int kCount = 1 << 20;
+  sgi::vector<int> vec;
+  for (int i = 0; i < kCount; i++) {
+    vec.push_back(i);
+  }
+  EXPECT_EQ(vec.size(), kCount);
+  for (int i = 0; i < kCount; i++) {
+    ASSERT_EQ(vec[i], i);
+  }
+
+  // the inserted value is an element of the full vector
+  while (vec.size() < vec.capacity()) {
+    vec.push_back(0);
+  }
+  vec.insert(vec.begin() + 1, vec[0] + 7);
+  EXPECT_EQ(vec[1], 7);
+  vec.insert(vec.begin(), vec.capacity(), vec[2]);
+  EXPECT_EQ(vec[0], 1);
+  EXPECT_EQ(vec.back(), kCount - 1);
+}
+
+// counts its copies and moves
+struct Tracked {
+  static int copies;
+  static int moves;
+
+  Tracked(std::string name, int id) : name(std::move(name)), id(id) {}
+  Tracked(const Tracked& other) : name(other.name), id(other.id) { copies++; }
+  Tracked(Tracked&& other) noexcept
+      : name(std::move(other.name)), id(other.id) {
+    moves++;
+  }
+  Tracked& operator=(const Tracked& other) = default;
+  Tracked& operator=(Tracked&& other) = default;
+
+  std::string name;
+  int id;
+};
+int Tracked::copies = 0;
+int Tracked::moves = 0;
+
+TEST(vector, emplace) {
+  sgi::vector<Tracked> vec;
+  Tracked::copies = Tracked::moves = 0;
+  for (int i = 0; i < 100; i++) {
+    Tracked& t = vec.emplace_back(std::string(50, 'a' + i % 26), i);
+    EXPECT_EQ(t.id, i);
+  }
+  // built in place, and moved rather than copied when the storage grows
+  EXPECT_EQ(Tracked::copies, 0);
+  EXPECT_GT(Tracked::moves, 0);
+
+  auto it = vec.emplace(vec.begin() + 10, "inserted", -1);
+  EXPECT_EQ(it, vec.begin() + 10);
+  EXPECT_EQ(vec[10].name, "inserted");
+  EXPECT_EQ(vec[11].id, 10);
+  vec.push_back(Tracked("moved", 1000));
+  EXPECT_EQ(Tracked::copies, 0);
+  EXPECT_EQ(vec.size(), 102);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(vec[i < 10 ? i : i + 1].name, std::string(50, 'a' + i % 26));
+  }
+
+  // the new element may come from an element of the vector
+  while (vec.size() < vec.capacity()) {
+    vec.emplace_back("filler", 0);
+  }
+  vec.emplace_back(vec[0]);
+  EXPECT_EQ(vec.back().name, vec[0].name);
+  vec.emplace(vec.begin(), vec[1].name, 5);
+  EXPECT_EQ(vec[0].name, vec[2].name);
+
+  sgi::vector<std::unique_ptr<int>> ptrs;
+  for (int i = 0; i < 100; i++) {
+    ptrs.push_back(std::make_unique<int>(i));
+  }
+  ptrs.emplace(ptrs.begin(), new int(-1));
+  EXPECT_EQ(*ptrs[0], -1);
+  EXPECT_EQ(*ptrs[100], 99);
+}
+
+// moves may throw, so growth copies, and a copy throws on request
+struct Fragile {
+  static bool fail;
+
+  explicit Fragile(int value) : value(value) {}
+  Fragile(const Fragile& other) : value(other.value) {
+    if (fail) {
+      throw std::runtime_error("copy");
+    }
+  }
+  Fragile(Fragile&& other) : value(other.value) { other.value = -1; }
+  Fragile& operator=(const Fragile& other) = default;
+  Fragile& operator=(Fragile&& other) = default;
+
+  int value;
+};
+bool Fragile::fail = false;
+
+TEST(vector, grow_strong_guarantee) {
+  sgi::vector<Fragile> vec;
+  for (int i = 0; i < 8; i++) {
+    vec.emplace_back(i);
+  }
+  ASSERT_EQ(vec.size(), vec.capacity());
+
+  Fragile::fail = true;
+  EXPECT_THROW(vec.emplace_back(8), std::runtime_error);
+  Fragile::fail = false;
+  EXPECT_EQ(vec.size(), 8);
+  for (int i = 0; i < 8; i++) {
+    EXPECT_EQ(vec[i].value, i);
+  }
+}
+
+// copies throw once copies_left runs out
+struct Brittle {
+  static int copies_left;
+  static int live;
+
+  explicit Brittle(int value) : value(value) { live++; }
+  Brittle(const Brittle& other) : value(other.value) {
+    if (copies_left-- <= 0) {
+      throw std::runtime_error("copy");
+    }
+    live++;
+  }
+  Brittle& operator=(const Brittle& other) = default;
+  ~Brittle() { live--; }
+
+  int value;
+};
+int Brittle::copies_left = 0;
+int Brittle::live = 0;
+
+TEST(vector, copy_throws) {
+  Brittle::copies_left = 100;
+  sgi::vector<Brittle> vec;
+  for (int i = 0; i < 20; i++) {
+    vec.emplace_back(i);
+  }
+  ASSERT_EQ(Brittle::live, 20);
+
+  Brittle::copies_left = 10;
+  EXPECT_THROW(sgi::vector<Brittle> copy(vec), std::runtime_error);
+  EXPECT_EQ(Brittle::live, 20);
+
+  // the target is left empty, not half built
+  sgi::vector<Brittle> other;
+  other.emplace_back(-1);
+  Brittle::copies_left = 10;
+  EXPECT_THROW(other = vec, std::runtime_error);
+  EXPECT_EQ(Brittle::live, 20);
+  EXPECT_TRUE(other.empty());
+  EXPECT_EQ(other.size(), 0);
+  EXPECT_EQ(other.capacity(), 0);
+
+  Brittle::copies_left = 100;
+  other = vec;
+  EXPECT_EQ(other.size(), 20);
+  EXPECT_EQ(other[19].value, 19);
+
+  // moved across arenas, through the copy constructor that may throw
+  using ArenaVector = sgi::vector<Brittle, sgi::ArenaRef>;
+  sgi::Arena arena1;
+  sgi::Arena arena2;
+  ArenaVector vec1{ArenaVector::allocator_type(sgi::ArenaRef(&arena1))};
+  ArenaVector vec2{ArenaVector::allocator_type(sgi::ArenaRef(&arena2))};
+  for (int i = 0; i < 20; i++) {
+    vec1.emplace_back(i);
+  }
+  Brittle::copies_left = 10;
+  EXPECT_THROW(vec2 = std::move(vec1), std::runtime_error);
+  EXPECT_TRUE(vec2.empty());
+  EXPECT_EQ(vec1.size(), 20);
+  EXPECT_EQ(Brittle::live, 60);
+}
+
+// declared relocatable below, over-aligned so that growth cannot go through
+// reallocate and relocates the elements itself
+struct alignas(32) Handle {
+  static int live;
+
+  explicit Handle(int id) : id(new int(id)) { live++; }
+  Handle(Handle&& other) noexcept : id(other.id) {
+    other.id = nullptr;
+    live++;
+  }
+  Handle& operator=(Handle&& other) noexcept {
+    std::swap(id, other.id);
+    return *this;
+  }
+  ~Handle() {
+    delete id;
+    live--;
+  }
+
+  int* id;
+};
+int Handle::live = 0;
+
+template <>
+struct sgi::is_trivially_relocatable<Handle> : std::true_type {};
+
+TEST(vector, relocatable) {
+  {
+    sgi::vector<Handle> vec;
+    for (int i = 0; i < 100; i++) {
+      vec.emplace_back(i);
+    }
+    // relocated, so only the 100 elements were ever constructed
+    EXPECT_EQ(Handle::live, 100);
+    vec.emplace(vec.begin(), -1);
+    vec.erase(vec.begin() + 10, vec.begin() + 20);
+    vec.emplace(vec.begin() + 50, vec.size());
+    EXPECT_EQ(Handle::live, 92);
+    ASSERT_EQ(vec.size(), 92);
+    EXPECT_EQ(*vec[0].id, -1);
+    EXPECT_EQ(*vec[9].id, 8);
+    EXPECT_EQ(*vec[10].id, 19);
+    EXPECT_EQ(*vec[50].id, 91);
+    EXPECT_EQ(*vec[51].id, 59);
+    EXPECT_EQ(*vec.back().id, 99);
+  }
+  EXPECT_EQ(Handle::live, 0);
+
+  sgi::vector<std::unique_ptr<int>> ptrs;
+  for (int i = 0; i < 1000; i++) {
+    ptrs.push_back(std::make_unique<int>(i));
+  }
+  ptrs.erase(ptrs.begin(), ptrs.begin() + 500);
+  ptrs.insert(ptrs.begin() + 100, std::make_unique<int>(-1));
+  EXPECT_EQ(*ptrs[0], 500);
+  EXPECT_EQ(*ptrs[100], -1);
+  EXPECT_EQ(*ptrs[101], 600);
+  EXPECT_EQ(*ptrs.back(), 999);
+
+  // the filled value may be an element, shifted before it is copied
+  sgi::vector<std::shared_ptr<int>> shared;
+  for (int i = 0; i < 10; i++) {
+    shared.push_back(std::make_shared<int>(i));
+  }
+  shared.insert(shared.begin() + 2, 3, shared[5]);
+  EXPECT_EQ(shared.size(), 13);
+  for (int i = 2; i < 5; i++) {
+    EXPECT_EQ(*shared[i], 5);
+  }
+  EXPECT_EQ(*shared[8], 5);
+  EXPECT_EQ(shared[8].use_count(), 4);
+  EXPECT_EQ(*shared.back(), 9);
+}
+
+TEST(vector, erase_destroys_tail) {
+  sgi::vector<std::shared_ptr<int>> vec;
+  auto value = std::make_shared<int>(1);
+  for (int i = 0; i < 10; i++) {
+    vec.push_back(value);
+  }
+  vec.erase(vec.begin(), vec.begin() + 4);
+  EXPECT_EQ(value.use_count(), 7);
+
+  sgi::vector<std::string> strs;
+  for (int i = 0; i < 10; i++) {
+    strs.push_back(std::string(50, 'a' + i));
+  }
+  strs.erase(strs.begin() + 2, strs.begin() + 5);
+  ASSERT_EQ(strs.size(), 7);
+  EXPECT_EQ(strs[1], std::string(50, 'b'));
+  EXPECT_EQ(strs[2], std::string(50, 'f'));
+  EXPECT_EQ(strs[6], std::string(50, 'j'));
+}
+
+TEST(vector, large_fill) {
+  // split across threads
+  size_t n = 3 * sgi::PARALLEL_MIN_BYTES / sizeof(int64_t) + 5;
+  sgi::vector<int64_t> vec(n, -1);
+  ASSERT_EQ(vec.size(), n);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(vec[i], -1);
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();